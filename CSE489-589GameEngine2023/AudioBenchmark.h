@@ -0,0 +1,124 @@
+#pragma once
+
+#include "GameEngine.h"
+
+/**
+ * @class	AudioBenchmark
+ *
+ * @brief	Scene that plays many looping sounds on objects circling the
+ * 			listener and reports the time spent mixing them. The audio is
+ * 			rendered offline to a file rather than to the audio device, so the
+ * 			benchmark runs the same on machines without sound hardware. The
+ * 			game is stepped with a fixed time step rather than the wall clock,
+ * 			so every run mixes the same samples and exactly one step of audio
+ * 			is mixed for each step of the game.
+ */
+class AudioBenchmark : public Game
+{
+public:
+
+	/**
+	 * @fn	AudioBenchmark::AudioBenchmark(int numSounds = 256, std::string outputFileName = "audio-benchmark.wav")
+	 *
+	 * @brief	Constructor
+	 *
+	 * @param	numSounds	  	(Optional) Number of looping sounds.
+	 * @param	outputFileName	(Optional) WAV file the mixed audio is written to.
+	 */
+	AudioBenchmark(int numSounds = 256, std::string outputFileName = "audio-benchmark.wav")
+		: numSounds(numSounds)
+	{
+		this->soundBackend = new OfflineSoundBackend(outputFileName, MIXING_FREQUENCY);
+	}
+
+protected:
+
+	/** @brief	Frequency the audio is mixed at. */
+	static const int MIXING_FREQUENCY = 44100;
+
+	/** @brief	Time step the scene and the mixer are advanced by each frame. */
+	static constexpr float FIXED_TIME_STEP = 1.0f / 60.0f;
+
+	/** @brief	Number of looping sounds in the scene. */
+	int numSounds;
+
+	/** @brief	Frames since the last report. */
+	int framesSinceReport = 0;
+
+	/** @brief	Render time and samples at the time of the last report. */
+	double lastRenderTime = 0.0;
+	long long lastRenderedSamples = 0;
+
+	void loadScene() override
+	{
+		glfwSetWindowTitle(renderWindow, "Audio Benchmark");
+
+		glClearColor(0.5f, 0.5f, 0.5f, 1.0f);
+
+		// ***** Sounds *****
+		// Spinning the parent moves every sound relative to the listener each frame
+		auto spinnerObject = std::make_shared<GameObject>();
+		addChildGameObject(spinnerObject);
+		spinnerObject->addComponent(std::make_shared<SpinComponent>(UNIT_Y_V3, 45.0f));
+
+		const int soundsPerRing = 32;
+		const float ringSpacing = 5.0f;
+
+		for (int i = 0; i < numSounds; i++) {
+
+			float angle = 2.0f * PI * (i % soundsPerRing) / soundsPerRing;
+			float radius = ringSpacing * (1 + i / soundsPerRing);
+
+			auto soundObject = std::make_shared<GameObject>();
+			spinnerObject->addChildGameObject(soundObject);
+			soundObject->setPosition(vec3(radius * cos(angle), 0.0f, radius * sin(angle)));
+
+			auto sound = std::make_shared<SoundSourceComponent>("Assets/bounce.wav");
+			soundObject->addComponent(sound);
+			sound->setLooping(true);
+			sound->play();
+		}
+
+		// ***** Listener *****
+		auto listenerObject = std::make_shared<GameObject>();
+		addChildGameObject(listenerObject);
+		listenerObject->addComponent(std::make_shared<CameraComponent>());
+		listenerObject->addComponent(std::make_shared<SoundListenerComponent>());
+
+		cout << "Audio benchmark: " << numSounds << " sounds, "
+			 << SoundEngine::GetNumVoices() << " voices" << endl;
+
+	} // end loadScene
+
+	void updateGame() override
+	{
+		// The same step every frame so the mix does not depend on the frame rate
+		stepGame(FIXED_TIME_STEP);
+
+		GameObject::UpdateSceneGraph();
+
+		// Report the time spent mixing every few seconds of audio
+		if (++framesSinceReport == 300) {
+
+			SoundBackend* backend = SoundEngine::GetBackend();
+
+			double renderTime = backend->getRenderTime();
+			long long renderedSamples = backend->getRenderedSamples();
+
+			double seconds = static_cast<double>(renderedSamples - lastRenderedSamples) / MIXING_FREQUENCY;
+
+			if (seconds > 0.0) {
+
+				cout << "Mixing: " << 1000.0 * (renderTime - lastRenderTime) / seconds
+					 << " ms per second of audio, " << framesSinceReport * FIXED_TIME_STEP
+					 << " s of game time" << endl;
+			}
+
+			lastRenderTime = renderTime;
+			lastRenderedSamples = renderedSamples;
+			framesSinceReport = 0;
+		}
+
+	} // end updateGame
+
+}; // end AudioBenchmark class
@@ -1,13 +1,68 @@
 #include "BuildShaderProgram.h"
 #include <cstdlib>
+#include <cstdint>
+#include <climits>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <filesystem>
 
 #define VERBOSE false
 
+// Directory that linked shader programs are saved in so later runs can skip compiling them
+#define SHADER_CACHE_DIRECTORY "ShaderCache"
+
+// Identifies shader cache files. Change the version when the file layout changes.
+#define SHADER_CACHE_MAGIC 0x53484243u
+#define SHADER_CACHE_VERSION 1u
+
 // Static variable definition. Holds all shader programs created usig
 // BuildShaderProgram. Allows all the shader programs to be 
 // deleted when the game ends.
 static std::vector<GLuint> shaderProgramsCreated;
 
+// What is needed to build the variants of a shader program and the
+// variants that have been built, keyed by their features.
+struct ShaderVariantSource
+{
+	std::vector<GLenum> types;
+	std::vector<std::string> filenames;
+	std::vector<std::string> defines;
+	std::unordered_map<unsigned int, GLuint> variants;
+};
+
+// Shader programs that have variants
+static std::unordered_map<GLuint, ShaderVariantSource> shaderVariantSources;
+
+// A shader program that has been handed to the driver to compile and link but
+// has not been checked yet. Kept until the program is first needed.
+struct PendingShaderProgram
+{
+	std::vector<GLuint> shaders;
+	uint64_t cacheKey = 0;
+	bool saveInCache = false;
+
+	// Set if the variants of the program can be built once it is finished
+	bool hasVariants = false;
+	ShaderVariantSource variantSource;
+};
+
+// Shader programs that are still being compiled and linked
+static std::unordered_map<GLuint, PendingShaderProgram> pendingShaderPrograms;
+
+// Start of each shader cache file. The program binary follows it.
+struct ProgramBinaryHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t key;
+	uint32_t format;
+	uint32_t length;
+};
+
 // Reads in the source code of a shader program.  
 const GLchar* ReadShader(const char* filename)
 {
@@ -41,22 +96,55 @@ const GLchar* ReadShader(const char* filename)
 } // end ReadShader
 
 
+// Places a #define directive for each definition after the #version directive
+// of a shader. A #line directive keeps the line numbers of the shader file.
+static std::string AddDefines(const GLchar* source, const std::vector<std::string>& defines)
+{
+	std::string text(source);
+
+	if (defines.empty()) {
+		return text;
+	}
+
+	size_t version = text.find("#version");
+	size_t insertAt = (version == std::string::npos) ? 0 : text.find('\n', version);
+	insertAt = (insertAt == std::string::npos) ? text.size() : insertAt + 1;
+
+	std::string directives;
+	for (const std::string& define : defines) {
+		directives += "#define " + define + "\n";
+	}
+
+	int nextLine = static_cast<int>(std::count(text.begin(), text.begin() + insertAt, '\n')) + 1;
+	directives += "#line " + std::to_string(nextLine) + "\n";
+
+	return text.insert(insertAt, directives);
+
+} // end AddDefines
+
+
 GLuint BuildShaderProgram(ShaderInfo* shaders)
 {
-	if (shaders == nullptr) { return 0; }
+	return BuildShaderProgram(shaders, std::vector<std::string>());
+
+} // end BuildShaderProgram
+
 
+// Hands the shaders of a program to the driver to compile and link. The
+// results are not checked, so a driver that compiles on threads of its own
+// can keep working while more programs are submitted.
+static GLuint SubmitProgram(ShaderInfo* shaders, const std::vector<std::string>& sources,
+	PendingShaderProgram& pending)
+{
 	// Creates an empty Shader Program object and returns an unsigned int by which
 	// it can be referenced. Shader objects will be attached to the program
 	// object.
 	GLuint program = glCreateProgram();
 
-	// Declare and array of structures to hold information particular shaders.
-	ShaderInfo* entry = shaders;
-
 	// Loop though all shaders specified in entry array until a GL_NONE
 	// is encountered in the type field. All shaders will be attached
 	// to the shader program.
-	while (entry->type != GL_NONE) {
+	for (ShaderInfo* entry = shaders; entry->type != GL_NONE; ++entry) {
 
 		// Creates an empty Shader object and returns an unsigned int by which
 		// it can be referenced.  A shader object is used to maintain the 
@@ -65,33 +153,245 @@ GLuint BuildShaderProgram(ShaderInfo* shaders)
 
 		// Store the int ID for the shader in a ShaderInfo structure
 		entry->shader = shader;
+		pending.shaders.push_back(shader);
 
-		// Read in the source code for a shader
-		const GLchar* source = ReadShader(entry->filename);
-		if (source == nullptr) {
-			for (entry = shaders; entry->type != GL_NONE; ++entry) {
+		// Associate the shader source code with the Shader object
+		const GLchar* source = sources[entry - shaders].c_str();
+		glShaderSource(shader, 1, &source, nullptr);
 
-				// Release the name (ID) that was allocated.
-				glDeleteShader(entry->shader);
-				entry->shader = 0;
-			}
+		// Start compiling the shader source code. Whether it compiled is
+		// checked when the program is finished.
+		glCompileShader(shader);
 
-			return 0;
+		// Associate the shader with the shader program.
+		// Shader functionality will not be available until it has be linked.
+		glAttachShader(program, shader);
+	}
+
+	// Allow the linked program to be saved in the shader cache
+	glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+	// Generates a complete shader program once the shaders are compiled. 
+	glLinkProgram(program);
+
+	return program;
+
+} // end SubmitProgram
+
+
+// Combines the bytes of some data into a 64 bit FNV-1a hash
+static uint64_t HashBytes(uint64_t hash, const void* data, size_t size)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+	for (size_t i = 0; i < size; i++) {
+
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+
+} // end HashBytes
+
+
+// Finds the key a program is saved under in the shader cache. Programs built
+// from different source code or by a different driver get different keys.
+static uint64_t ProgramCacheKey(ShaderInfo* shaders, const std::vector<std::string>& sources)
+{
+	uint64_t hash = 14695981039346656037ull;
+
+	const GLenum driverStrings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+
+	for (GLenum name : driverStrings) {
+
+		const GLubyte* driverString = glGetString(name);
+		if (driverString != nullptr) {
+			hash = HashBytes(hash, driverString, strlen(reinterpret_cast<const char*>(driverString)) + 1);
 		}
+	}
 
-		// Associate the shader source code with the Shader object
-		glShaderSource(shader, 1, &source, nullptr);
+	for (ShaderInfo* entry = shaders; entry->type != GL_NONE; ++entry) {
 
-		// Release the memory holding the character array into which
-		// the shader source was read
-		delete[] source;
+		const std::string& source = sources[entry - shaders];
 
-		// Complie the shader source code
-		glCompileShader(shader);
+		hash = HashBytes(hash, &entry->type, sizeof(entry->type));
+		hash = HashBytes(hash, source.c_str(), source.size() + 1);
+	}
+
+	return hash;
+
+} // end ProgramCacheKey
+
+
+// Gets the name of the shader cache file of a program
+static std::filesystem::path ProgramCachePath(uint64_t key)
+{
+	std::ostringstream name;
+	name << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+
+	return std::filesystem::path(SHADER_CACHE_DIRECTORY) / name.str();
+
+} // end ProgramCachePath
+
+
+// True if the driver can save and load program binaries
+static bool ProgramBinariesSupported()
+{
+	static GLint numFormats = -1;
+
+	if (numFormats < 0) {
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+	}
+
+	return numFormats > 0;
+
+} // end ProgramBinariesSupported
+
+
+// Loads a program from the shader cache. Returns zero if it is not in the
+// cache or the driver no longer accepts the saved binary.
+static GLuint LoadProgramBinary(uint64_t key)
+{
+	std::ifstream file(ProgramCachePath(key), std::ios::binary);
+
+	if (!file) {
+		return 0;
+	}
+
+	ProgramBinaryHeader header;
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+	if (!file || header.magic != SHADER_CACHE_MAGIC || header.version != SHADER_CACHE_VERSION || header.key != key) {
+		return 0;
+	}
+
+	// The length is read from disk. Check it against the rest of the file
+	// before allocating, so a damaged file is only a cache miss.
+	std::streampos binaryStart = file.tellg();
+	file.seekg(0, std::ios::end);
+	std::streamoff remaining = file.tellg() - binaryStart;
+	file.seekg(binaryStart);
+
+	if (!file || header.length == 0 || header.length > static_cast<uint64_t>(remaining)
+		|| header.length > static_cast<uint32_t>(INT_MAX)) {
+
+		if (VERBOSE) std::cout << "Cached shader program " << ProgramCachePath(key) << " is damaged." << std::endl;
+		return 0;
+	}
+
+	std::vector<char> binary(header.length);
+	file.read(binary.data(), header.length);
+
+	if (static_cast<uint64_t>(file.gcount()) != header.length) {
+		return 0;
+	}
+
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(header.length));
+
+	GLint linked;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+
+	if (!linked) {
+
+		if (VERBOSE) std::cout << "Cached shader program " << ProgramCachePath(key) << " was rejected." << std::endl;
+
+		glDeleteProgram(program);
+		return 0;
+	}
+
+	if (VERBOSE) std::cout << "Shader program " << program << " loaded from " << ProgramCachePath(key) << std::endl;
+
+	return program;
+
+} // end LoadProgramBinary
+
+
+// Saves a linked program in the shader cache
+static void SaveProgramBinary(GLuint program, uint64_t key)
+{
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+	if (length <= 0) {
+		return;
+	}
+
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(program, length, &length, &format, binary.data());
+
+	std::error_code error;
+	std::filesystem::create_directories(SHADER_CACHE_DIRECTORY, error);
+
+	std::ofstream file(ProgramCachePath(key), std::ios::binary | std::ios::trunc);
+
+	if (!file) {
+
+		if (VERBOSE) std::cout << "Unable to write " << ProgramCachePath(key) << std::endl;
+		return;
+	}
+
+	ProgramBinaryHeader header = { SHADER_CACHE_MAGIC, SHADER_CACHE_VERSION, key, format, static_cast<uint32_t>(length) };
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(binary.data(), length);
+
+} // end SaveProgramBinary
+
+
+// True if the driver can report whether a program has finished compiling and
+// linking without waiting for it. Lets the driver use as many compiler threads
+// as it likes the first time it is called.
+static bool ParallelCompileSupported()
+{
+	static int supported = -1;
+
+	if (supported < 0) {
+
+#ifdef GL_KHR_parallel_shader_compile
+		supported = GLEW_KHR_parallel_shader_compile ? 1 : 0;
+
+		if (supported) {
+			glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+		}
+#else
+		supported = 0;
+#endif
+		if (VERBOSE) std::cout << "Parallel shader compilation " << (supported ? "is" : "is not") << " supported." << std::endl;
+	}
+
+	return supported == 1;
+
+} // end ParallelCompileSupported
+
+
+// Keeps track of a program that has been built so it can be deleted later and
+// its variants can be built.
+static void RegisterProgram(GLuint program, bool hasVariants, ShaderVariantSource& variantSource)
+{
+	// Save a reference to the shader program so that is can
+	// later be deleted.
+	shaderProgramsCreated.push_back(program);
+
+	if (hasVariants) {
+		shaderVariantSources[program] = std::move(variantSource);
+	}
+
+} // end RegisterProgram
+
+
+// Checks whether a submitted program compiled and linked, waiting for the
+// driver if it has not finished. Returns zero and deletes the program if it
+// failed.
+static GLuint FinishProgram(GLuint program, PendingShaderProgram& pending)
+{
+	// Determine if the shaders compiled without errors.
+	// "complied" will be set to GL_TRUE if compile operation 
+	// is a success.
+	for (GLuint shader : pending.shaders) {
 
-		// Determine if the shader compiled without errors.
-		// "complied" will be set to GL_TRUE if compile operation 
-		// is a success.
 		GLint compiled;
 		glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
 		if (!compiled) {
@@ -103,24 +403,17 @@ GLuint BuildShaderProgram(ShaderInfo* shaders)
 			glGetShaderInfoLog(shader, len, &len, log);
 			std::cerr << "\nShader compilation failed: \n" << log << "\n" << std::endl;
 			delete[] log;
-			return 0;
-		}
-		else {
 
-			if (VERBOSE) std::cout << entry->filename << " successfully compiled. " << std::endl;
+			for (GLuint shaderToDelete : pending.shaders) {
+				glDeleteShader(shaderToDelete);
+			}
+			glDeleteProgram(program);
 
+			return 0;
 		}
-
-		// Associate the compiled shader with the shader program.
-		// Shader functionality will not be available until it has be linked.
-		glAttachShader(program, shader);
-
-		++entry;
 	}
 
-	// Generates a complete shader program. All required shader objects
-	// must be attached prior to linking.
-	glLinkProgram(program);
+	if (VERBOSE) std::cout << pending.shaders.size() << " shaders successfully compiled. " << std::endl;
 
 	// Determine if the shader program successfully linked.
 	// "linked" will be set to GL_TRUE if link is a success.
@@ -136,11 +429,10 @@ GLuint BuildShaderProgram(ShaderInfo* shaders)
 		std::cerr << "\nShader linking failed: \n" << log << "\n" << std::endl;
 		delete[] log;
 
-
-		for (entry = shaders; entry->type != GL_NONE; ++entry) {
-			glDeleteShader(entry->shader);
-			entry->shader = 0;
+		for (GLuint shader : pending.shaders) {
+			glDeleteShader(shader);
 		}
+		glDeleteProgram(program);
 
 		return 0;
 	}
@@ -150,42 +442,305 @@ GLuint BuildShaderProgram(ShaderInfo* shaders)
 
 	}
 	// Check whether the program can execute given the current pipeline state.
+	// Programs that are finished later, or built as variants while other
+	// programs and textures are bound, can fail validation and still work when
+	// they are used. Linking decides success, so failures are only reported.
 	glValidateProgram(program);
 	GLint valid;
 	glGetProgramiv(program, GL_VALIDATE_STATUS, &valid);
 	if (!valid) {
 
 		GLsizei len;
-		glGetProgramiv(program, GL_VALIDATE_STATUS, &len);
+		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &len);
 
 		GLchar* log = new GLchar[len + (__int64)1];
 		glGetProgramInfoLog(program, len, &len, log);
-		std::cerr << "." << std::endl << "Shader program is invalid: " << log << std::endl;
-
-		return 0;
+		std::cerr << "." << std::endl << "Shader program is invalid in the current state: " << log << std::endl;
+		delete[] log;
 	}
 	else {
 
 		if (VERBOSE) std::cout << " and is valid. " << std::endl << std::endl;
 	}
 
-	// Save a reference to the shader program so that is can
-	// later be deleted.
-	shaderProgramsCreated.push_back(program);
+	if (pending.saveInCache) {
+		SaveProgramBinary(program, pending.cacheKey);
+	}
+
+	RegisterProgram(program, pending.hasVariants, pending.variantSource);
+
+	return program;
+
+} // end FinishProgram
+
+
+GLuint BuildShaderProgramAsync(ShaderInfo* shaders, const std::vector<std::string>& defines)
+{
+	if (shaders == nullptr) { return 0; }
+
+	// Set if any of the shaders can be built as variants
+	bool hasVariants = false;
+
+	// Read in the source code for each shader
+	std::vector<std::string> sources;
+
+	for (ShaderInfo* entry = shaders; entry->type != GL_NONE; ++entry) {
+
+		entry->shader = 0;
+
+		const GLchar* source = ReadShader(entry->filename);
+		if (source == nullptr) {
+			return 0;
+		}
+
+		sources.push_back(AddDefines(source, defines));
+
+		hasVariants = hasVariants || sources.back().find("SHADER_VARIANT") != std::string::npos;
+
+		// Release the memory holding the character array into which
+		// the shader source was read
+		delete[] source;
+	}
+
+	// Remember the shaders of programs that have variants so the variants can
+	// be built later. Variants are built with SHADER_VARIANT already defined.
+	bool isVariant = std::find(defines.begin(), defines.end(), "SHADER_VARIANT") != defines.end();
+
+	PendingShaderProgram pending;
+	pending.hasVariants = hasVariants && !isVariant;
+
+	if (pending.hasVariants) {
+
+		pending.variantSource.defines = defines;
+
+		for (ShaderInfo* entry = shaders; entry->type != GL_NONE; ++entry) {
+
+			pending.variantSource.types.push_back(entry->type);
+			pending.variantSource.filenames.push_back(entry->filename);
+		}
+	}
+
+	// Programs that were linked on an earlier run by the same driver
+	// are loaded from the shader cache instead of being compiled.
+	pending.saveInCache = ProgramBinariesSupported();
+	pending.cacheKey = pending.saveInCache ? ProgramCacheKey(shaders, sources) : 0;
+
+	GLuint program = pending.saveInCache ? LoadProgramBinary(pending.cacheKey) : 0;
+
+	if (program != 0) {
+
+		RegisterProgram(program, pending.hasVariants, pending.variantSource);
+		return program;
+	}
+
+	// Start the driver's compiler threads before the first program is submitted
+	ParallelCompileSupported();
+
+	program = SubmitProgram(shaders, sources, pending);
+
+	pendingShaderPrograms[program] = std::move(pending);
 
 	return program;
 
+} // end BuildShaderProgramAsync
+
+
+GLuint BuildShaderProgram(ShaderInfo* shaders, const std::vector<std::string>& defines)
+{
+	return finishShaderProgram(BuildShaderProgramAsync(shaders, defines));
+
 } // end BuildShaderProgram
 
 
+bool isShaderProgramReady(GLuint shaderProgram)
+{
+	if (pendingShaderPrograms.find(shaderProgram) == pendingShaderPrograms.end()) {
+		return true;
+	}
+
+	// Without the extension asking about the program would wait for it, so it
+	// is reported as ready and finished the next time it is needed.
+	if (!ParallelCompileSupported()) {
+		return true;
+	}
+
+#ifdef GL_KHR_parallel_shader_compile
+	GLint completed = GL_FALSE;
+	glGetProgramiv(shaderProgram, GL_COMPLETION_STATUS_KHR, &completed);
+
+	return completed == GL_TRUE;
+#else
+	return true;
+#endif
+
+} // end isShaderProgramReady
+
+
+GLuint finishShaderProgram(GLuint shaderProgram)
+{
+	auto pendingIter = pendingShaderPrograms.find(shaderProgram);
+
+	if (pendingIter == pendingShaderPrograms.end()) {
+		return shaderProgram;
+	}
+
+	PendingShaderProgram pending = std::move(pendingIter->second);
+	pendingShaderPrograms.erase(pendingIter);
+
+	return FinishProgram(shaderProgram, pending);
+
+} // end finishShaderProgram
+
+
+// Binds the uniform and shader storage blocks of a variant to the binding
+// points of the same blocks in the program it was built from.
+static void CopyBlockBindings(GLuint fromProgram, GLuint toProgram)
+{
+	const GLenum blockInterfaces[] = { GL_UNIFORM_BLOCK, GL_SHADER_STORAGE_BLOCK };
+
+	for (GLenum blockInterface : blockInterfaces) {
+
+		GLint numBlocks = 0;
+		glGetProgramInterfaceiv(fromProgram, blockInterface, GL_ACTIVE_RESOURCES, &numBlocks);
+
+		for (GLint block = 0; block < numBlocks; block++) {
+
+			GLchar name[256];
+			glGetProgramResourceName(fromProgram, blockInterface, block, sizeof(name), nullptr, name);
+
+			const GLenum property = GL_BUFFER_BINDING;
+			GLint bindingPoint = 0;
+			glGetProgramResourceiv(fromProgram, blockInterface, block, 1, &property, 1, nullptr, &bindingPoint);
+
+			// The block may not be used by the variant
+			GLuint index = glGetProgramResourceIndex(toProgram, blockInterface, name);
+			if (index == GL_INVALID_INDEX) {
+				continue;
+			}
+
+			if (blockInterface == GL_UNIFORM_BLOCK) {
+				glUniformBlockBinding(toProgram, index, bindingPoint);
+			}
+			else {
+				glShaderStorageBlockBinding(toProgram, index, bindingPoint);
+			}
+		}
+	}
+
+} // end CopyBlockBindings
+
+
+GLuint getShaderVariant(GLuint shaderProgram, unsigned int features)
+{
+	// The program is needed now, so wait for it if it is still being built
+	shaderProgram = finishShaderProgram(shaderProgram);
+
+	auto sourceIter = shaderVariantSources.find(shaderProgram);
+
+	if (sourceIter == shaderVariantSources.end()) {
+		return shaderProgram;
+	}
+
+	ShaderVariantSource& variantSource = sourceIter->second;
+
+	auto variantIter = variantSource.variants.find(features);
+
+	if (variantIter != variantSource.variants.end()) {
+
+		GLuint variant = variantIter->second;
+
+		if (pendingShaderPrograms.find(variant) == pendingShaderPrograms.end()) {
+			return variant;
+		}
+
+		// Keep using the program that tests for the features until the
+		// driver has finished building the variant
+		if (!isShaderProgramReady(variant)) {
+			return shaderProgram;
+		}
+
+		variant = finishShaderProgram(variant);
+
+		if (variant == 0) {
+
+			std::cerr << "Shader variant " << features << " could not be built." << std::endl;
+			variant = shaderProgram;
+		}
+		else {
+
+			CopyBlockBindings(shaderProgram, variant);
+
+			if (VERBOSE) std::cout << "Built variant " << features << " of shader program " << shaderProgram << std::endl;
+		}
+
+		variantIter->second = variant;
+
+		return variant;
+	}
+
+	// Fix each feature with a preprocessor definition
+	std::vector<std::string> defines = variantSource.defines;
+	defines.push_back("SHADER_VARIANT");
+	defines.push_back(std::string("DIFFUSE_TEXTURE_ENABLED ") + ((features & SHADER_DIFFUSE_TEXTURE_BIT) ? "true" : "false"));
+	defines.push_back(std::string("SPECULAR_TEXTURE_ENABLED ") + ((features & SHADER_SPECULAR_TEXTURE_BIT) ? "true" : "false"));
+	defines.push_back(std::string("NORMAL_MAP_ENABLED ") + ((features & SHADER_NORMAL_MAP_BIT) ? "true" : "false"));
+	defines.push_back("TEXTURE_MODE " + std::to_string((features >> SHADER_TEXTURE_MODE_SHIFT) & 0x3));
+	defines.push_back("FOG_MODE " + std::to_string((features >> SHADER_FOG_MODE_SHIFT) & 0x3));
+
+	std::vector<ShaderInfo> shaders;
+	for (size_t i = 0; i < variantSource.types.size(); i++) {
+		shaders.push_back({ variantSource.types[i], variantSource.filenames[i].c_str(), 0 });
+	}
+	shaders.push_back({ GL_NONE, NULL, 0 });
+
+	// The variant is built in the background. Until it is ready the program
+	// that tests for the features is used in its place.
+	GLuint variant = BuildShaderProgramAsync(shaders.data(), defines);
+
+	if (variant == 0) {
+
+		std::cerr << "Shader variant " << features << " could not be built." << std::endl;
+		variantSource.variants[features] = shaderProgram;
+
+		return shaderProgram;
+	}
+
+	variantSource.variants[features] = variant;
+
+	// Variants loaded from the shader cache are ready right away
+	if (pendingShaderPrograms.find(variant) == pendingShaderPrograms.end()) {
+
+		CopyBlockBindings(shaderProgram, variant);
+		return variant;
+	}
+
+	return getShaderVariant(shaderProgram, features);
+
+} // end getShaderVariant
+
+
 void deleteAllShaderPrograms()
 {
+	for (auto& pendingProgram : pendingShaderPrograms) {
+
+		for (GLuint shader : pendingProgram.second.shaders) {
+			glDeleteShader(shader);
+		}
+
+		glDeleteProgram(pendingProgram.first);
+	}
+
+	pendingShaderPrograms.clear();
+
 	for (auto& shaderProgram : shaderProgramsCreated) {
 
 		glDeleteProgram(shaderProgram);
 
 	}
 
+	shaderProgramsCreated.clear();
+	shaderVariantSources.clear();
+
 } // end deleteAllShaderPrograms
 
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <string>
+
 #include "MathLibsConstsFuncs.h"
 
 using namespace constants_and_types;
@@ -30,14 +32,117 @@ typedef struct {
  * 					names of the shaders that will be used to 
  * 					build the shader program.
  *
+ * 			Linked programs are saved in the ShaderCache directory. Later
+ * 			builds of the same source code with the same graphics driver load
+ * 			the saved program instead of compiling and linking it again. The
+ * 			shaders are compiled as usual if the driver rejects a saved program.
+ *
  * @returns	A GLuint.
  */
 GLuint BuildShaderProgram(ShaderInfo* shaders);
 
+/**
+ * @fn	GLuint BuildShaderProgram(ShaderInfo* shaders, const std::vector<std::string>& defines);
+ *
+ * @brief	Builds a shader program with preprocessor definitions added to the
+ * 			source code of every shader. Each definition is placed on a line
+ * 			of its own after the #version directive, so "FOG_MODE 2" becomes
+ * 			"#define FOG_MODE 2". Line numbers in compiler errors still match
+ * 			the shader files.
+ *
+ * @param [in,out]	shaders	Array containing the names of the shaders.
+ * @param 		  	defines	The definitions.
+ *
+ * @returns	The shader program or zero if it could not be built.
+ */
+GLuint BuildShaderProgram(ShaderInfo* shaders, const std::vector<std::string>& defines);
+
+/**
+ * @fn	GLuint BuildShaderProgramAsync(ShaderInfo* shaders, const std::vector<std::string>& defines = std::vector<std::string>());
+ *
+ * @brief	Starts building a shader program without waiting for the driver to
+ * 			compile and link it. Submitting every program before using any of
+ * 			them lets a driver that supports GL_KHR_parallel_shader_compile
+ * 			build them at the same time on its own threads. Programs found in
+ * 			the shader cache are ready right away.
+ *
+ * 			The program must be passed to finishShaderProgram before it is
+ * 			used. isShaderProgramReady tells whether that will have to wait.
+ *
+ * @param [in,out]	shaders	Array containing the names of the shaders.
+ * @param 		  	defines	(Optional) Preprocessor definitions, as for BuildShaderProgram.
+ *
+ * @returns	The shader program or zero if a shader file could not be read.
+ */
+GLuint BuildShaderProgramAsync(ShaderInfo* shaders, const std::vector<std::string>& defines = std::vector<std::string>());
+
+/**
+ * @fn	bool isShaderProgramReady(GLuint shaderProgram);
+ *
+ * @brief	Checks whether the driver has finished building a shader program
+ * 			without waiting for it. Always true for programs that are finished
+ * 			and when the driver cannot tell without waiting.
+ *
+ * @param	shaderProgram	A shader program returned by BuildShaderProgramAsync.
+ *
+ * @returns	True if finishShaderProgram will not have to wait.
+ */
+bool isShaderProgramReady(GLuint shaderProgram);
+
+/**
+ * @fn	GLuint finishShaderProgram(GLuint shaderProgram);
+ *
+ * @brief	Waits for a shader program started by BuildShaderProgramAsync and
+ * 			checks whether it compiled and linked. Does nothing to a program
+ * 			that is already finished.
+ *
+ * @param	shaderProgram	The shader program.
+ *
+ * @returns	The shader program or zero if it could not be built. Programs that
+ * 			could not be built are deleted.
+ */
+GLuint finishShaderProgram(GLuint shaderProgram);
+
+// Features of a shader program that can be fixed when a variant of it is built.
+// The diffuse, specular, and normal map bits are single flags. The texture mode
+// and the fog mode are two bit numbers starting at their shifts.
+#define SHADER_DIFFUSE_TEXTURE_BIT 0x01
+#define SHADER_SPECULAR_TEXTURE_BIT 0x02
+#define SHADER_NORMAL_MAP_BIT 0x04
+#define SHADER_TEXTURE_MODE_SHIFT 3
+#define SHADER_FOG_MODE_SHIFT 5
+
+/**
+ * @fn	GLuint getShaderVariant(GLuint shaderProgram, unsigned int features);
+ *
+ * @brief	Gets the variant of a shader program that has a set of features
+ * 			fixed at compile time instead of testing for them each time a
+ * 			shader runs. The variant is started the first time it is asked for
+ * 			and kept for later calls. The shader program itself is returned in
+ * 			its place until the driver has finished building it. A shader
+ * 			program that is still being built is finished first.
+ *
+ * 			Only programs whose shaders test whether SHADER_VARIANT is defined
+ * 			have variants. Their variants are built with SHADER_VARIANT and
+ * 			DIFFUSE_TEXTURE_ENABLED, SPECULAR_TEXTURE_ENABLED,
+ * 			NORMAL_MAP_ENABLED, TEXTURE_MODE, and FOG_MODE defined to the
+ * 			values in the features. Uniform and shader storage blocks are bound
+ * 			to the same binding points as in the original program.
+ *
+ * @param	shaderProgram	A shader program returned by BuildShaderProgram or BuildShaderProgramAsync.
+ * @param	features	 	Bitwise or of the SHADER_*_BIT flags and the modes
+ * 							shifted by SHADER_TEXTURE_MODE_SHIFT and SHADER_FOG_MODE_SHIFT.
+ *
+ * @returns	The variant. The shader program itself if it has no variants or
+ * 			the variant could not be built or is not ready.
+ */
+GLuint getShaderVariant(GLuint shaderProgram, unsigned int features);
+
 /**
  * @fn	void deleteAllShaderPrograms();
  *
  * @brief	Deletes all shader programs that were created
- * 			by calls to BuildShaderProgram.
+ * 			by calls to BuildShaderProgram, including their variants
+ * 			and programs that are still being built.
  */
 void deleteAllShaderPrograms();
@@ -1,5 +1,6 @@
 #include "CameraComponent.h"
 #include "SharedTransformations.h"
+#include "SharedLighting.h"
 
 #define VERBOSE false
 
@@ -42,13 +43,40 @@ void CameraComponent::setCameraTransformations() {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glDisable(GL_SCISSOR_TEST);
 
-    mat4 perspectProjection = glm::perspective(PI / 6.0f, (float)dimensions.x / dimensions.y, 1.0f, 1000.f);
+    mat4 perspectProjection = getProjectionMatrix();
     SharedTransformations::setProjectionMatrix(perspectProjection);
 
+    mat4 viewMatrix = getViewMatrix();
+    SharedTransformations::setViewMatrix(viewMatrix);
+
+    // Shadow cascades are fit to the cameras in the order they are rendered
+    const std::vector<std::shared_ptr<CameraComponent>> cameras = GetActiveCameras();
+    int cameraIndex = static_cast<int>(std::find_if(cameras.begin(), cameras.end(),
+        [this](const std::shared_ptr<CameraComponent>& camera) { return camera.get() == this; }) - cameras.begin());
+
+    // Assign lights to the clusters of this camera's view volume
+    SharedLighting::cullLights(viewMatrix, perspectProjection,
+        glm::ivec4(static_cast<GLint>(xLowerLeft * dimensions.x),
+            static_cast<GLint>(yLowerLeft * dimensions.y),
+            static_cast<GLint>(viewPortWidth * dimensions.x),
+            static_cast<GLint>(viewPortHeight * dimensions.y)),
+        cameraIndex);
+
+}
+
+mat4 CameraComponent::getViewMatrix() {
+    if (!owningGameObject) return mat4(1.0f);
+
     // Get the modeling transformation of the owning game object
     mat4 modelingTrans = owningGameObject->getModelingTransformation();
-    SharedTransformations::setViewMatrix(glm::inverse(modelingTrans));
+    return glm::inverse(modelingTrans);
+}
 
+mat4 CameraComponent::getProjectionMatrix() {
+    if (!owningGameObject) return mat4(1.0f);
+
+    glm::ivec2 dimensions = owningGameObject->getOwningGame()->getWindowDimensions();
+    return glm::perspective(PI / 6.0f, (float)dimensions.x / dimensions.y, 1.0f, 1000.f);
 }
 
 void CameraComponent::setViewPort(GLfloat xLowerLeft, GLfloat yLowerLeft, GLfloat viewPortWidth, GLfloat viewPortHeight) {
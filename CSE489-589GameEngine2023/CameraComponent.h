@@ -41,6 +41,7 @@ public:
 	 *				SceneGraphNode::getModelingTransformation
 	 *				SharedTransformations::setViewMatrix
 	 * 				SharedTransformations::setProjectionMatrix
+	 * 				SharedLighting::cullLights
 	 * 			Called by:
 	 * 				Game::renderScene
 	 *
@@ -48,6 +49,21 @@ public:
 	 */
 	void setCameraTransformations();
 
+	/**
+	 * @fn	mat4 CameraComponent::getViewMatrix();
+	 *
+	 * @brief	Gets the viewing transformation of the camera. The inverse of the
+	 * 			modeling transformation of the GameObject that holds it.
+	 */
+	mat4 getViewMatrix();
+
+	/**
+	 * @fn	mat4 CameraComponent::getProjectionMatrix();
+	 *
+	 * @brief	Gets the perspective projection the camera renders with.
+	 */
+	mat4 getProjectionMatrix();
+
 	/**
 	 * @fn	void CameraComponent::setViewPort( GLfloat xLowerLeft, GLfloat yLowerLeft,
 	 * 										   GLfloat viewPortWidth, GLfloat viewPortHeight);
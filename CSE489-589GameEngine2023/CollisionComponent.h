@@ -7,28 +7,31 @@ class CollisionComponent :
     public Component
 {
 public:
-	CollisionComponent() : Component(100) {}
+	CollisionComponent() : Component(100) 
+	{
+		listenForCollisions(COLLISION_ALL);
+	}
 
-	virtual void collisionEnter(const class RigidBodyComponent* collisionData)
+	virtual void collisionEnter(const struct CollisionEvent& collision)
 	{
-		if (collisionData->owningGameObject->gameObjectName == "projectile") {
+		if (collision.other->owningGameObject->gameObjectName == "projectile") {
 
 			if (VERBOSE) cout << "HIT BY PROJECTILE - " << owningGameObject->gameObjectName << endl;
 
 			owningGameObject->removeAndDelete();
-			collisionData->owningGameObject->removeAndDelete();
+			collision.other->owningGameObject->removeAndDelete();
 		}
 	
 		if(VERBOSE) cout << "collision enter " << owningGameObject->gameObjectName << endl;
 
 	};
 
-	virtual void collisionStay(const class RigidBodyComponent* collisionData)
+	virtual void collisionStay(const struct CollisionEvent& collision)
 	{ 
 		if (VERBOSE) cout << "collision stay " << owningGameObject->gameObjectName << endl;
 	};
 
-	virtual void collisionExit(const class RigidBodyComponent* collisionData)
+	virtual void collisionExit(const struct CollisionEvent& collision)
 	{ 
 		if (VERBOSE) cout << "collision exit " << owningGameObject->gameObjectName << endl;
 		//owningGameObject->removeAndDelete();
@@ -0,0 +1,107 @@
+#include "CollisionLayers.h"
+
+#define VERBOSE false
+
+// Every layer interacts with every other layer until the game says otherwise
+static const unsigned int ALL_LAYERS_MASK = (1u << CollisionLayers::MAX_LAYERS) - 1u;
+
+std::vector<std::string> CollisionLayers::layerNames = { "Default" };
+
+unsigned int CollisionLayers::interactions[MAX_LAYERS] = { ALL_LAYERS_MASK };
+
+int CollisionLayers::AddLayer(const std::string& name)
+{
+	int layer = GetLayer(name);
+
+	if (layer >= 0) {
+		return layer;
+	}
+
+	if (static_cast<int>(layerNames.size()) == MAX_LAYERS) {
+
+		cout << "ERROR: Unable to add collision layer " << name << ". All layers are in use." << endl;
+		return -1;
+	}
+
+	layer = static_cast<int>(layerNames.size());
+	layerNames.push_back(name);
+
+	// The new layer interacts with every layer
+	interactions[layer] = ALL_LAYERS_MASK;
+	for (int i = 0; i < layer; i++) {
+		interactions[i] |= 1u << layer;
+	}
+
+	if (VERBOSE) cout << "Collision layer " << name << " added as layer " << layer << endl;
+
+	return layer;
+
+} // end AddLayer
+
+
+int CollisionLayers::GetLayer(const std::string& name)
+{
+	for (int i = 0; i < static_cast<int>(layerNames.size()); i++) {
+
+		if (layerNames[i] == name) {
+			return i;
+		}
+	}
+
+	return -1;
+
+} // end GetLayer
+
+
+const std::string& CollisionLayers::GetLayerName(int layer)
+{
+	return layerNames[layer];
+
+} // end GetLayerName
+
+
+void CollisionLayers::SetLayersInteract(int layerA, int layerB, bool interact)
+{
+	if (interact) {
+
+		interactions[layerA] |= 1u << layerB;
+		interactions[layerB] |= 1u << layerA;
+	}
+	else {
+
+		interactions[layerA] &= ~(1u << layerB);
+		interactions[layerB] &= ~(1u << layerA);
+	}
+
+} // end SetLayersInteract
+
+
+bool CollisionLayers::LayersInteract(int layerA, int layerB)
+{
+	return (interactions[layerA] & (1u << layerB)) != 0;
+
+} // end LayersInteract
+
+
+int CollisionLayers::GetFilterGroup(int layer, DynamicsState state)
+{
+	int group = 1 << layer;
+
+	if (state == STATIONARY) {
+		group |= STATIONARY_GROUP;
+	}
+
+	return group;
+
+} // end GetFilterGroup
+
+
+int CollisionLayers::GetFilterMask(int layer, DynamicsState state)
+{
+	// Kinematic bodies pair with stationary bodies directly because the
+	// mask replaces the filter Bullet uses to keep them apart. Pairs of
+	// stationary bodies are rejected by the overlap filter of the physics
+	// engine using STATIONARY_GROUP.
+	return static_cast<int>(interactions[layer]);
+
+} // end GetFilterMask
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "MathLibsConstsFuncs.h"
+
+using namespace constants_and_types;
+
+/**
+ * @class	CollisionLayers
+ *
+ * @brief	Named collision layers and the matrix that determines which layers
+ * 			interact. Each rigid body belongs to one layer. The layer is passed to
+ * 			Bullet as a collision filter group and the row of the matrix as the
+ * 			collision filter mask, so the broadphase never generates pairs for
+ * 			layers that do not interact. The matrix should be set up before rigid
+ * 			bodies are added to the game.
+ */
+class CollisionLayers
+{
+public:
+
+	/** @brief	Number of layers available to the game. The remaining filter bits are used by the engine. */
+	static const int MAX_LAYERS = 30;
+
+	/** @brief	Layer that rigid bodies belong to unless another is set. */
+	static const int DEFAULT_LAYER = 0;
+
+	/** @brief	Filter group bit shared by all STATIONARY rigid bodies. The physics engine's
+	 * 			overlap filter never pairs two bodies that both have it. */
+	static const int STATIONARY_GROUP = 1 << 30;
+
+	/**
+	 * @fn	static int CollisionLayers::AddLayer(const std::string& name);
+	 *
+	 * @brief	Adds a named layer. A new layer interacts with every layer.
+	 *
+	 * @param	name	The name of the layer.
+	 *
+	 * @returns	The index of the layer. The existing index is returned if the name is
+	 * 			already in use. -1 if all of the layers are in use.
+	 */
+	static int AddLayer(const std::string& name);
+
+	/**
+	 * @fn	static int CollisionLayers::GetLayer(const std::string& name);
+	 *
+	 * @brief	Gets the index of a named layer.
+	 *
+	 * @param	name	The name of the layer.
+	 *
+	 * @returns	The index of the layer or -1 if there is no layer with the name.
+	 */
+	static int GetLayer(const std::string& name);
+
+	/**
+	 * @fn	static const std::string& CollisionLayers::GetLayerName(int layer);
+	 *
+	 * @brief	Gets the name of a layer.
+	 *
+	 * @param	layer	The index of the layer.
+	 *
+	 * @returns	The name of the layer.
+	 */
+	static const std::string& GetLayerName(int layer);
+
+	/**
+	 * @fn	static void CollisionLayers::SetLayersInteract(int layerA, int layerB, bool interact);
+	 *
+	 * @brief	Sets whether rigid bodies in two layers collide with each other.
+	 *
+	 * @param	layerA  	The first layer.
+	 * @param	layerB  	The second layer. May be the same as the first.
+	 * @param	interact	True if the layers collide.
+	 */
+	static void SetLayersInteract(int layerA, int layerB, bool interact);
+
+	/**
+	 * @fn	static bool CollisionLayers::LayersInteract(int layerA, int layerB);
+	 *
+	 * @brief	Checks whether rigid bodies in two layers collide with each other.
+	 *
+	 * @returns	True if the layers collide.
+	 */
+	static bool LayersInteract(int layerA, int layerB);
+
+	/**
+	 * @fn	static int CollisionLayers::GetFilterGroup(int layer, DynamicsState state);
+	 *
+	 * @brief	Gets the Bullet collision filter group of a rigid body.
+	 *
+	 * @param	layer	The layer of the rigid body.
+	 * @param	state	The dynamics state of the rigid body.
+	 *
+	 * @returns	The collision filter group.
+	 */
+	static int GetFilterGroup(int layer, DynamicsState state);
+
+	/**
+	 * @fn	static int CollisionLayers::GetFilterMask(int layer, DynamicsState state);
+	 *
+	 * @brief	Gets the Bullet collision filter mask of a rigid body.
+	 *
+	 * @param	layer	The layer of the rigid body.
+	 * @param	state	The dynamics state of the rigid body.
+	 *
+	 * @returns	The collision filter mask.
+	 */
+	static int GetFilterMask(int layer, DynamicsState state);
+
+protected:
+
+	/** @brief	Names of the layers that have been added. */
+	static std::vector<std::string> layerNames;
+
+	/** @brief	Row of the interaction matrix for each layer. Bit j of row i is set if layers i and j interact. */
+	static unsigned int interactions[MAX_LAYERS];
+
+}; // end CollisionLayers class
@@ -13,6 +13,13 @@ using namespace constants_and_types;
 enum COMPONENT_TYPE { COMPONENT = 0, MESH, COLLISION, CAMERA, LIGHT, 
 					  SKYBOX, BILLBOARD, PARTICLE_SYSTEM, RIGID_BODY, MOVE  };
 
+// Bit flags for the types of collision events a Component listens for
+enum COLLISION_EVENT_TYPE { COLLISION_ENTER = 1, COLLISION_STAY = 2, COLLISION_EXIT = 4,
+							COLLISION_ALL = COLLISION_ENTER | COLLISION_STAY | COLLISION_EXIT };
+
+// Collision layer filter that accepts collisions with every layer
+const unsigned int ALL_COLLISION_LAYERS = 0xFFFFFFFF;
+
 class Component : public std::enable_shared_from_this<Component>
 {
 public:
@@ -111,17 +118,47 @@ public:
 	//std::shared_ptr<class GameObject> owningGameObject;
 	class GameObject* owningGameObject;
 
-	virtual void collisionEnter(const class RigidBodyComponent* collisionData) 
+	/**
+	 * @fn	void Component::listenForCollisions(int eventTypes, unsigned int layerFilter = ALL_COLLISION_LAYERS)
+	 *
+	 * @brief	Registers interest in collision events. Only components that have
+	 * 			registered interest have their collision methods called. Must be
+	 * 			called before the component is added to a GameObject, typically in
+	 * 			the constructor.
+	 *
+	 * @param 	eventTypes 	COLLISION_EVENT_TYPE flags combined with bitwise or.
+	 * @param 	layerFilter	(Optional) Bit mask of the collision layers of the other
+	 * 						rigid body for which events will be received.
+	 */
+	void listenForCollisions(int eventTypes, unsigned int layerFilter = ALL_COLLISION_LAYERS)
+	{
+		collisionEventTypes = eventTypes;
+		collisionLayerFilter = layerFilter;
+	}
+
+	/** @brief	Gets the COLLISION_EVENT_TYPE flags this component listens for. */
+	int getCollisionEventTypes() const { return collisionEventTypes; }
+
+	/** @brief	Gets the bit mask of collision layers this component listens for. */
+	unsigned int getCollisionLayerFilter() const { return collisionLayerFilter; }
+
+	virtual void collisionEnter(const struct CollisionEvent& collision) 
 	{ /*cout << "collision enter" << endl; */ };
 
-	virtual void collisionStay(const class RigidBodyComponent* collisionData) 
+	virtual void collisionStay(const struct CollisionEvent& collision) 
 	{ /*cout << "collision stay" << endl; */};
 
-	virtual void collisionExit(const class RigidBodyComponent* collisionData) 
+	virtual void collisionExit(const struct CollisionEvent& collision) 
 	{ /*cout << "collision exit" << endl;*/ };
 
 protected:
 
+	/** @brief	COLLISION_EVENT_TYPE flags for the collision events this component listens for. */
+	int collisionEventTypes = 0;
+
+	/** @brief	Bit mask of the collision layers of other rigid bodies this component listens for. */
+	unsigned int collisionLayerFilter = ALL_COLLISION_LAYERS;
+
 	// Data member specifying specialized Component type
 	COMPONENT_TYPE componentType = COMPONENT;
 
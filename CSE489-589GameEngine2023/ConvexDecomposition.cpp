@@ -0,0 +1,297 @@
+#include "ConvexDecomposition.h"
+
+#include <algorithm>
+
+#include "Bullet/LinearMath/btConvexHullComputer.h"
+
+#define VERBOSE false
+
+std::string ConvexDecompositionSettings::getKey() const
+{
+	return "acd " + std::to_string(maxHulls) + " " + std::to_string(maxConcavity)
+		+ " " + std::to_string(maxVerticesPerHull) + " " + std::to_string(minTrianglesPerHull);
+
+} // end getKey
+
+
+btCompoundShape* ConvexDecomposition::Decompose(const std::vector<vec3>& positions, const std::vector<unsigned int>& indices,
+												const ConvexDecompositionSettings& settings)
+{
+	int numTriangles = static_cast<int>(indices.size() / 3);
+
+	if (numTriangles == 0 || positions.size() == 0) {
+		return nullptr;
+	}
+
+	// Concavity threshold is relative to the size of the whole mesh
+	vec3 minCorner = positions[0];
+	vec3 maxCorner = positions[0];
+	for (const vec3& p : positions) {
+		minCorner = glm::min(minCorner, p);
+		maxCorner = glm::max(maxCorner, p);
+	}
+	float concavityThreshold = settings.maxConcavity * glm::length(maxCorner - minCorner);
+
+	// Start with a single piece containing every triangle
+	std::vector<Piece> pieces(1);
+	pieces[0].triangles.resize(numTriangles);
+	for (int t = 0; t < numTriangles; t++) {
+		pieces[0].triangles[t] = t;
+	}
+	buildHull(pieces[0], positions, indices, settings.maxConcavitySamples, true);
+
+	while (static_cast<int>(pieces.size()) < settings.maxHulls) {
+
+		// Find the most concave piece that is still worth splitting
+		int worst = -1;
+		for (int i = 0; i < static_cast<int>(pieces.size()); i++) {
+
+			if (pieces[i].concavity > concavityThreshold &&
+				static_cast<int>(pieces[i].triangles.size()) >= 2 * settings.minTrianglesPerHull &&
+				(worst < 0 || pieces[i].concavity > pieces[worst].concavity)) {
+
+				worst = i;
+			}
+		}
+
+		if (worst < 0) {
+			break;
+		}
+
+		const Piece& piece = pieces[worst];
+
+		// Centroids of the triangles in the piece decide which side of a plane they fall on
+		std::vector<vec3> centroids(piece.triangles.size());
+		vec3 minCentroid(POS_INFINITY);
+		vec3 maxCentroid(NEG_INFINITY);
+		for (size_t i = 0; i < piece.triangles.size(); i++) {
+
+			int t = piece.triangles[i];
+			centroids[i] = (positions[indices[3 * t]] + positions[indices[3 * t + 1]] + positions[indices[3 * t + 2]]) / 3.0f;
+			minCentroid = glm::min(minCentroid, centroids[i]);
+			maxCentroid = glm::max(maxCentroid, centroids[i]);
+		}
+
+		// Try planes at a quarter, half, and three quarters along each axis. Keep
+		// the split whose two hulls have the smallest combined volume.
+		Piece bestA, bestB;
+		float bestVolume = POS_INFINITY;
+
+		for (int axis = 0; axis < 3; axis++) {
+
+			if (maxCentroid[axis] - minCentroid[axis] <= 0.0f) {
+				continue;
+			}
+
+			for (float fraction : { 0.25f, 0.5f, 0.75f }) {
+
+				float split = minCentroid[axis] + fraction * (maxCentroid[axis] - minCentroid[axis]);
+
+				Piece a, b;
+				for (size_t i = 0; i < piece.triangles.size(); i++) {
+
+					if (centroids[i][axis] < split) {
+						a.triangles.push_back(piece.triangles[i]);
+					}
+					else {
+						b.triangles.push_back(piece.triangles[i]);
+					}
+				}
+
+				if (static_cast<int>(a.triangles.size()) < settings.minTrianglesPerHull ||
+					static_cast<int>(b.triangles.size()) < settings.minTrianglesPerHull) {
+					continue;
+				}
+
+				buildHull(a, positions, indices, settings.maxConcavitySamples, false);
+				buildHull(b, positions, indices, settings.maxConcavitySamples, false);
+
+				if (a.hullVolume + b.hullVolume < bestVolume) {
+
+					bestVolume = a.hullVolume + b.hullVolume;
+					bestA = std::move(a);
+					bestB = std::move(b);
+				}
+			}
+		}
+
+		if (bestVolume == POS_INFINITY) {
+
+			// No acceptable plane. Leave this piece as it is.
+			pieces[worst].concavity = 0.0f;
+			continue;
+		}
+
+		buildHull(bestA, positions, indices, settings.maxConcavitySamples, true);
+		buildHull(bestB, positions, indices, settings.maxConcavitySamples, true);
+
+		pieces[worst] = std::move(bestA);
+		pieces.push_back(std::move(bestB));
+	}
+
+	if (VERBOSE) cout << "Convex decomposition produced " << pieces.size() << " pieces from "
+					  << numTriangles << " triangles." << endl;
+
+	btCompoundShape* compoundShape = new btCompoundShape();
+
+	for (const Piece& piece : pieces) {
+
+		if (piece.hullVertices.size() > 0) {
+
+			// Do NOT use the default btTransform constructor for this! It
+			// makes a zero matrix.
+			compoundShape->addChildShape(btTransform::getIdentity(), createHullShape(piece, settings.maxVerticesPerHull));
+		}
+	}
+
+	return compoundShape;
+
+} // end Decompose
+
+
+void ConvexDecomposition::buildHull(Piece& piece, const std::vector<vec3>& positions, const std::vector<unsigned int>& indices,
+									int maxSamples, bool measureConcavity)
+{
+	// Unique vertices referenced by the triangles of the piece
+	std::vector<unsigned int> vertexIndices;
+	vertexIndices.reserve(piece.triangles.size() * 3);
+	for (int t : piece.triangles) {
+		vertexIndices.push_back(indices[3 * t]);
+		vertexIndices.push_back(indices[3 * t + 1]);
+		vertexIndices.push_back(indices[3 * t + 2]);
+	}
+	std::sort(vertexIndices.begin(), vertexIndices.end());
+	vertexIndices.erase(std::unique(vertexIndices.begin(), vertexIndices.end()), vertexIndices.end());
+
+	std::vector<vec3> points(vertexIndices.size());
+	for (size_t i = 0; i < vertexIndices.size(); i++) {
+		points[i] = positions[vertexIndices[i]];
+	}
+
+	piece.hullVertices.clear();
+	piece.hullVolume = 0.0f;
+	piece.concavity = 0.0f;
+
+	btConvexHullComputer computer;
+	if (points.size() < 4 ||
+		computer.compute(&points[0].x, sizeof(vec3), static_cast<int>(points.size()), 0.0f, 0.0f) < 0.0f ||
+		computer.vertices.size() < 4) {
+
+		// Flat or degenerate piece. Keep the points as they are.
+		piece.hullVertices = points;
+		return;
+	}
+
+	vec3 center(0.0f);
+	for (int i = 0; i < computer.vertices.size(); i++) {
+
+		const btVector3& v = computer.vertices[i];
+		piece.hullVertices.push_back(vec3(v.x(), v.y(), v.z()));
+		center += piece.hullVertices.back();
+	}
+	center /= static_cast<float>(piece.hullVertices.size());
+
+	// Outward facing plane for each face of the hull. The volume is
+	// accumulated from a fan of tetrahedra about the center of the hull.
+	std::vector<vec4> planes;
+	planes.reserve(computer.faces.size());
+
+	for (int f = 0; f < computer.faces.size(); f++) {
+
+		const btConvexHullComputer::Edge* firstEdge = &computer.edges[computer.faces[f]];
+		const btConvexHullComputer::Edge* edge = firstEdge->getNextEdgeOfFace();
+
+		vec3 a = piece.hullVertices[firstEdge->getSourceVertex()];
+		vec3 normal(0.0f);
+
+		while (edge != firstEdge) {
+
+			vec3 b = piece.hullVertices[edge->getSourceVertex()];
+			vec3 c = piece.hullVertices[edge->getTargetVertex()];
+
+			vec3 cross = glm::cross(b - a, c - a);
+			normal += cross;
+			piece.hullVolume += fabs(glm::dot(a - center, cross)) / 6.0f;
+
+			edge = edge->getNextEdgeOfFace();
+		}
+
+		if (glm::length(normal) > 0.0f) {
+
+			normal = glm::normalize(normal);
+			if (glm::dot(normal, a - center) < 0.0f) {
+				normal = -normal;
+			}
+			planes.push_back(vec4(normal, -glm::dot(normal, a)));
+		}
+	}
+
+	if (measureConcavity && planes.size() > 0) {
+
+		// Depth of a point inside the hull is its distance to the closest face
+		size_t stride = std::max<size_t>(1, points.size() / std::max(1, maxSamples));
+
+		for (size_t i = 0; i < points.size(); i += stride) {
+
+			float depth = POS_INFINITY;
+			for (const vec4& plane : planes) {
+				depth = glm::min(depth, -(glm::dot(vec3(plane), points[i]) + plane.w));
+			}
+			piece.concavity = glm::max(piece.concavity, depth);
+		}
+	}
+
+} // end buildHull
+
+
+btConvexHullShape* ConvexDecomposition::createHullShape(const Piece& piece, int maxVertices)
+{
+	const std::vector<vec3>& vertices = piece.hullVertices;
+
+	if (maxVertices <= 0 || static_cast<int>(vertices.size()) <= maxVertices) {
+
+		return new btConvexHullShape(&vertices[0].x, static_cast<int>(vertices.size()), sizeof(vec3));
+	}
+
+	// Simplify using farthest point sampling. Start from the vertex farthest from
+	// the center and repeatedly add the vertex farthest from those already chosen.
+	vec3 center(0.0f);
+	for (const vec3& v : vertices) {
+		center += v;
+	}
+	center /= static_cast<float>(vertices.size());
+
+	std::vector<float> distance(vertices.size());
+	int next = 0;
+	for (size_t i = 0; i < vertices.size(); i++) {
+
+		distance[i] = glm::length(vertices[i] - center);
+		if (distance[i] > distance[next]) {
+			next = static_cast<int>(i);
+		}
+	}
+	std::fill(distance.begin(), distance.end(), POS_INFINITY);
+
+	btConvexHullShape* hullShape = new btConvexHullShape();
+
+	for (int count = 0; count < maxVertices; count++) {
+
+		const vec3& chosen = vertices[next];
+		hullShape->addPoint(btVector3(chosen.x, chosen.y, chosen.z), false);
+
+		int farthest = next;
+		for (size_t i = 0; i < vertices.size(); i++) {
+
+			distance[i] = glm::min(distance[i], glm::length(vertices[i] - chosen));
+			if (distance[i] > distance[farthest]) {
+				farthest = static_cast<int>(i);
+			}
+		}
+		next = farthest;
+	}
+
+	hullShape->recalcLocalAabb();
+
+	return hullShape;
+
+} // end createHullShape
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <string>
+
+#include "MathLibsConstsFuncs.h"
+#include "Bullet/btBulletDynamicsCommon.h"
+
+using namespace constants_and_types;
+
+/**
+ * @struct	ConvexDecompositionSettings
+ *
+ * @brief	Parameters that control the approximate convex decomposition of a
+ * 			triangle mesh.
+ */
+struct ConvexDecompositionSettings
+{
+	/** @brief	Upper bound on the number of convex pieces that will be generated. */
+	int maxHulls = 16;
+
+	/** @brief	Splitting stops once the concavity of every piece is below this value. It is
+	 * 			expressed as a fraction of the diagonal of the bounding box of the whole mesh.
+	 */
+	float maxConcavity = 0.02f;
+
+	/** @brief	Upper bound on the number of vertices in each convex piece. Pieces
+	 * 			with more vertices are simplified.
+	 */
+	int maxVerticesPerHull = 32;
+
+	/** @brief	Pieces containing fewer triangles than this are never split. */
+	int minTrianglesPerHull = 8;
+
+	/** @brief	Maximum number of vertices that are sampled when measuring the
+	 * 			concavity of a piece. Bounds the cost of decomposing very large meshes.
+	 */
+	int maxConcavitySamples = 2048;
+
+	/**
+	 * @fn	std::string ConvexDecompositionSettings::getKey() const;
+	 *
+	 * @brief	Gets a string that uniquely identifies these settings. Used to
+	 * 			distinguish cached collision shapes built with different settings.
+	 *
+	 * @returns	The key.
+	 */
+	std::string getKey() const;
+};
+
+/**
+ * @class	ConvexDecomposition
+ *
+ * @brief	Builds an approximate convex decomposition of a concave triangle
+ * 			mesh. The mesh is recursively split by axis aligned planes, always
+ * 			splitting the piece with the largest concavity and choosing the
+ * 			plane that yields the smallest combined hull volume. The result is
+ * 			a bounded number of tight convex hulls that give accurate collisions
+ * 			with far fewer contact points than a triangle mesh.
+ */
+class ConvexDecomposition
+{
+public:
+
+	/**
+	 * @fn	static btCompoundShape* ConvexDecomposition::Decompose(const std::vector<vec3>& positions, const std::vector<unsigned int>& indices, const ConvexDecompositionSettings& settings = ConvexDecompositionSettings());
+	 *
+	 * @brief	Decomposes a triangle mesh into a compound shape made of convex hulls.
+	 *
+	 * @param	positions	Vertex positions in the coordinate frame of the collision shape.
+	 * @param	indices  	Three indices per triangle.
+	 * @param	settings 	(Optional) Settings that control the decomposition.
+	 *
+	 * @returns	Null if the mesh is empty, else a compound shape containing the
+	 * 			convex pieces. The caller takes ownership of the compound shape and
+	 * 			of its child shapes.
+	 */
+	static btCompoundShape* Decompose(const std::vector<vec3>& positions, const std::vector<unsigned int>& indices,
+									  const ConvexDecompositionSettings& settings = ConvexDecompositionSettings());
+
+protected:
+
+	/**
+	 * @struct	Piece
+	 *
+	 * @brief	A cluster of triangles along with the convex hull that surrounds them.
+	 */
+	struct Piece
+	{
+		/** @brief	Indices of the triangles that belong to this piece. */
+		std::vector<int> triangles;
+
+		/** @brief	Vertices of the convex hull of the piece. */
+		std::vector<vec3> hullVertices;
+
+		/** @brief	Volume of the convex hull of the piece. */
+		float hullVolume = 0.0f;
+
+		/** @brief	Largest distance between a vertex of the piece and the surface of the hull. */
+		float concavity = 0.0f;
+	};
+
+	/**
+	 * @fn	static void ConvexDecomposition::buildHull(Piece& piece, const std::vector<vec3>& positions, const std::vector<unsigned int>& indices, int maxSamples, bool measureConcavity);
+	 *
+	 * @brief	Computes the convex hull, hull volume, and (optionally) the concavity of a piece.
+	 *
+	 * @param [in,out]	piece				The piece.
+	 * @param 		  	positions			Vertex positions of the whole mesh.
+	 * @param 		  	indices				Triangle indices of the whole mesh.
+	 * @param 		  	maxSamples			Maximum number of vertices sampled to measure the concavity.
+	 * @param 		  	measureConcavity	True to measure the concavity of the piece.
+	 */
+	static void buildHull(Piece& piece, const std::vector<vec3>& positions, const std::vector<unsigned int>& indices,
+						  int maxSamples, bool measureConcavity);
+
+	/**
+	 * @fn	static btConvexHullShape* ConvexDecomposition::createHullShape(const Piece& piece, int maxVertices);
+	 *
+	 * @brief	Creates a bullet convex hull shape for a piece. Hulls with more
+	 * 			than maxVertices vertices are simplified.
+	 *
+	 * @param	piece	   	The piece.
+	 * @param	maxVertices	The maximum number of vertices.
+	 *
+	 * @returns	The new hull shape.
+	 */
+	static btConvexHullShape* createHullShape(const Piece& piece, int maxVertices);
+
+}; // end ConvexDecomposition class
@@ -1,4 +1,5 @@
 #include "DirectionalLightComponent.h"
+#include "ShadowEngine.h"
 
 DirectionalLightComponent::DirectionalLightComponent(int controlkey)
 	: LightComponent(controlkey) {}
@@ -11,4 +12,12 @@ void DirectionalLightComponent::update(const float& deltaTime) {
 		glm::vec4 lightDirection = glm::normalize(glm::vec4(-worldForward, 0.0f));
 		setPositionOrDirection(lightDirection);
 	}
-}
\ No newline at end of file
+}
+
+void DirectionalLightComponent::setShadowRegion(glm::vec3 center, float radius) {
+	ShadowEngine::SetShadowRegion(lightIndex, center, radius);
+}
+
+void DirectionalLightComponent::setShadowCascades(int numCascades, float shadowDistance, int farCascadeInterval) {
+	ShadowEngine::SetShadowCascades(lightIndex, numCascades, shadowDistance, farCascadeInterval);
+}
@@ -6,4 +6,14 @@ class DirectionalLightComponent : public LightComponent
 public:
 	DirectionalLightComponent(int controlkey);
 	virtual void update(const float& deltaTime) override;
+
+	// Sets the sphere in World coordinates covered by the shadow map.
+	// Call after setCastsShadows.
+	void setShadowRegion(glm::vec3 center, float radius);
+
+	// Splits the view of each active camera into cascades that each get their own
+	// shadow map, out to shadowDistance. Cascades after the first two are rendered
+	// every farCascadeInterval frames. Zero cascades goes back to the shadow region.
+	// Call after setCastsShadows.
+	void setShadowCascades(int numCascades = 4, float shadowDistance = 200.0f, int farCascadeInterval = 4);
 };
\ No newline at end of file
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "GameEngine.h"
+
+#include <chrono>
+
+/**
+ * @class	FlockingBenchmark
+ *
+ * @brief	Scene with thousands of flocking agents in a single flock. Reports
+ * 			the average time spent rebuilding the spatial hash grid and the
+ * 			average time spent updating the game objects, which is dominated
+ * 			by the neighbour queries and steering of the agents.
+ */
+class FlockingBenchmark : public Game
+{
+public:
+
+	/**
+	 * @fn	FlockingBenchmark::FlockingBenchmark(int numAgents = 10000)
+	 *
+	 * @brief	Constructor
+	 *
+	 * @param	numAgents	(Optional) Number of flocking agents.
+	 */
+	FlockingBenchmark(int numAgents = 10000)
+		: numAgents(numAgents)
+	{
+	}
+
+protected:
+
+	/** @brief	Number of flocking agents in the scene. */
+	int numAgents;
+
+	/** @brief	Update times accumulated since the last report. */
+	double accumulatedGridTime = 0.0;
+	double accumulatedUpdateTime = 0.0;
+	int accumulatedUpdates = 0;
+
+	void loadScene() override
+	{
+		glfwSetWindowTitle(renderWindow, "Flocking Benchmark");
+
+		glClearColor(0.5f, 0.5f, 0.5f, 1.0f);
+
+		ShaderInfo shaders[] = {
+			{ GL_VERTEX_SHADER, "Shaders/vertexShader.glsl" },
+			{ GL_FRAGMENT_SHADER, "Shaders/fragmentShader.glsl" },
+			{ GL_NONE, NULL } // signals that there are no more shaders
+		};
+
+		GLuint shaderProgram = BuildShaderProgram(shaders);
+
+		SharedMaterials::setUniformBlockForShader(shaderProgram);
+		SharedTransformations::setUniformBlockForShader(shaderProgram);
+		SharedLighting::setUniformBlockForShader(shaderProgram);
+		SharedFog::setUniformBlockForShader(shaderProgram);
+
+		// ***** Light *****
+		auto lightObject = std::make_shared<GameObject>();
+		addChildGameObject(lightObject);
+		lightObject->addComponent(std::make_shared<DirectionalLightComponent>(GLFW_KEY_D));
+		lightObject->rotateTo(vec3(-1.0f, -1.0f, -1.0f));
+
+		// ***** Agents *****
+		// A single material lets every agent share one cached mesh
+		Material agentMat;
+		agentMat.setAmbientAndDiffuseMat(LIGHT_BLUE_RGBA);
+
+		// Keep the density of the flock the same for any number of agents
+		const float spacing = 4.0f;
+		float flockRadius = spacing * cbrt(static_cast<float>(numAgents)) / 2.0f;
+
+		srand(1);
+
+		for (int i = 0; i < numAgents; i++) {
+
+			vec3 position = flockRadius * vec3(rand() / (float)RAND_MAX - 0.5f,
+											   rand() / (float)RAND_MAX - 0.5f,
+											   rand() / (float)RAND_MAX - 0.5f) * 2.0f;
+
+			auto agentObject = std::make_shared<GameObject>();
+			addChildGameObject(agentObject);
+			agentObject->setPosition(position, LOCAL);
+
+			agentObject->addComponent(std::make_shared<BoxMeshComponent>(shaderProgram, agentMat, 0.5f, 0.5f, 1.0f));
+
+			auto agent = std::make_shared<FlockingComponent>(10.0f, 2.0f * spacing);
+			agent->setHome(ZERO_V3, flockRadius);
+			agent->setVelocity(10.0f * glm::normalize(vec3(1.0f, 0.0f, 0.0f) + 0.1f * position / flockRadius));
+			agentObject->addComponent(agent);
+		}
+
+		// ***** Camera *****
+		auto cameraObject = std::make_shared<GameObject>();
+		addChildGameObject(cameraObject);
+		cameraObject->setPosition(vec3(0.0f, flockRadius, 3.0f * flockRadius), LOCAL);
+		cameraObject->rotateTo(vec3(0.0f, -1.0f, -3.0f));
+		cameraObject->addComponent(std::make_shared<CameraComponent>());
+
+		cout << "Flocking benchmark: " << numAgents << " agents" << endl;
+
+	} // end loadScene
+
+	void updateGame() override
+	{
+		// Updating the game objects is dominated by the agents. The time is
+		// only counted for frames in which the steering engine was updated.
+		unsigned long long lastUpdateCount = SteeringEngine::GetUpdateCount();
+
+		auto start = std::chrono::steady_clock::now();
+
+		Game::updateGame();
+
+		double updateTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		if (SteeringEngine::GetUpdateCount() != lastUpdateCount) {
+
+			accumulatedGridTime += SteeringEngine::GetLastUpdateTime();
+			accumulatedUpdateTime += updateTime - SteeringEngine::GetLastUpdateTime();
+			accumulatedUpdates++;
+		}
+
+		// Report the averages every few seconds
+		if (accumulatedUpdates == 300) {
+
+			cout << "Average grid rebuild: " << 1000.0 * accumulatedGridTime / accumulatedUpdates
+				 << " ms, average agent update: " << 1000.0 * accumulatedUpdateTime / accumulatedUpdates
+				 << " ms" << endl;
+
+			accumulatedGridTime = 0.0;
+			accumulatedUpdateTime = 0.0;
+			accumulatedUpdates = 0;
+		}
+
+	} // end updateGame
+
+}; // end FlockingBenchmark class
@@ -0,0 +1,114 @@
+#include "FlockingComponent.h"
+
+#include "SteeringEngine.h"
+
+#define VERBOSE false
+
+FlockingComponent::FlockingComponent(float maxSpeed, float neighborRadius, int updateOrder)
+	: Component(updateOrder), maxSpeed(maxSpeed), neighborRadius(neighborRadius)
+{
+
+} // end constructor
+
+
+FlockingComponent::~FlockingComponent()
+{
+	SteeringEngine::RemoveAgent(this);
+
+} // end destructor
+
+
+void FlockingComponent::initialize()
+{
+	SteeringEngine::AddAgent(this);
+
+} // end initialize
+
+
+void FlockingComponent::setWeights(float separation, float alignment, float cohesion)
+{
+	separationWeight = separation;
+	alignmentWeight = alignment;
+	cohesionWeight = cohesion;
+
+} // end setWeights
+
+
+void FlockingComponent::setHome(const vec3& homePosition, float roamRadius)
+{
+	this->homePosition = homePosition;
+	this->roamRadius = roamRadius;
+
+} // end setHome
+
+
+void FlockingComponent::update(const float& deltaTime)
+{
+	if (agentId < 0) {
+		return;
+	}
+
+	// Position at the last SteeringEngine update. Nothing else moves the agent.
+	vec3 position = SteeringEngine::GetAgentPosition(agentId);
+
+	vec3 separation = ZERO_V3;
+	vec3 averageVelocity = ZERO_V3;
+	vec3 center = ZERO_V3;
+	int numNeighbors = 0;
+
+	SteeringEngine::ForEachNeighbor(position, neighborRadius, [&](int id) {
+
+		if (id == agentId) {
+			return true;
+		}
+
+		vec3 offset = position - SteeringEngine::GetAgentPosition(id);
+		float distanceSquared = glm::dot(offset, offset);
+
+		// Push away harder from closer neighbours
+		if (distanceSquared > 0.0f) {
+			separation += offset / distanceSquared;
+		}
+
+		averageVelocity += SteeringEngine::GetAgentVelocity(id);
+		center += SteeringEngine::GetAgentPosition(id);
+
+		return ++numNeighbors < maxNeighbors;
+	});
+
+	vec3 acceleration = ZERO_V3;
+
+	if (numNeighbors > 0) {
+
+		averageVelocity /= static_cast<float>(numNeighbors);
+		center /= static_cast<float>(numNeighbors);
+
+		acceleration += separationWeight * separation * neighborRadius;
+		acceleration += alignmentWeight * (averageVelocity - velocity);
+		acceleration += cohesionWeight * (center - position);
+	}
+
+	// Head back toward home once outside the roam radius
+	vec3 toHome = homePosition - position;
+	float distanceFromHome = glm::length(toHome);
+	if (distanceFromHome > roamRadius) {
+
+		acceleration += (toHome / distanceFromHome) * maxSpeed * (distanceFromHome - roamRadius) / roamRadius;
+	}
+
+	velocity += acceleration * deltaTime;
+
+	float speed = glm::length(velocity);
+	if (speed > maxSpeed) {
+
+		velocity *= maxSpeed / speed;
+	}
+
+	if (speed > 0.0f) {
+
+		owningGameObject->rotateTo(velocity, WORLD);
+	}
+
+	owningGameObject->setPosition(position + velocity * deltaTime, WORLD);
+
+} // end update
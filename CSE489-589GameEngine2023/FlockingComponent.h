@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Component.h"
+
+/**
+ * @class	FlockingComponent
+ *
+ * @brief	Steers the owning game object as a member of a flock. Each frame the
+ * 			agent looks up its neighbours in the SteeringEngine and combines
+ * 			separation (avoid crowding), alignment (match the heading of the
+ * 			neighbours), and cohesion (move toward their center) into an
+ * 			acceleration. Agents that wander farther than the roam radius
+ * 			from their home position are steered back toward it.
+ */
+class FlockingComponent : public Component
+{
+public:
+
+	/**
+	 * @fn	FlockingComponent::FlockingComponent(float maxSpeed = 10.0f, float neighborRadius = 10.0f, int updateOrder = 100);
+	 *
+	 * @brief	Constructor
+	 *
+	 * @param	maxSpeed	  	(Optional) The maximum speed.
+	 * @param	neighborRadius	(Optional) Agents closer than this are neighbours.
+	 * @param	updateOrder   	(Optional) The update order.
+	 */
+	FlockingComponent(float maxSpeed = 10.0f, float neighborRadius = 10.0f, int updateOrder = 100);
+
+	/**
+	 * @fn	virtual FlockingComponent::~FlockingComponent();
+	 *
+	 * @brief	Destructor. Removes the agent from the SteeringEngine.
+	 */
+	virtual ~FlockingComponent();
+
+	virtual void initialize() override;
+
+	virtual void update(const float& deltaTime) override;
+
+	/**
+	 * @fn	void FlockingComponent::setWeights(float separation, float alignment, float cohesion);
+	 *
+	 * @brief	Sets the strength of each steering behavior.
+	 *
+	 * @param	separation	Weight of the separation behavior.
+	 * @param	alignment 	Weight of the alignment behavior.
+	 * @param	cohesion  	Weight of the cohesion behavior.
+	 */
+	void setWeights(float separation, float alignment, float cohesion);
+
+	/**
+	 * @fn	void FlockingComponent::setHome(const vec3& homePosition, float roamRadius);
+	 *
+	 * @brief	Keeps the agent near a position in world coordinates.
+	 *
+	 * @param	homePosition	The home position.
+	 * @param	roamRadius  	Agents farther than this from home are steered back.
+	 */
+	void setHome(const vec3& homePosition, float roamRadius);
+
+	void setVelocity(const vec3& velocity) { this->velocity = velocity; }
+
+	const vec3& getVelocity() const { return velocity; }
+
+	float getNeighborRadius() const { return neighborRadius; }
+
+	/** @brief	Id of the agent in the SteeringEngine. Negative if not added. */
+	int agentId = -1;
+
+protected:
+
+	/** @brief	Velocity in world coordinates. */
+	vec3 velocity = ZERO_V3;
+
+	float maxSpeed;
+	float neighborRadius;
+
+	/** @brief	Only the first neighbours found are considered. Bounds the cost in dense flocks. */
+	int maxNeighbors = 16;
+
+	float separationWeight = 1.5f;
+	float alignmentWeight = 1.0f;
+	float cohesionWeight = 1.0f;
+
+	vec3 homePosition = ZERO_V3;
+	float roamRadius = 100.0f;
+
+}; // end FlockingComponent class
@@ -3,7 +3,11 @@
 #define VERBOSE false
 
 #include "SoundEngine.h"
-//#include "PhysicsEngine.h"
+#include "SoundBackend.h"
+#include "PhysicsEngine.h"
+#include "SteeringEngine.h"
+#include "NavigationGraph.h"
+#include "ShadowEngine.h"
 
 
 //********************* Initialization Methods *****************************************
@@ -51,10 +55,19 @@ bool Game::initializeGame()
 	bool graphicsInit = initializeGraphics();
 
 	// Initialize sound engine
-	bool soundInit = SoundEngine::Init();
+	bool soundInit = SoundEngine::Init(AL_INVERSE_DISTANCE, 1.0f, 32, soundBackend);
+	soundBackend = nullptr;
+
+	// Initialize physics engine
+	bool physicsInit = PhysicsEngine::Init(multithreadedPhysics, physicsThreadCount);
+
+	// Initialize shadow engine. The game runs without shadows if it fails.
+	if (graphicsInit) {
+		ShadowEngine::Init();
+	}
 
 	// Check if all libraries initialized correctly
-	if (windowInit && graphicsInit && soundInit)
+	if (windowInit && graphicsInit && soundInit && physicsInit)
 	{
 		// Build the scene graph
 		loadScene();
@@ -274,14 +287,7 @@ void Game::updateGame()
 
 	if (deltaTime >= FRAME_INTERVAL) {
 
-		// Start an update traversal of all SceneGrapNode/GameObjects in the game
-		GameObject::update(deltaTime);
-
-		// Add pending, delete removed, and reparent
-		GameObject::UpdateSceneGraph();
-
-		// Update SoundEngine
-		SoundEngine::Update();
+		stepGame(deltaTime);
 
 		// Update the last time the game was updated
 		lastRenderTime = currentTime;
@@ -294,6 +300,26 @@ void Game::updateGame()
 
 } // end updateGame()
 
+
+void Game::stepGame(float deltaTime)
+{
+	// Steer the waypoint followers and snapshot the flocking agents
+	SteeringEngine::Update(deltaTime);
+
+	// Start an update traversal of all SceneGrapNode/GameObjects in the game
+	GameObject::update(deltaTime);
+
+	// Add pending, delete removed, and reparent
+	GameObject::UpdateSceneGraph();
+
+	// Update PhysicsEngine
+	PhysicsEngine::Update(deltaTime);
+
+	// Update SoundEngine
+	SoundEngine::Update(deltaTime);
+
+} // end stepGame
+
 void Game::renderScene()
 {
 	// Clear the color and depth buffers
@@ -302,6 +328,12 @@ void Game::renderScene()
 	//mat4 viewingTrans = glm::lookAt(vec3(0.0f, 0.0f, 30.0f), vec3(0.0f, 0.0f, 0.0f),vec3(0.0f, 1.0f, 0.0f));
 	//SharedTransformations::setViewMatrix(viewingTrans);
 
+	// Render the shadow maps that are out of date
+	ShadowEngine::RenderShadowMaps();
+
+	// Copy all of the light changes made during the update in one upload
+	SharedLighting::uploadLights();
+
 	for (auto& camera : CameraComponent::GetActiveCameras()) {
 
 		camera->setCameraTransformations();
@@ -322,6 +354,9 @@ void Game::renderScene()
 
 void Game::shutdown()
 {
+	// Delete the shadow maps while the OpenGL context still exists
+	ShadowEngine::Stop();
+
 	// Destroy the window
 	glfwDestroyWindow(renderWindow);
 
@@ -334,6 +369,12 @@ void Game::shutdown()
 	// Delete SoundEngine
 	SoundEngine::Stop();
 
+	// Delete PhysicsEngine
+	PhysicsEngine::Stop();
+
+	// Stop the pathfinding worker threads
+	NavigationGraph::StopPathfinding();
+
 } // end shutDown
 
 //********************* Accessor Methods *****************************************
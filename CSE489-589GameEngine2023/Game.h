@@ -21,6 +21,8 @@ static const GLdouble FRAME_INTERVAL = 1.0 / FRAMES_PER_SECOND;
 
 using namespace constants_and_types;
 
+class SoundBackend;
+
 class Game : public GameObject
 {
 
@@ -165,6 +167,18 @@ protected:
 	 */
 	virtual void updateGame();
 
+	/**
+	 * @fn	void Game::stepGame(float deltaTime);
+	 *
+	 * @brief	Advances the steering, game objects, physics, and sound by one
+	 * 			frame. Called by updateGame with the wall clock time since the
+	 * 			last frame. Games that need the same result on every run can
+	 * 			call it with a fixed time step instead.
+	 *
+	 * @param	deltaTime	The time step in seconds.
+	 */
+	void stepGame(float deltaTime);
+
 	/**
 	 * @fn	void Game::renderScene();
 	 *
@@ -191,6 +205,19 @@ protected:
 	/** @brief	True to wire frame key was down on the last input input cycle */
 	bool WireFrame_KeyDown = false;
 
+	/** @brief	True to use the multithreaded physics pipeline. Set before runGame is called. */
+	bool multithreadedPhysics = false;
+
+	/** @brief	Number of threads used by the multithreaded physics pipeline. Values
+	 *	less than one use the number of hardware threads.
+	 */
+	int physicsThreadCount = 0;
+
+	/** @brief	Creates the audio device and context. Null plays through the default
+	 *	audio device. Set before runGame is called. The sound engine takes ownership.
+	 */
+	SoundBackend* soundBackend = nullptr;
+
 }; // end game class
 
 /**
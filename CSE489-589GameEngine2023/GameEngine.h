@@ -41,11 +41,19 @@
 #include "SteeringComponent.h"
 #include "WaypointComponent.h"
 #include "JourneyComponent.h"
+#include "SteeringEngine.h"
+#include "FlockingComponent.h"
+#include "SplinePath.h"
+#include "PathFollowerComponent.h"
+#include "NavigationGraph.h"
+#include "NavigationComponent.h"
+#include "ShadowEngine.h"
 #include "CollisionComponent.h"
 #include "RigidBodyComponent.h"
 
 // Sound
 #include "SoundEngine.h"
+#include "SoundBackend.h"
 #include "SoundBaseComponent.h"
 #include "SoundListenerComponent.h"
 #include "SoundSourceComponent.h"
@@ -5,6 +5,7 @@
 #include "Game.h"
 
 #include "CameraComponent.h"
+#include "RigidBodyComponent.h"
 
 #define VERBOSE false
 
@@ -30,6 +31,10 @@ GameObject::~GameObject()
 {
 	// Remove the game object from the game
 	if (VERBOSE) cout << "GameObject destructor called" << endl;
+
+	if (transformMoved) {
+		movedNodes.erase(std::remove(movedNodes.begin(), movedNodes.end(), this), movedNodes.end());
+	}
 		
 	//children.clear();
 	//components.clear();
@@ -135,6 +140,28 @@ void GameObject::addComponent(std::shared_ptr<Component> component)
 		CameraComponent::addCamera(std::static_pointer_cast<CameraComponent>(component));
 	}
 
+	// Register collision listeners between the component and its rigid body siblings
+	if (component->getComponentType() == RIGID_BODY) {
+
+		RigidBodyComponent* rigidBody = static_cast<RigidBodyComponent*>(component.get());
+
+		for (auto& sibling : components) {
+
+			if (sibling->getCollisionEventTypes() != 0) {
+				rigidBody->addCollisionListener(sibling.get());
+			}
+		}
+	}
+	else if (component->getCollisionEventTypes() != 0) {
+
+		for (auto& sibling : components) {
+
+			if (sibling->getComponentType() == RIGID_BODY) {
+				static_cast<RigidBodyComponent*>(sibling.get())->addCollisionListener(component.get());
+			}
+		}
+	}
+
 } // end addComponent
 
 
@@ -161,6 +188,14 @@ void GameObject::removeComponent(std::shared_ptr< Component> component)
 			CameraComponent::removeCamera(std::static_pointer_cast<CameraComponent>(component));
 		}
 
+		// Stop sending collision events to the component
+		for (auto& sibling : components) {
+
+			if (sibling->getComponentType() == RIGID_BODY) {
+				static_cast<RigidBodyComponent*>(sibling.get())->removeCollisionListener(component.get());
+			}
+		}
+
 		std::iter_swap(iter, components.end() - 1);
 		components.pop_back();
 	}
@@ -296,6 +331,9 @@ void GameObject::AddPendingGameObjects()
 		// Add the pending gameObject to the parent's child list
 		parentGameObject->children.emplace_back(pending);
 
+		// Its world transform now includes the transform of the parent
+		pending->transformChanged();
+
 		// Same as initializing at the begining of the game
 		pending->initialize();
 
@@ -312,6 +350,43 @@ void GameObject::AddPendingGameObjects()
 
 } // end AddPendingGameObjects
 
+
+void GameObject::CollectMovedKinematicBodies(std::vector<RigidBodyComponent*>& bodies)
+{
+	for (SceneGraphNode* node : movedNodes) {
+
+		// Only game objects are in the scene graph
+		GameObject* gameObject = static_cast<GameObject*>(node);
+
+		gameObject->transformMoved = false;
+		gameObject->addKinematicBodies(bodies);
+	}
+
+	movedNodes.clear();
+
+} // end CollectMovedKinematicBodies
+
+
+void GameObject::addKinematicBodies(std::vector<RigidBodyComponent*>& bodies)
+{
+	for (auto& component : components) {
+
+		if (component->getComponentType() == RIGID_BODY) {
+
+			RigidBodyComponent* body = static_cast<RigidBodyComponent*>(component.get());
+
+			if (body->getDynamicsState() == KINEMATIC || body->getDynamicsState() == TRIGGER) {
+				bodies.push_back(body);
+			}
+		}
+	}
+
+	for (auto& child : children) {
+		child->addKinematicBodies(bodies);
+	}
+
+} // end addKinematicBodies
+
 void GameObject::ReparentGameObjects()
 {
 	//// Handle all of the reparented GameObject
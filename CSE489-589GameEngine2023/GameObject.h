@@ -176,8 +176,27 @@ public:
 	 */
 	void reparent(class GameObject* child);
 
+	/**
+	 * @fn	static void GameObject::CollectMovedKinematicBodies(std::vector<class RigidBodyComponent*>& bodies);
+	 *
+	 * @brief	Finds the KINEMATIC and TRIGGER rigid bodies of the game objects whose
+	 * 			transforms changed since the last call and of their descendants, which
+	 * 			moved with them. Called by the physics engine before each update.
+	 *
+	 * @param [out]	bodies	The bodies are added to the end. A body may be added more than once.
+	 */
+	static void CollectMovedKinematicBodies(std::vector<class RigidBodyComponent*>& bodies);
+
 protected:
 
+	/**
+	 * @fn	void GameObject::addKinematicBodies(std::vector<class RigidBodyComponent*>& bodies);
+	 *
+	 * @brief	Adds the KINEMATIC and TRIGGER rigid bodies of this game object and its descendants.
+	 */
+	void addKinematicBodies(std::vector<class RigidBodyComponent*>& bodies);
+
+
 	/**
 	 * @fn	static void GameObject::UpdateSceneGraph();
 	 *
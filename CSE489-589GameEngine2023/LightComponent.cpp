@@ -1,23 +1,19 @@
 #include "LightComponent.h"
+#include "ShadowEngine.h"
 
 LightComponent::LightComponent(int controlkey) 
 	: controlKey(controlkey)
 {
 	componentType = LIGHT;
 
-	for (int i = 0; i < MAX_LIGHTS; i++) {
-
-		if (SharedLighting::lights[i].inUse == false) {
-			lightIndex = i;
-			SharedLighting::lights[i].inUse = true;
-			break;
-		}
-	}
+	lightIndex = SharedLighting::allocateLight();
 }
 
 LightComponent::~LightComponent() {
-	SharedLighting::initilizeAttributes(lightIndex);
-	SharedLighting::lights[lightIndex].inUse = false;
+	if (castsShadows) {
+		ShadowEngine::RemoveShadowLight(lightIndex);
+	}
+	SharedLighting::releaseLight(lightIndex);
 }
 
 void LightComponent::processInput() {
@@ -100,4 +96,15 @@ void LightComponent::setQuadraticAttenuation(float factor) {
 
 float LightComponent::getQuadraticAttenuation() {
 	return SharedLighting::getQuadraticAttenuation(lightIndex);
+}
+
+// Shadows
+void LightComponent::setCastsShadows(bool castsShadows, int resolution) {
+	if (castsShadows) {
+		ShadowEngine::AddShadowLight(lightIndex, resolution);
+	}
+	else {
+		ShadowEngine::RemoveShadowLight(lightIndex);
+	}
+	this->castsShadows = castsShadows;
 }
\ No newline at end of file
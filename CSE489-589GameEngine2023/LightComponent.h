@@ -33,8 +33,13 @@ public:
 	void setQuadraticAttenuation(float factor);
 	float getQuadraticAttenuation();
 
+	// Shadows
+	void setCastsShadows(bool castsShadows, int resolution = 1024);
+	bool getCastsShadows() { return castsShadows; }
+
 protected:
 	int lightIndex = 0;
 	int controlKey;
 	bool keyPressed = false;
+	bool castsShadows = false;
 };
\ No newline at end of file
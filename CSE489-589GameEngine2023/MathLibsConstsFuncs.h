@@ -122,7 +122,7 @@ namespace constants_and_types {
     enum Frame { WORLD = 0, LOCAL };
 
     // Rigidbody Dynamics
-    enum DynamicsState { NONE = 0, STATIONARY, KINEMATIC, DYNAMIC };
+    enum DynamicsState { NONE = 0, STATIONARY, KINEMATIC, DYNAMIC, TRIGGER };
 
     // Local directions
     static const vec3 FORWARD(-UNIT_Z_V3);
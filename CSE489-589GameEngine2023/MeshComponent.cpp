@@ -2,6 +2,8 @@
 
 #include "SharedTransformations.h"
 #include "SharedMaterials.h"
+#include "SharedFog.h"
+#include "ShadowEngine.h"
 
 #define VERBOSE false
 
@@ -71,14 +73,18 @@ void MeshComponent::draw() const
 {
 	if (this->owningGameObject->getState() == ACTIVE) {
 
-		// Use the shader program for this MeshComponent
-		glUseProgram(shaderProgram);
-
 		SharedTransformations::setModelingMatrix(this->owningGameObject->getModelingTransformation());
 
+		// Fog is the same for every subMesh
+		unsigned int fogFeatures = SharedFog::getShaderFeatures();
+
 		// Render all subMeshes
 		for (auto & subMesh : subMeshes) {
 
+			// Use the variant of the shader program for this MeshComponent
+			// that matches the material and the fog
+			glUseProgram(getShaderVariant(shaderProgram, SharedMaterials::getShaderFeatures(subMesh.material) | fogFeatures));
+
 			// Bind vertex array object for the subMesh
 			glBindVertexArray(subMesh.vao);
 
@@ -113,6 +119,77 @@ void MeshComponent::draw() const
 } // end draw
 
 
+void MeshComponent::drawShadowCaster(GLint modelMatrixLocation) const
+{
+	if (this->owningGameObject->getState() == ACTIVE) {
+
+		glUniformMatrix4fv(modelMatrixLocation, 1, GL_FALSE, glm::value_ptr(this->owningGameObject->getModelingTransformation()));
+
+		for (auto& subMesh : subMeshes) {
+
+			glBindVertexArray(subMesh.vao);
+
+			if (subMesh.renderMode == ORDERED) {
+
+				glDrawArrays(subMesh.primitiveMode, 0, subMesh.count);
+			}
+			else if (subMesh.renderMode == INDEXED) {
+
+				glDrawElements(subMesh.primitiveMode, subMesh.count, GL_UNSIGNED_INT, 0);
+			}
+		}
+	}
+
+} // end drawShadowCaster
+
+
+bool MeshComponent::getBoundingSphere(vec3& center, float& radius) const
+{
+	if (collisionShape == nullptr) {
+		return false;
+	}
+
+	btVector3 localCenter;
+	btScalar localRadius;
+	collisionShape->getBoundingSphere(localCenter, localRadius);
+
+	mat4 modelingTransformation = this->owningGameObject->getModelingTransformation();
+
+	center = vec3(modelingTransformation * vec4(localCenter.x(), localCenter.y(), localCenter.z(), 1.0f));
+
+	// Scale by the largest axis so the sphere still contains the mesh
+	float scale = std::max(std::max(glm::length(vec3(modelingTransformation[0])),
+		glm::length(vec3(modelingTransformation[1]))), glm::length(vec3(modelingTransformation[2])));
+
+	radius = localRadius * scale;
+
+	return true;
+
+} // end getBoundingSphere
+
+
+void MeshComponent::setCastsShadows(bool castsShadows)
+{
+	if (this->castsShadows != castsShadows && staticShadowCaster) {
+		ShadowEngine::StaticCastersChanged();
+	}
+
+	this->castsShadows = castsShadows;
+
+} // end setCastsShadows
+
+
+void MeshComponent::setStaticShadowCaster(bool staticShadowCaster)
+{
+	if (this->staticShadowCaster != staticShadowCaster && castsShadows) {
+		ShadowEngine::StaticCastersChanged();
+	}
+
+	this->staticShadowCaster = staticShadowCaster;
+
+} // end setStaticShadowCaster
+
+
 SubMesh  MeshComponent::buildSubMesh(const std::vector<pntVertexData>& vertexData)
 {
 	// Create the SubMesh to be configured for the vertex data
@@ -191,6 +268,10 @@ void MeshComponent::addMeshComp(std::shared_ptr<MeshComponent> meshComponent)
 
 		meshComps.emplace_back(meshComponent);
 		std::sort(meshComps.begin(), meshComps.end(), Component::CompareUpdateOrder);
+
+		if (meshComponent->castsShadows && meshComponent->staticShadowCaster) {
+			ShadowEngine::StaticCastersChanged();
+		}
 	}
 
 } // end addMeshComp
@@ -203,6 +284,10 @@ void MeshComponent::removeMeshComp(std::shared_ptr<MeshComponent> meshComponent)
 
 		if (VERBOSE) cout << "removeMeshComp" << endl;
 
+		if (meshComponent->castsShadows && meshComponent->staticShadowCaster) {
+			ShadowEngine::StaticCastersChanged();
+		}
+
 		// Swap to end of vector and pop off (avoid erase copies)
 		std::iter_swap(iter, meshComps.end() - 1);
 		meshComps.pop_back();
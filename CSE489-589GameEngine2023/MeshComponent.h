@@ -172,6 +172,51 @@ public:
 	 */
 	btCollisionShape* getCollisionShape() const { return this->collisionShape; }
 
+	/**
+	 * @fn	void MeshComponent::setCastsShadows(bool castsShadows);
+	 *
+	 * @brief	Sets whether the mesh is rendered into the shadow maps of lights.
+	 * 			Meshes cast shadows by default.
+	 */
+	void setCastsShadows(bool castsShadows);
+
+	bool getCastsShadows() const { return castsShadows; }
+
+	/**
+	 * @fn	void MeshComponent::setStaticShadowCaster(bool staticShadowCaster);
+	 *
+	 * @brief	Marks the mesh as one that does not move. Static meshes are kept in
+	 * 			cached shadow maps that are only rendered again when a light moves
+	 * 			or a static mesh is added or removed. Call
+	 * 			ShadowEngine::StaticCastersChanged after moving one.
+	 */
+	void setStaticShadowCaster(bool staticShadowCaster);
+
+	bool isStaticShadowCaster() const { return staticShadowCaster; }
+
+	/**
+	 * @fn	void MeshComponent::drawShadowCaster(GLint modelMatrixLocation) const;
+	 *
+	 * @brief	Renders the depth of all sub-meshes with the shader program that
+	 * 			is in use. No materials are set.
+	 *
+	 * @param	modelMatrixLocation	Location of the modeling transformation uniform.
+	 */
+	void drawShadowCaster(GLint modelMatrixLocation) const;
+
+	/**
+	 * @fn	bool MeshComponent::getBoundingSphere(vec3& center, float& radius) const;
+	 *
+	 * @brief	Gets a sphere in World coordinates that contains the mesh. Based
+	 * 			on the collision shape.
+	 *
+	 * @param [out]	center	Center of the sphere.
+	 * @param [out]	radius	Radius of the sphere.
+	 *
+	 * @returns	False if the mesh has no collision shape.
+	 */
+	bool getBoundingSphere(vec3& center, float& radius) const;
+
 	/**
 	 * @fn	static const std::vector<std::shared_ptr<class MeshComponent>> MeshComponent::GetMeshComponents();
 	 *
@@ -229,6 +274,12 @@ protected:
 	 */
 	class btCollisionShape* collisionShape = nullptr;
 
+	/** @brief	True if the mesh is rendered into shadow maps. */
+	bool castsShadows = true;
+
+	/** @brief	True if the mesh is kept in the cached shadow maps. */
+	bool staticShadowCaster = false;
+
 	/** @brief	Name of model that includes the scale. One
 	copy of each model will be loaded for specified scale */
 	string scaleMeshName;
@@ -16,6 +16,13 @@ ModelMeshComponent::ModelMeshComponent (string filePathAndName, GLuint shaderPro
 {
 }
 
+ModelMeshComponent::ModelMeshComponent(string filePathAndName, GLuint shaderProgram,
+									   const ConvexDecompositionSettings& decompositionSettings, int updateOrder)
+	: MeshComponent(shaderProgram, updateOrder), filePathAndName(filePathAndName),
+	  useConvexDecomposition(true), decompositionSettings(decompositionSettings)
+{
+}
+
 
 ModelMeshComponent::~ModelMeshComponent()
 {
@@ -32,6 +39,11 @@ void ModelMeshComponent::buildMesh()
 									+ " " + std::to_string(modelScale[1][1])
 									+ " " + std::to_string(modelScale[2][2]);
 
+	// Models with a decomposed collision shape are cached separately
+	if (useConvexDecomposition) {
+		this->scaleMeshName += " " + decompositionSettings.getKey();
+	}
+
 	if ( previsouslyLoaded() == false ){
 
 		// Model loading
@@ -61,7 +73,15 @@ void ModelMeshComponent::buildMesh()
 		and store them in a btCompoundShape.
 		*/
 		// Create compound shape to hold the shapes of the individual meshes
-		btCompoundShape* modelCompondShape = new btCompoundShape();
+		btCompoundShape* modelCompondShape = nullptr;
+
+		// Scaled positions and indices of all meshes for the convex decomposition
+		std::vector<vec3> modelPositions;
+		std::vector<unsigned int> modelIndices;
+
+		if (useConvexDecomposition == false) {
+			modelCompondShape = new btCompoundShape();
+		}
 
 		// Iterate through each mesh
 		for (size_t i = 0; i < scene->mNumMeshes; i++) {
@@ -70,10 +90,14 @@ void ModelMeshComponent::buildMesh()
 			aiMesh* mesh = scene->mMeshes[i];
 
 			// Create a collision shape for the sub mesh
-			btConvexHullShape* meshCollisionShape = new btConvexHullShape();
+			btConvexHullShape* meshCollisionShape = nullptr;
+
+			if (useConvexDecomposition == false) {
+				meshCollisionShape = new btConvexHullShape();
+			}
 
 			// Read in the vertex data associated with the model
-			readVertexData(mesh, vData, indices, *meshCollisionShape);
+			readVertexData(mesh, vData, indices, meshCollisionShape);
 
 			//// Read in the vertex data associated with the model
 			//readVertexData(mesh, vData, indices);
@@ -95,10 +119,27 @@ void ModelMeshComponent::buildMesh()
 
 			subMesh.material = material;
 
-			// Add the mesh collision shape for collision detection
-			// Do NOT use the default btTransform constructor for this! It  
-			// makes a zero matrix and everything disappears. No problem for collision spheres! 
-			modelCompondShape->addChildShape(btTransform(btQuaternion(0, 0, 0)), meshCollisionShape);
+			if (useConvexDecomposition) {
+
+				// Accumulate the scaled vertex positions and offset indices of this mesh
+				unsigned int baseIndex = static_cast<unsigned int>(modelPositions.size());
+
+				for (auto& vertex : vData) {
+					modelPositions.push_back(vec3(modelScale * vertex.m_pos));
+				}
+				for (auto index : indices) {
+					modelIndices.push_back(baseIndex + index);
+				}
+			}
+			else {
+
+				meshCollisionShape->recalcLocalAabb();
+
+				// Add the mesh collision shape for collision detection
+				// Do NOT use the default btTransform constructor for this! It  
+				// makes a zero matrix and everything disappears. No problem for collision spheres! 
+				modelCompondShape->addChildShape(btTransform(btQuaternion(0, 0, 0)), meshCollisionShape);
+			}
 
 			subMeshes.push_back(subMesh);
 
@@ -107,6 +148,15 @@ void ModelMeshComponent::buildMesh()
 
 		} // needs to be moved up
 
+		// Build a bounded number of tight convex pieces from all of the meshes
+		if (useConvexDecomposition) {
+			modelCompondShape = ConvexDecomposition::Decompose(modelPositions, modelIndices, decompositionSettings);
+
+			if (modelCompondShape == nullptr) {
+				modelCompondShape = new btCompoundShape();
+			}
+		}
+
 		// Set the collision shape for this model
 		this->collisionShape = modelCompondShape;
 
@@ -116,7 +166,7 @@ void ModelMeshComponent::buildMesh()
 } // end initialize
 
 
-void ModelMeshComponent::readVertexData(aiMesh* mesh, std::vector<pntVertexData>& vertexData, std::vector<unsigned int>& indices, btConvexHullShape& hull)
+void ModelMeshComponent::readVertexData(aiMesh* mesh, std::vector<pntVertexData>& vertexData, std::vector<unsigned int>& indices, btConvexHullShape* hull)
 {
 	// Read in vertex positions, normals, and texture coordinates. See 
 	// http://www.assimp.org/lib_html/structai_MeshComponent.html for more details
@@ -135,8 +185,11 @@ void ModelMeshComponent::readVertexData(aiMesh* mesh, std::vector<pntVertexData>
 			// shape will not be adjusted in the present implementation
 			vec4 scalePos = modelScale * tempPosition;
 
-			// Add the vertex for the collision shape
-			hull.addPoint(btVector3(scalePos.x, scalePos.y, scalePos.z), true);
+			// Add the vertex for the collision shape. The bounding box is
+			// recalculated once after all of the points have been added.
+			if (hull != nullptr) {
+				hull->addPoint(btVector3(scalePos.x, scalePos.y, scalePos.z), false);
+			}
 
 			// Read in vertex normal vectors
 			glm::vec3 tempNormal;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "MeshComponent.h"
+#include "ConvexDecomposition.h"
 
 /**
  * @class	ModelMesh
@@ -21,6 +22,22 @@ public:
 	 */
 	ModelMeshComponent(string filePathAndName, GLuint shaderProgram, int updateOrder = 100);
 
+	/**
+	 * @fn	ModelMeshComponent::ModelMeshComponent(string filePathAndName, GLuint shaderProgram, const ConvexDecompositionSettings& decompositionSettings, int updateOrder = 100);
+	 *
+	 * @brief	Constructor for a model whose collision shape is built using an approximate
+	 * 			convex decomposition of all of its sub-meshes instead of one convex hull per
+	 * 			sub-mesh. Gives accurate collisions for concave models. The decomposition is
+	 * 			cached along with the model.
+	 *
+	 * @param	filePathAndName		  	Relative path and file name for the model to be loaded.
+	 * @param	shaderProgram		  	Shader program that will be used to render the model.
+	 * @param	decompositionSettings	Settings that control the convex decomposition.
+	 * @param	updateOrder			  	(Optional) The update order of the component.
+	 */
+	ModelMeshComponent(string filePathAndName, GLuint shaderProgram, 
+					   const ConvexDecompositionSettings& decompositionSettings, int updateOrder = 100);
+
 	/**
 	 * @fn	ModelMeshComponent::~ModelMeshComponent();
 	 *
@@ -50,7 +67,7 @@ protected:
 	std::string getDirectoryPath(std::string sFilePath);
 
 	/**
-	 * @fn	void ModelMesh::readVertexData(aiMesh* mesh, std::vector<pntVertexData>& vertexData, std::vector<unsigned int>& indices, btConvexHullShape& hull);
+	 * @fn	void ModelMesh::readVertexData(aiMesh* mesh, std::vector<pntVertexData>& vertexData, std::vector<unsigned int>& indices, btConvexHullShape* hull);
 	 *
 	 * @brief	Reads vertex data and places it in data structures and variables that are passed
 	 * 			by reference.
@@ -58,9 +75,9 @@ protected:
 	 * @param [out]	mesh	  	If non-null, the mesh.
 	 * @param [out]	vertexData	Information describing the vertex.
 	 * @param [out]	indices   	The indices.
-	 * @param [out]	hull	  	The hull.
+	 * @param [out]	hull	  	If non-null, the hull to which scaled vertex positions are added.
 	 */
-	void readVertexData(struct aiMesh* mesh, std::vector<pntVertexData>& vertexData, std::vector<unsigned int>& indices, btConvexHullShape& hull);
+	void readVertexData(struct aiMesh* mesh, std::vector<pntVertexData>& vertexData, std::vector<unsigned int>& indices, btConvexHullShape* hull);
 
 	/**
 	 * @fn	Material* ModelMesh::readInMaterialProperties( aiMaterial* assimpMaterial, std::string filename);
@@ -82,5 +99,11 @@ protected:
 	 set before the model is loaded for this to be effective.*/
 	mat4 modelScale = mat4(1.0f);
 
+	/** @brief	True if the collision shape is built using a convex decomposition. */
+	bool useConvexDecomposition = false;
+
+	/** @brief	Settings used when useConvexDecomposition is true. */
+	ConvexDecompositionSettings decompositionSettings;
+
 }; // end ModelMeshComponent class
 
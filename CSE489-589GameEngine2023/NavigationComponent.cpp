@@ -0,0 +1,64 @@
+#include "NavigationComponent.h"
+
+#define VERBOSE false
+
+NavigationComponent::NavigationComponent(std::shared_ptr<NavigationGraph> graph, float speed, int updateOrder)
+	: Component(updateOrder), graph(graph), speed(speed)
+{
+
+} // end constructor
+
+
+void NavigationComponent::setDestination(int goalNode)
+{
+	int startNode = graph->findNearestNode(owningGameObject->getPosition(WORLD));
+
+	request = graph->requestPath(startNode, goalNode);
+
+	path = nullptr;
+	pathIndex = 0;
+
+} // end setDestination
+
+
+void NavigationComponent::update(const float& deltaTime)
+{
+	// Pick up the route once the worker has found it
+	if (request != nullptr && request->isReady()) {
+
+		path = request->path;
+		pathIndex = 0;
+		request = nullptr;
+
+		if (VERBOSE) cout << "Route with " << getPathLength() << " nodes received" << endl;
+	}
+
+	if (pathIndex >= getPathLength()) {
+		return;
+	}
+
+	vec3 position = owningGameObject->getPosition(WORLD);
+	float step = speed * deltaTime;
+
+	// Move through as many nodes as the step reaches
+	while (pathIndex < getPathLength()) {
+
+		vec3 target = graph->getNodePosition((*path)[pathIndex]);
+		vec3 toTarget = target - position;
+		float distance = glm::length(toTarget);
+
+		if (distance > step) {
+
+			position += toTarget * (step / distance);
+			owningGameObject->rotateTo(toTarget, WORLD);
+			break;
+		}
+
+		position = target;
+		step -= distance;
+		pathIndex++;
+	}
+
+	owningGameObject->setPosition(position, WORLD);
+
+} // end update
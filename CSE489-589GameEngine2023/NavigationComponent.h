@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Component.h"
+#include "NavigationGraph.h"
+
+/**
+ * @class	NavigationComponent
+ *
+ * @brief	Moves the owning game object along the shortest route through a
+ * 			NavigationGraph to a destination node. The route is found on a
+ * 			pathfinding worker thread. The object waits where it is until the
+ * 			route is ready.
+ */
+class NavigationComponent : public Component
+{
+public:
+
+	/**
+	 * @fn	NavigationComponent::NavigationComponent(std::shared_ptr<NavigationGraph> graph, float speed = 10.0f, int updateOrder = 100);
+	 *
+	 * @brief	Constructor
+	 *
+	 * @param	graph	   	The graph to navigate.
+	 * @param	speed	   	(Optional) The speed.
+	 * @param	updateOrder	(Optional) The update order.
+	 */
+	NavigationComponent(std::shared_ptr<NavigationGraph> graph, float speed = 10.0f, int updateOrder = 100);
+
+	virtual void update(const float& deltaTime) override;
+
+	/**
+	 * @fn	void NavigationComponent::setDestination(int goalNode);
+	 *
+	 * @brief	Requests a route from the node nearest the game object to a goal node.
+	 *
+	 * @param	goalNode	The goal node.
+	 */
+	void setDestination(int goalNode);
+
+	/**
+	 * @fn	bool NavigationComponent::hasArrived() const
+	 *
+	 * @brief	Checks if the game object has reached its destination or has no
+	 * 			route to it.
+	 */
+	bool hasArrived() const { return request == nullptr && pathIndex >= getPathLength(); }
+
+protected:
+
+	std::shared_ptr<NavigationGraph> graph;
+
+	float speed;
+
+	/** @brief	Route that is being found. Null once it has been received. */
+	std::shared_ptr<PathRequest> request;
+
+	int getPathLength() const { return (path != nullptr) ? static_cast<int>(path->size()) : 0; }
+
+	/** @brief	Nodes along the route, shared with the path cache of the graph. */
+	std::shared_ptr<const std::vector<int>> path;
+
+	/** @brief	Index of the next node to move to. */
+	int pathIndex = 0;
+
+}; // end NavigationComponent class
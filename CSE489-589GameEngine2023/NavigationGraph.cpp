@@ -0,0 +1,381 @@
+#include "NavigationGraph.h"
+
+#include <algorithm>
+
+#include "GameObject.h"
+
+#define VERBOSE false
+
+// ***** Definition of static members of the NavigationGraph class *****
+std::vector<std::thread> NavigationGraph::workers;
+
+std::deque<std::shared_ptr<PathRequest>> NavigationGraph::pendingRequests;
+
+std::mutex NavigationGraph::requestMutex;
+
+std::condition_variable NavigationGraph::requestPosted;
+
+bool NavigationGraph::quitWorkers = false;
+
+// ********************************************************************
+
+/**
+ * @struct	SearchArrays
+ *
+ * @brief	Working storage for A*. Each thread reuses its own. Entries are only
+ * 			valid when their stamp matches the stamp of the current search, so
+ * 			nothing has to be cleared between searches.
+ */
+struct SearchArrays
+{
+	struct HeapEntry
+	{
+		float estimate;
+		int node;
+
+		// Orders the heap with the smallest estimate on top
+		bool operator<(const HeapEntry& other) const { return estimate > other.estimate; }
+	};
+
+	std::vector<float> cost;
+	std::vector<int> parent;
+	std::vector<unsigned int> openedStamp;
+	std::vector<unsigned int> closedStamp;
+	std::vector<HeapEntry> heap;
+
+	unsigned int stamp = 0;
+
+	void begin(int numNodes)
+	{
+		if (static_cast<int>(cost.size()) < numNodes) {
+
+			cost.resize(numNodes);
+			parent.resize(numNodes);
+			openedStamp.resize(numNodes, 0);
+			closedStamp.resize(numNodes, 0);
+		}
+
+		heap.clear();
+
+		// Start again from zero rather than wrap onto stale stamps
+		if (++stamp == 0) {
+
+			std::fill(openedStamp.begin(), openedStamp.end(), 0);
+			std::fill(closedStamp.begin(), closedStamp.end(), 0);
+			stamp = 1;
+		}
+	}
+};
+
+static thread_local SearchArrays searchArrays;
+
+// Key of the path between two nodes in the path cache
+static unsigned long long pathKey(int start, int goal)
+{
+	return (static_cast<unsigned long long>(static_cast<unsigned int>(start)) << 32) | static_cast<unsigned int>(goal);
+}
+
+
+int NavigationGraph::addNode(const vec3& position)
+{
+	nodePositions.push_back(position);
+	edges.emplace_back();
+
+	clearPathCache();
+
+	return static_cast<int>(nodePositions.size()) - 1;
+
+} // end addNode
+
+
+int NavigationGraph::addNode(std::shared_ptr<GameObject> waypoint)
+{
+	return addNode(waypoint->getPosition(WORLD));
+
+} // end addNode
+
+
+void NavigationGraph::addEdge(int from, int to, bool bothWays)
+{
+	float cost = glm::distance(nodePositions[from], nodePositions[to]);
+
+	edges[from].push_back({ to, cost });
+
+	if (bothWays) {
+		edges[to].push_back({ from, cost });
+	}
+
+	// A shorter path may now exist
+	clearPathCache();
+
+} // end addEdge
+
+
+void NavigationGraph::connectNodesWithin(float maxDistance)
+{
+	for (int a = 0; a < getNumNodes(); a++) {
+
+		for (int b = a + 1; b < getNumNodes(); b++) {
+
+			if (glm::distance(nodePositions[a], nodePositions[b]) <= maxDistance) {
+				addEdge(a, b);
+			}
+		}
+	}
+
+} // end connectNodesWithin
+
+
+int NavigationGraph::findNearestNode(const vec3& position) const
+{
+	int nearest = -1;
+	float nearestDistance = POS_INFINITY;
+
+	for (int i = 0; i < getNumNodes(); i++) {
+
+		float distance = glm::distance(nodePositions[i], position);
+
+		if (distance < nearestDistance) {
+
+			nearest = i;
+			nearestDistance = distance;
+		}
+	}
+
+	return nearest;
+
+} // end findNearestNode
+
+
+bool NavigationGraph::findPath(int start, int goal, std::vector<int>& path) const
+{
+	path.clear();
+
+	if (start < 0 || goal < 0 || start >= getNumNodes() || goal >= getNumNodes()) {
+		return false;
+	}
+
+	SearchArrays& search = searchArrays;
+	search.begin(getNumNodes());
+
+	const vec3& goalPosition = nodePositions[goal];
+
+	search.cost[start] = 0.0f;
+	search.parent[start] = -1;
+	search.openedStamp[start] = search.stamp;
+	search.heap.push_back({ glm::distance(nodePositions[start], goalPosition), start });
+
+	while (!search.heap.empty()) {
+
+		std::pop_heap(search.heap.begin(), search.heap.end());
+		int node = search.heap.back().node;
+		search.heap.pop_back();
+
+		// A node can be in the heap more than once. Only the cheapest counts.
+		if (search.closedStamp[node] == search.stamp) {
+			continue;
+		}
+		search.closedStamp[node] = search.stamp;
+
+		if (node == goal) {
+
+			for (int n = goal; n >= 0; n = search.parent[n]) {
+				path.push_back(n);
+			}
+			std::reverse(path.begin(), path.end());
+
+			return true;
+		}
+
+		for (const Edge& edge : edges[node]) {
+
+			if (search.closedStamp[edge.to] == search.stamp) {
+				continue;
+			}
+
+			float cost = search.cost[node] + edge.cost;
+
+			if (search.openedStamp[edge.to] != search.stamp || cost < search.cost[edge.to]) {
+
+				search.openedStamp[edge.to] = search.stamp;
+				search.cost[edge.to] = cost;
+				search.parent[edge.to] = node;
+
+				// Straight line distance never overestimates the remaining cost
+				search.heap.push_back({ cost + glm::distance(nodePositions[edge.to], goalPosition), edge.to });
+				std::push_heap(search.heap.begin(), search.heap.end());
+			}
+		}
+	}
+
+	return false;
+
+} // end findPath
+
+
+std::shared_ptr<const std::vector<int>> NavigationGraph::findCachedPath(unsigned long long key) const
+{
+	auto iter = pathCache.find(key);
+
+	if (iter == pathCache.end()) {
+		return nullptr;
+	}
+
+	pathUseOrder.splice(pathUseOrder.begin(), pathUseOrder, iter->second.use);
+
+	return iter->second.path;
+
+} // end findCachedPath
+
+
+void NavigationGraph::clearPathCache()
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+
+	pathCache.clear();
+	pathUseOrder.clear();
+	cacheVersion++;
+
+} // end clearPathCache
+
+
+std::shared_ptr<const std::vector<int>> NavigationGraph::getPath(int start, int goal) const
+{
+	unsigned long long key = pathKey(start, goal);
+	unsigned int version;
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+
+		auto cached = findCachedPath(key);
+		if (cached != nullptr) {
+			return cached;
+		}
+
+		version = cacheVersion;
+	}
+
+	// Search without holding the lock. Two threads may find the same path at
+	// the same time, in which case the first one to finish is kept.
+	auto path = std::make_shared<std::vector<int>>();
+	findPath(start, goal, *path);
+
+	std::lock_guard<std::mutex> lock(cacheMutex);
+
+	// The graph changed during the search
+	if (version != cacheVersion) {
+		return path;
+	}
+
+	auto cached = findCachedPath(key);
+	if (cached != nullptr) {
+		return cached;
+	}
+
+	if (pathCache.size() >= MAX_CACHED_PATHS) {
+
+		pathCache.erase(pathUseOrder.back());
+		pathUseOrder.pop_back();
+	}
+
+	pathUseOrder.push_front(key);
+	pathCache.emplace(key, CachedPath{ path, pathUseOrder.begin() });
+
+	return path;
+
+} // end getPath
+
+
+std::shared_ptr<PathRequest> NavigationGraph::requestPath(int start, int goal) const
+{
+	auto request = std::make_shared<PathRequest>();
+	request->start = start;
+	request->goal = goal;
+
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+
+		auto cached = findCachedPath(pathKey(start, goal));
+
+		if (cached != nullptr) {
+
+			request->path = cached;
+			request->ready.store(true, std::memory_order_release);
+			return request;
+		}
+	}
+
+	request->graph = shared_from_this();
+
+	{
+		std::lock_guard<std::mutex> lock(requestMutex);
+
+		// Start the workers with the first request. Leave one hardware thread for the game.
+		if (workers.empty()) {
+
+			quitWorkers = false;
+
+			int numWorkers = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+			for (int i = 0; i < numWorkers; i++) {
+				workers.emplace_back(&NavigationGraph::WorkerLoop);
+			}
+
+			if (VERBOSE) cout << "Started " << numWorkers << " pathfinding threads" << endl;
+		}
+
+		pendingRequests.push_back(request);
+	}
+	requestPosted.notify_one();
+
+	return request;
+
+} // end requestPath
+
+
+void NavigationGraph::WorkerLoop()
+{
+	while (true) {
+
+		std::shared_ptr<PathRequest> request;
+		{
+			std::unique_lock<std::mutex> lock(requestMutex);
+			requestPosted.wait(lock, [] { return quitWorkers || !pendingRequests.empty(); });
+
+			if (quitWorkers) {
+				return;
+			}
+
+			request = pendingRequests.front();
+			pendingRequests.pop_front();
+		}
+
+		request->path = request->graph->getPath(request->start, request->goal);
+		request->graph.reset();
+		request->ready.store(true, std::memory_order_release);
+	}
+
+} // end WorkerLoop
+
+
+void NavigationGraph::StopPathfinding()
+{
+	{
+		std::lock_guard<std::mutex> lock(requestMutex);
+		quitWorkers = true;
+	}
+	requestPosted.notify_all();
+
+	for (auto& worker : workers) {
+		worker.join();
+	}
+	workers.clear();
+
+	// Nobody is left to serve these
+	for (auto& request : pendingRequests) {
+
+		request->path = std::make_shared<std::vector<int>>();
+		request->graph.reset();
+		request->ready.store(true, std::memory_order_release);
+	}
+	pendingRequests.clear();
+
+} // end StopPathfinding
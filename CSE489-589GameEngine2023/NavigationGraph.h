@@ -0,0 +1,257 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <unordered_map>
+#include <list>
+
+#include "MathLibsConstsFuncs.h"
+
+using namespace constants_and_types;
+
+class GameObject;
+class NavigationGraph;
+
+/**
+ * @struct	PathRequest
+ *
+ * @brief	A path that is being found on a worker thread. Poll isReady each
+ * 			frame. Once it returns true the path can be read.
+ */
+struct PathRequest
+{
+	/** @brief	Nodes at the ends of the path. */
+	int start = -1;
+	int goal = -1;
+
+	/**
+	 * @fn	bool PathRequest::isReady() const
+	 *
+	 * @brief	Checks if the path has been found or shown not to exist.
+	 */
+	bool isReady() const { return ready.load(std::memory_order_acquire); }
+
+	/**
+	 * @fn	const std::vector<int>& PathRequest::getPath() const
+	 *
+	 * @brief	Gets the nodes along the path from start to goal. Empty if there
+	 * 			is no path. Only valid once isReady returns true.
+	 */
+	const std::vector<int>& getPath() const { return *path; }
+
+	/** @brief	The result. Shared with the path cache of the graph. */
+	std::shared_ptr<const std::vector<int>> path;
+
+	/** @brief	Keeps the graph alive until the request has been served. */
+	std::shared_ptr<const NavigationGraph> graph;
+
+	/** @brief	Set by the worker thread after path has been written. */
+	std::atomic<bool> ready{ false };
+};
+
+/**
+ * @class	NavigationGraph
+ *
+ * @brief	Graph of waypoints connected by edges that agents can find routes
+ * 			through. The positions of the waypoints are read once when they are
+ * 			added. Routes are found with A* using a binary heap. Each thread
+ * 			keeps its own search arrays that are reused from one search to the
+ * 			next, so searches do not allocate once they have warmed up. Found
+ * 			routes are cached by their start and goal nodes. The cache holds
+ * 			up to MAX_CACHED_PATHS routes, dropping the least recently used,
+ * 			and is emptied whenever a node or edge is added.
+ *
+ * 			Requests made with requestPath are served by a small pool of worker
+ * 			threads shared by all graphs. The graph must not be changed while
+ * 			paths are being found.
+ */
+class NavigationGraph : public std::enable_shared_from_this<NavigationGraph>
+{
+public:
+
+	/** @brief	Number of paths kept in the path cache of each graph. */
+	static const size_t MAX_CACHED_PATHS = 1024;
+
+	/**
+	 * @fn	int NavigationGraph::addNode(const vec3& position);
+	 *
+	 * @brief	Adds a node.
+	 *
+	 * @param	position	Position of the node in World coordinates.
+	 *
+	 * @returns	The index of the node.
+	 */
+	int addNode(const vec3& position);
+
+	/**
+	 * @fn	int NavigationGraph::addNode(std::shared_ptr<GameObject> waypoint);
+	 *
+	 * @brief	Adds a node at the current World position of a waypoint.
+	 *
+	 * @param	waypoint	The waypoint. It must already be in the scene graph.
+	 *
+	 * @returns	The index of the node.
+	 */
+	int addNode(std::shared_ptr<GameObject> waypoint);
+
+	/**
+	 * @fn	void NavigationGraph::addEdge(int from, int to, bool bothWays = true);
+	 *
+	 * @brief	Connects two nodes. The cost of the edge is the distance between them.
+	 *
+	 * @param	from		The first node.
+	 * @param	to			The second node.
+	 * @param	bothWays	(Optional) True if the edge can be travelled in both directions.
+	 */
+	void addEdge(int from, int to, bool bothWays = true);
+
+	/**
+	 * @fn	void NavigationGraph::connectNodesWithin(float maxDistance);
+	 *
+	 * @brief	Connects every pair of nodes that are closer than a distance.
+	 *
+	 * @param	maxDistance	The maximum length of an edge.
+	 */
+	void connectNodesWithin(float maxDistance);
+
+	int getNumNodes() const { return static_cast<int>(nodePositions.size()); }
+
+	const vec3& getNodePosition(int node) const { return nodePositions[node]; }
+
+	/**
+	 * @fn	int NavigationGraph::findNearestNode(const vec3& position) const;
+	 *
+	 * @brief	Finds the node closest to a position.
+	 *
+	 * @param	position	The position in World coordinates.
+	 *
+	 * @returns	The index of the nearest node. Negative if the graph is empty.
+	 */
+	int findNearestNode(const vec3& position) const;
+
+	/**
+	 * @fn	bool NavigationGraph::findPath(int start, int goal, std::vector<int>& path) const;
+	 *
+	 * @brief	Finds the shortest path between two nodes with A*. Does not use
+	 * 			the cache. Safe to call from several threads at once.
+	 *
+	 * @param 	   	start	The start node.
+	 * @param 	   	goal 	The goal node.
+	 * @param [out]	path 	The nodes along the path including start and goal.
+	 *
+	 * @returns	True if there is a path.
+	 */
+	bool findPath(int start, int goal, std::vector<int>& path) const;
+
+	/**
+	 * @fn	std::shared_ptr<const std::vector<int>> NavigationGraph::getPath(int start, int goal) const;
+	 *
+	 * @brief	Gets the shortest path between two nodes from the cache, finding
+	 * 			it first if it is not there.
+	 *
+	 * @param	start	The start node.
+	 * @param	goal 	The goal node.
+	 *
+	 * @returns	The nodes along the path. Empty if there is no path.
+	 */
+	std::shared_ptr<const std::vector<int>> getPath(int start, int goal) const;
+
+	/**
+	 * @fn	std::shared_ptr<PathRequest> NavigationGraph::requestPath(int start, int goal) const;
+	 *
+	 * @brief	Finds a path on a worker thread. Paths that are already cached
+	 * 			are ready immediately. The graph must be owned by a shared_ptr.
+	 *
+	 * @param	start	The start node.
+	 * @param	goal 	The goal node.
+	 *
+	 * @returns	The request.
+	 */
+	std::shared_ptr<PathRequest> requestPath(int start, int goal) const;
+
+	/**
+	 * @fn	static void NavigationGraph::StopPathfinding();
+	 *
+	 * @brief	Stops the worker threads. Requests that have not been served are
+	 * 			completed without a path. Call when closing down.
+	 */
+	static void StopPathfinding();
+
+protected:
+
+	/**
+	 * @struct	Edge
+	 *
+	 * @brief	A connection to a neighbouring node.
+	 */
+	struct Edge
+	{
+		int to;
+		float cost;
+	};
+
+	/**
+	 * @fn	static void NavigationGraph::WorkerLoop();
+	 *
+	 * @brief	Body of each worker thread. Serves requests until StopPathfinding is called.
+	 */
+	static void WorkerLoop();
+
+	/**
+	 * @fn	std::shared_ptr<const std::vector<int>> NavigationGraph::findCachedPath(unsigned long long key) const;
+	 *
+	 * @brief	Looks up a path in the cache and marks it as the most recently used.
+	 * 			cacheMutex must be held.
+	 *
+	 * @returns	The path or null if it is not cached.
+	 */
+	std::shared_ptr<const std::vector<int>> findCachedPath(unsigned long long key) const;
+
+	/**
+	 * @fn	void NavigationGraph::clearPathCache();
+	 *
+	 * @brief	Forgets the cached paths. Called when the graph is changed.
+	 */
+	void clearPathCache();
+
+	/** @brief	Positions of the nodes in World coordinates. */
+	std::vector<vec3> nodePositions;
+
+	/** @brief	Outgoing edges of each node. */
+	std::vector<std::vector<Edge>> edges;
+
+	/**
+	 * @struct	CachedPath
+	 *
+	 * @brief	A path in the cache and its place in the order of use.
+	 */
+	struct CachedPath
+	{
+		std::shared_ptr<const std::vector<int>> path;
+		std::list<unsigned long long>::iterator use;
+	};
+
+	/** @brief	Paths that have been found, keyed by start and goal. */
+	mutable std::unordered_map<unsigned long long, CachedPath> pathCache;
+
+	/** @brief	Keys of the cached paths, most recently used first. */
+	mutable std::list<unsigned long long> pathUseOrder;
+
+	/** @brief	Incremented each time the cache is cleared. Paths found before that are not cached. */
+	mutable unsigned int cacheVersion = 0;
+
+	mutable std::mutex cacheMutex;
+
+	/** @brief	Worker threads shared by all graphs and the requests waiting for them. */
+	static std::vector<std::thread> workers;
+	static std::deque<std::shared_ptr<PathRequest>> pendingRequests;
+	static std::mutex requestMutex;
+	static std::condition_variable requestPosted;
+	static bool quitWorkers;
+
+}; // end NavigationGraph class
@@ -0,0 +1,48 @@
+#include "PathFollowerComponent.h"
+
+#define VERBOSE false
+
+PathFollowerComponent::PathFollowerComponent(std::shared_ptr<SplinePath> path, float speed, float startDistance, int updateOrder)
+	: Component(updateOrder), path(path), speed(speed), distance(path->wrapDistance(startDistance))
+{
+
+} // end constructor
+
+
+void PathFollowerComponent::initialize()
+{
+	moveToDistance();
+
+} // end initialize
+
+
+void PathFollowerComponent::update(const float& deltaTime)
+{
+	distance = path->wrapDistance(distance + speed * deltaTime);
+
+	moveToDistance();
+
+} // end update
+
+
+bool PathFollowerComponent::hasArrived() const
+{
+	if (path->isClosed()) {
+		return false;
+	}
+
+	return (speed >= 0.0f) ? distance >= path->getLength() : distance <= 0.0f;
+
+} // end hasArrived
+
+
+void PathFollowerComponent::moveToDistance()
+{
+	vec3 position, direction;
+	path->sample(distance, position, direction);
+
+	// Face the way the follower is moving
+	owningGameObject->setPosition(position, WORLD);
+	owningGameObject->rotateTo((speed < 0.0f) ? -direction : direction, WORLD);
+
+} // end moveToDistance
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Component.h"
+#include "SplinePath.h"
+
+/**
+ * @class	PathFollowerComponent
+ *
+ * @brief	Moves the owning game object along a SplinePath at a constant speed,
+ * 			facing the direction of travel. The position only depends on the
+ * 			distance travelled, so the motion is the same for any frame rate.
+ * 			Many followers can share one path.
+ */
+class PathFollowerComponent : public Component
+{
+public:
+
+	/**
+	 * @fn	PathFollowerComponent::PathFollowerComponent(std::shared_ptr<SplinePath> path, float speed = 10.0f, float startDistance = 0.0f, int updateOrder = 100);
+	 *
+	 * @brief	Constructor
+	 *
+	 * @param	path		 	The path to follow.
+	 * @param	speed		 	(Optional) Speed along the path. Negative speeds travel backwards.
+	 * @param	startDistance	(Optional) Distance along the path at which to start.
+	 * @param	updateOrder  	(Optional) The update order.
+	 */
+	PathFollowerComponent(std::shared_ptr<SplinePath> path, float speed = 10.0f, float startDistance = 0.0f, int updateOrder = 100);
+
+	virtual void initialize() override;
+
+	virtual void update(const float& deltaTime) override;
+
+	void setSpeed(float speed) { this->speed = speed; }
+
+	float getDistance() const { return distance; }
+
+	/**
+	 * @fn	bool PathFollowerComponent::hasArrived() const
+	 *
+	 * @brief	Checks if the follower has reached the end of an open path.
+	 */
+	bool hasArrived() const;
+
+protected:
+
+	/**
+	 * @fn	void PathFollowerComponent::moveToDistance();
+	 *
+	 * @brief	Places the owning game object at the current distance along the path.
+	 */
+	void moveToDistance();
+
+	std::shared_ptr<SplinePath> path;
+
+	float speed;
+
+	/** @brief	Distance travelled along the path. Kept within the length of the path. */
+	float distance;
+
+}; // end PathFollowerComponent class
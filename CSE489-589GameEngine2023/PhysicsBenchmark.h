@@ -0,0 +1,190 @@
+#pragma once
+
+#include "GameEngine.h"
+
+#include <chrono>
+
+/**
+ * @class	PhysicsBenchmark
+ *
+ * @brief	Scene that drops a few thousand dynamic boxes onto a stationary
+ * 			ground box and reports the average time spent stepping the physics
+ * 			engine. Run it with different thread counts to measure how the
+ * 			multithreaded pipeline scales. Optionally also measures the time to
+ * 			save and restore a snapshot of the deterministic simulation.
+ */
+class PhysicsBenchmark : public Game
+{
+public:
+
+	/**
+	 * @fn	PhysicsBenchmark::PhysicsBenchmark(bool multithreaded, int numThreads = 0, int numBodies = 3000, bool measureSnapshots = false)
+	 *
+	 * @brief	Constructor
+	 *
+	 * @param	multithreaded	 	True to use the multithreaded physics pipeline.
+	 * @param	numThreads   	 	(Optional) Number of physics threads. Zero uses all hardware threads.
+	 * @param	numBodies	 	 	(Optional) Number of dynamic rigid bodies.
+	 * @param	measureSnapshots	(Optional) True to step deterministically and measure snapshots.
+	 */
+	PhysicsBenchmark(bool multithreaded, int numThreads = 0, int numBodies = 3000, bool measureSnapshots = false)
+		: numBodies(numBodies), measureSnapshots(measureSnapshots)
+	{
+		this->multithreadedPhysics = multithreaded;
+		this->physicsThreadCount = numThreads;
+	}
+
+protected:
+
+	/** @brief	Number of dynamic rigid bodies in the scene. */
+	int numBodies;
+
+	/** @brief	Physics update times accumulated since the last report. */
+	double accumulatedPhysicsTime = 0.0;
+	int accumulatedUpdates = 0;
+
+	/** @brief	Physics update count when the time was last read. */
+	unsigned long long lastUpdateCount = 0;
+
+	/** @brief	True to save and restore a snapshot after every physics update. */
+	bool measureSnapshots;
+
+	/** @brief	Snapshot buffer. Reused so that saving does not allocate. */
+	std::vector<char> snapshot;
+
+	/** @brief	True once damaged snapshots have been checked. Done once the bodies collide. */
+	bool checkedDamagedSnapshots = false;
+
+	/** @brief	Snapshot save plus restore times accumulated since the last report. */
+	double accumulatedSnapshotTime = 0.0;
+
+	void loadScene() override
+	{
+		glfwSetWindowTitle(renderWindow, "Physics Benchmark");
+
+		glClearColor(0.5f, 0.5f, 0.5f, 1.0f);
+
+		ShaderInfo shaders[] = {
+			{ GL_VERTEX_SHADER, "Shaders/vertexShader.glsl" },
+			{ GL_FRAGMENT_SHADER, "Shaders/fragmentShader.glsl" },
+			{ GL_NONE, NULL } // signals that there are no more shaders
+		};
+
+		GLuint shaderProgram = BuildShaderProgram(shaders);
+
+		SharedMaterials::setUniformBlockForShader(shaderProgram);
+		SharedTransformations::setUniformBlockForShader(shaderProgram);
+		SharedLighting::setUniformBlockForShader(shaderProgram);
+		SharedFog::setUniformBlockForShader(shaderProgram);
+
+		// ***** Light *****
+		auto lightObject = std::make_shared<GameObject>();
+		addChildGameObject(lightObject);
+		lightObject->addComponent(std::make_shared<DirectionalLightComponent>(GLFW_KEY_D));
+		lightObject->rotateTo(vec3(-1.0f, -1.0f, -1.0f));
+
+		// ***** Ground *****
+		Material groundMat;
+		groundMat.setAmbientAndDiffuseMat(LIGHT_GREEN_RGBA);
+
+		auto groundObject = std::make_shared<GameObject>();
+		addChildGameObject(groundObject);
+		groundObject->setPosition(vec3(0.0f, -1.0f, 0.0f));
+		auto groundMesh = std::make_shared<BoxMeshComponent>(shaderProgram, groundMat, 200.0f, 2.0f, 200.0f);
+		groundObject->addComponent(groundMesh);
+		groundObject->addComponent(std::make_shared<RigidBodyComponent>(groundMesh, STATIONARY));
+
+		// ***** Boxes *****
+		// A single material lets every box share one cached mesh and collision shape.
+		Material boxMat;
+		boxMat.setAmbientAndDiffuseMat(LIGHT_BLUE_RGBA);
+
+		const int boxesPerSide = 20;
+		const float spacing = 2.5f;
+
+		for (int i = 0; i < numBodies; i++) {
+
+			int x = i % boxesPerSide;
+			int z = (i / boxesPerSide) % boxesPerSide;
+			int y = i / (boxesPerSide * boxesPerSide);
+
+			auto boxObject = std::make_shared<GameObject>();
+			addChildGameObject(boxObject);
+			boxObject->setPosition(vec3((x - boxesPerSide / 2) * spacing, 5.0f + y * spacing,
+										(z - boxesPerSide / 2) * spacing));
+
+			auto boxMesh = std::make_shared<BoxMeshComponent>(shaderProgram, boxMat);
+			boxObject->addComponent(boxMesh);
+			boxObject->addComponent(std::make_shared<RigidBodyComponent>(boxMesh, DYNAMIC));
+		}
+
+		// ***** Camera *****
+		auto cameraObject = std::make_shared<GameObject>();
+		addChildGameObject(cameraObject);
+		cameraObject->setPosition(vec3(0.0f, 60.0f, 120.0f));
+		cameraObject->rotateTo(vec3(0.0f, -60.0f, -120.0f));
+		cameraObject->addComponent(std::make_shared<CameraComponent>());
+
+		if (measureSnapshots) {
+			PhysicsEngine::SetDeterministic(true);
+		}
+
+		cout << "Physics benchmark: " << numBodies << " bodies, "
+			 << (multithreadedPhysics ? "multithreaded" : "single threaded")
+			 << (measureSnapshots ? ", deterministic" : "") << endl;
+
+	} // end loadScene
+
+	void updateGame() override
+	{
+		Game::updateGame();
+
+		// The game only steps the physics engine at the frame rate. The count
+		// is unchanged if there was no step since the last time it was read.
+		if (PhysicsEngine::GetUpdateCount() != lastUpdateCount) {
+
+			accumulatedPhysicsTime += PhysicsEngine::GetLastUpdateTime();
+			accumulatedUpdates++;
+			lastUpdateCount = PhysicsEngine::GetUpdateCount();
+
+			if (measureSnapshots) {
+
+				// Restoring the snapshot that was just saved leaves the simulation unchanged
+				auto start = std::chrono::steady_clock::now();
+
+				PhysicsEngine::SaveSnapshot(snapshot);
+				PhysicsEngine::RestoreSnapshot(snapshot);
+
+				accumulatedSnapshotTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+				// Bad snapshots must be rejected without touching the world. Checked once
+				// there are collision pairs so that a bad pair index is also tried.
+				if (!checkedDamagedSnapshots && PhysicsEngine::GetNumCollisionPairs() > 0) {
+
+					cout << "Damaged snapshots "
+						 << (PhysicsEngine::CheckDamagedSnapshots() ? "are rejected." : "ARE NOT REJECTED CORRECTLY!") << endl;
+					checkedDamagedSnapshots = true;
+				}
+			}
+		}
+
+		// Report the average physics update time every few seconds
+		if (accumulatedUpdates == 300) {
+
+			cout << "Average physics update: " << 1000.0 * accumulatedPhysicsTime / accumulatedUpdates
+				 << " ms" << endl;
+
+			if (measureSnapshots) {
+
+				cout << "Average snapshot save and restore: " << 1000.0 * accumulatedSnapshotTime / accumulatedUpdates
+					 << " ms (" << snapshot.size() << " bytes)" << endl;
+			}
+
+			accumulatedPhysicsTime = 0.0;
+			accumulatedSnapshotTime = 0.0;
+			accumulatedUpdates = 0;
+		}
+
+	} // end updateGame
+
+}; // end PhysicsBenchmark class
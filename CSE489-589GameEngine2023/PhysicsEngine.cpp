@@ -1,6 +1,14 @@
 #include "PhysicsEngine.h"
 
 #include "RigidBodyComponent.h"
+#include "CollisionLayers.h"
+
+#include "Bullet/BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h"
+#include "Bullet/BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h"
+#include "Bullet/BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h"
+
+#include <chrono>
+#include <cstring>
 
 #define VERBOSE false
 
@@ -8,13 +16,60 @@
 btBroadphaseInterface* PhysicsEngine::broadphase;
 btDefaultCollisionConfiguration* PhysicsEngine::collisionConfiguration;
 btCollisionDispatcher* PhysicsEngine::dispatcher;
-btSequentialImpulseConstraintSolver* PhysicsEngine::solver;
+btConstraintSolver* PhysicsEngine::solver;
+btGhostPairCallback* PhysicsEngine::ghostPairCallback = nullptr;
+btOverlapFilterCallback* PhysicsEngine::overlapFilterCallback = nullptr;
+btConstraintSolverPoolMt* PhysicsEngine::solverPool = nullptr;
+PhysicsTaskScheduler* PhysicsEngine::taskScheduler = nullptr;
 btDiscreteDynamicsWorld* PhysicsEngine::dynamicsWorld;
+double PhysicsEngine::lastUpdateTime = 0.0;
+unsigned long long PhysicsEngine::updateCount = 0;
 
-// Set containing the collision pairs from the last update
+// Sorted collision pairs from the last and the current update
 CollisionPairs PhysicsEngine::colPairsLastUpdate;
+CollisionPairs PhysicsEngine::colPairsThisUpdate;
+
+// Collision events buffered during the current update
+std::vector<CollisionEventRecord> PhysicsEngine::collisionEvents;
+
+// Bodies moved by the simulation and kinematic bodies moved by the game
+std::vector<RigidBodyComponent*> PhysicsEngine::movedBodies[BT_MAX_THREAD_COUNT];
+std::vector<RigidBodyComponent*> PhysicsEngine::movedKinematicBodies;
+
+// Deterministic stepping
+bool PhysicsEngine::deterministic = false;
+btScalar PhysicsEngine::fixedTimeStep = btScalar(1 / 60.0f);
+double PhysicsEngine::stepAccumulator = 0.0;
+unsigned long long PhysicsEngine::simulationTick = 0;
+
+// Manifolds of the dispatcher and of a snapshot sorted by their bodies
+std::vector<PhysicsEngine::ManifoldKey> PhysicsEngine::manifoldKeys;
+std::vector<PhysicsEngine::ManifoldKey> PhysicsEngine::savedManifoldKeys;
+
+// Bodies removed since the last update
+std::vector<const btCollisionObject*> PhysicsEngine::removedBodies;
+std::vector<const btCollisionObject*> PhysicsEngine::removedBodiesThisUpdate;
+
+/**
+ * Replaces the group and mask test of the broadphase. Setting a filter group and
+ * mask for each body replaces the StaticFilter group that Bullet normally uses
+ * to keep static bodies apart, so stationary bodies on interacting layers are
+ * rejected here instead.
+ */
+struct LayerOverlapFilterCallback : public btOverlapFilterCallback
+{
+	virtual bool needBroadphaseCollision(btBroadphaseProxy* proxy0, btBroadphaseProxy* proxy1) const override
+	{
+		// Same test as the default filter of the pair cache
+		bool collides = (proxy0->m_collisionFilterGroup & proxy1->m_collisionFilterMask) != 0 &&
+						(proxy1->m_collisionFilterGroup & proxy0->m_collisionFilterMask) != 0;
+
+		return collides && !(proxy0->m_collisionFilterGroup & proxy1->m_collisionFilterGroup & CollisionLayers::STATIONARY_GROUP);
+	}
+};
 
-bool PhysicsEngine::Init()
+
+bool PhysicsEngine::Init(bool multithreaded, int numThreads)
 {
 	// Bullet uses a right-handed coordinate system.
 	// btScalar is a floating point number
@@ -39,31 +94,80 @@ bool PhysicsEngine::Init()
 	broadphase = new btDbvtBroadphase();
 
 	/*
-	Set algorithms used for narrow phase collision detection to default.
-	*/
-	collisionConfiguration = new btDefaultCollisionConfiguration();
-
-	/*
-	btCollisionDispatcher supports algorithms that handle ConvexConvex
-	and ConvexConcave collision pairs
+	Trigger volumes are ghost objects. The callback maintains the list of
+	objects that overlap each ghost.
 	*/
-	dispatcher = new btCollisionDispatcher(collisionConfiguration);
+	ghostPairCallback = new btGhostPairCallback();
+	broadphase->getOverlappingPairCache()->setInternalGhostPairCallback(ghostPairCallback);
 
 	/*
-	This is what causes the objects to interact properly, taking
-	into account gravity, game logic supplied forces, collisions, and
-	hinge constraints.
-
-	The btSequentialImpulseConstraintSolver is a fast SIMD implementation
-	of the Projected Gauss Seidel (iterative LCP) method.
+	Only bodies in layers that interact are paired, and stationary bodies are
+	never paired with each other.
 	*/
-	solver = new btSequentialImpulseConstraintSolver;
+	overlapFilterCallback = new LayerOverlapFilterCallback();
+	broadphase->getOverlappingPairCache()->setOverlapFilterCallback(overlapFilterCallback);
 
 	/*
-	Entire physics pipeline computation and its data structures are represented in Bullet by a
-	dynamics world. Create a btDiscreteDynamicsWorld or btSoftRigidDynamicsWorld.
+	Set algorithms used for narrow phase collision detection to default.
+	The multithreaded pipeline uses larger pools so that they do not need to 
+	grow while worker threads are allocating from them.
 	*/
-	dynamicsWorld = new btDiscreteDynamicsWorld(dispatcher, broadphase, solver, collisionConfiguration);
+	btDefaultCollisionConstructionInfo constructionInfo;
+	if (multithreaded) {
+		constructionInfo.m_defaultMaxPersistentManifoldPoolSize = 80000;
+		constructionInfo.m_defaultMaxCollisionAlgorithmPoolSize = 80000;
+	}
+	collisionConfiguration = new btDefaultCollisionConfiguration(constructionInfo);
+
+	if (multithreaded) {
+
+		/*
+		Bullet distributes its parallel loops (narrow phase, island solving,
+		integration) through the task scheduler. Our own thread pool is used
+		rather than one of the schedulers that ship with Bullet.
+		*/
+		taskScheduler = new PhysicsTaskScheduler(numThreads);
+		btSetTaskScheduler(taskScheduler);
+
+		/*
+		btCollisionDispatcherMt performs narrow phase collision detection on 
+		the worker threads.
+		*/
+		dispatcher = new btCollisionDispatcherMt(collisionConfiguration);
+
+		/*
+		Simulation islands are solved in parallel, each by one of the solvers
+		in the pool. Large islands are solved by the multithreaded solver.
+		*/
+		solverPool = new btConstraintSolverPoolMt(taskScheduler->getNumThreads());
+		solver = new btSequentialImpulseConstraintSolverMt();
+
+		dynamicsWorld = new btDiscreteDynamicsWorldMt(dispatcher, broadphase, solverPool, solver, collisionConfiguration);
+	}
+	else {
+
+		/*
+		btCollisionDispatcher supports algorithms that handle ConvexConvex
+		and ConvexConcave collision pairs
+		*/
+		dispatcher = new btCollisionDispatcher(collisionConfiguration);
+
+		/*
+		This is what causes the objects to interact properly, taking
+		into account gravity, game logic supplied forces, collisions, and
+		hinge constraints.
+
+		The btSequentialImpulseConstraintSolver is a fast SIMD implementation
+		of the Projected Gauss Seidel (iterative LCP) method.
+		*/
+		solver = new btSequentialImpulseConstraintSolver;
+
+		/*
+		Entire physics pipeline computation and its data structures are represented in Bullet by a
+		dynamics world. Create a btDiscreteDynamicsWorld or btSoftRigidDynamicsWorld.
+		*/
+		dynamicsWorld = new btDiscreteDynamicsWorld(dispatcher, broadphase, solver, collisionConfiguration);
+	}
 
 	// Set gravity direction in the dynamics world.
 	dynamicsWorld->setGravity(btVector3(0.0f, -9.8f, 0.0f));
@@ -72,7 +176,8 @@ bool PhysicsEngine::Init()
 	// the physics engine updates. 
 	dynamicsWorld->setInternalTickCallback(PhysicsEngine::collisionEventCallback, nullptr, false);
 
-	if (VERBOSE) std::cout << "******** Bullet Physics Engine successfully initiliazed. **************" << std::endl;
+	if (VERBOSE) std::cout << "******** Bullet Physics Engine successfully initiliazed"
+						   << (multithreaded ? " (multithreaded)" : "") << ". **************" << std::endl;
 
 	return true;
 
@@ -85,11 +190,87 @@ void PhysicsEngine::Update(const float& deltaTime)
 	// variability in deltaTime performing interpolation up to 10 interpolation steps.
 	// Each internal interpolation step will be a 60th of a second. deltaTime should
 	// always be less than 10 * (1/60).
-	dynamicsWorld->stepSimulation(deltaTime, 10, btScalar(1 / 60.0f));
+	auto start = std::chrono::steady_clock::now();
+
+	// Bullet reads the transform of each kinematic body on every internal step. Read
+	// the ones that moved from the scene graph once per update instead.
+	SyncKinematicBodies();
+
+	if (deterministic) {
+
+		// Only take whole steps. The remainder is carried to the next update.
+		stepAccumulator += deltaTime;
+		int numSteps = static_cast<int>(stepAccumulator / fixedTimeStep);
+		stepAccumulator -= numSteps * fixedTimeStep;
+
+		// Do not fall further behind than the variable step mode would
+		numSteps = std::min(numSteps, 10);
+
+		for (int i = 0; i < numSteps; i++) {
+
+			// A maximum of zero substeps makes Bullet take exactly one step of the given size
+			dynamicsWorld->stepSimulation(fixedTimeStep, 0);
+			simulationTick++;
+		}
+	}
+	else {
+
+		dynamicsWorld->stepSimulation(deltaTime, 10, btScalar(1 / 60.0f));
+	}
+
+	// Move the game objects of the bodies that Bullet moved
+	SyncMovedBodies();
+
+	// Pass the collision events from all of the internal ticks to the game engine
+	DispatchCollisionEvents();
+
+	lastUpdateTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	updateCount++;
 
 } // end Update
 
 
+void PhysicsEngine::SetDeterministic(bool deterministic, float fixedTimeStep, int solverIterations)
+{
+	PhysicsEngine::deterministic = deterministic;
+	PhysicsEngine::fixedTimeStep = btScalar(fixedTimeStep);
+	stepAccumulator = 0.0;
+
+	// Process overlapping pairs sorted by the unique ids of their proxies rather
+	// than in the order of the hash table
+	dynamicsWorld->getDispatchInfo().m_deterministicOverlappingPairs = deterministic;
+
+	if (deterministic) {
+
+		btContactSolverInfo& solverInfo = dynamicsWorld->getSolverInfo();
+		solverInfo.m_numIterations = solverIterations;
+		solverInfo.m_solverMode &= ~SOLVER_RANDMIZE_ORDER;
+	}
+
+	if (VERBOSE && deterministic && taskScheduler != nullptr) {
+		std::cout << "Deterministic stepping with the multithreaded pipeline is not guaranteed." << std::endl;
+	}
+
+} // end SetDeterministic
+
+
+void PhysicsEngine::StepDeterministic(int numSteps)
+{
+	SyncKinematicBodies();
+
+	for (int i = 0; i < numSteps; i++) {
+
+		dynamicsWorld->stepSimulation(fixedTimeStep, 0);
+		simulationTick++;
+	}
+
+	SyncMovedBodies();
+
+	DispatchCollisionEvents();
+
+} // end StepDeterministic
+
+
 void PhysicsEngine::Stop()
 {
 	/* Smart pointers are connected to some objects in the physics engine.
@@ -99,9 +280,22 @@ void PhysicsEngine::Stop()
 	delete dynamicsWorld;
 	dynamicsWorld = nullptr;
 	delete solver;
+	delete solverPool;
+	solverPool = nullptr;
 	delete collisionConfiguration;
 	delete dispatcher;
 	delete broadphase;
+	delete ghostPairCallback;
+	ghostPairCallback = nullptr;
+	delete overlapFilterCallback;
+	overlapFilterCallback = nullptr;
+
+	if (taskScheduler != nullptr) {
+
+		btSetTaskScheduler(nullptr);
+		delete taskScheduler;
+		taskScheduler = nullptr;
+	}
 
 	if (VERBOSE) std::cout << "******** Bullet Physics Engine Shut Down. **************" << std::endl;
 
@@ -110,8 +304,8 @@ void PhysicsEngine::Stop()
 
 void PhysicsEngine::collisionEventCallback(btDynamicsWorld* world, btScalar timeStep)
 {
-	// Set of collision pairs found during the current update
-	CollisionPairs colPairsThisUpdate;
+	// Reuse the storage from two updates ago for the pairs found during this update
+	colPairsThisUpdate.clear();
 
 	// Iterate through all of the manifolds in the dispatcher
 	// A contact manifold is a cache that contains all contact points between a pair of 
@@ -126,98 +320,129 @@ void PhysicsEngine::collisionEventCallback(btDynamicsWorld* world, btScalar time
 		// Ignore manifolds that have no contact points.
 		if (contactManifold->getNumContacts() > 0)
 		{
-			// get the two rigid bodies involved in the collision
-			const btRigidBody* pBody0 = static_cast<const btRigidBody*>(contactManifold->getBody0());
-			const btRigidBody* pBody1 = static_cast<const btRigidBody*>(contactManifold->getBody1());
+			// get the two collision objects involved in the collision. These are either
+			// rigid bodies or ghost objects.
+			const btCollisionObject* pBody0 = contactManifold->getBody0();
+			const btCollisionObject* pBody1 = contactManifold->getBody1();
 
 			// Order the pair using the pointer value.
 			bool const swapped = pBody0 > pBody1;
-			const btRigidBody* pSortedBodyA = swapped ? pBody1 : pBody0;
-			const btRigidBody* pSortedBodyB = swapped ? pBody0 : pBody1;
+			const btCollisionObject* pSortedBodyA = swapped ? pBody1 : pBody0;
+			const btCollisionObject* pSortedBodyB = swapped ? pBody0 : pBody1;
 
-			// Create the pair
-			CollisionPair thisPair = std::make_pair(pSortedBodyA, pSortedBodyB);
+			// Summarize the contact points. The manifold normal points from body1
+			// toward body0.
+			ContactPair thisPair;
+			thisPair.bodies = CollisionPair(pSortedBodyA, pSortedBodyB);
+			thisPair.point.setZero();
+			thisPair.impulse = 0.0f;
 
-			// insert the pair into the current list
-			colPairsThisUpdate.insert(thisPair);
+			for (int c = 0; c < contactManifold->getNumContacts(); c++) {
 
-			// If the pair is new one, generate a collision event 
-			if (colPairsLastUpdate.find(thisPair) == colPairsLastUpdate.end())
-			{
-				CollisionEnter((btRigidBody*)pBody0, (btRigidBody*)pBody1);
+				const btManifoldPoint& contactPoint = contactManifold->getContactPoint(c);
+				thisPair.point += contactPoint.getPositionWorldOnB();
+				thisPair.impulse += contactPoint.getAppliedImpulse();
 			}
+			thisPair.point /= btScalar(contactManifold->getNumContacts());
 
+			const btVector3& normalOnB = contactManifold->getContactPoint(0).m_normalWorldOnB;
+			thisPair.normal = swapped ? -normalOnB : normalOnB;
 
+			// insert the pair into the current list
+			colPairsThisUpdate.push_back(thisPair);
 		}
 	}
 
-	// Set of pairs removed during this update
-	CollisionPairs removedPairs;
+	// Sort the pairs so they can be merged against the last update. More than one
+	// manifold can exist for the same pair of bodies.
+	std::sort(colPairsThisUpdate.begin(), colPairsThisUpdate.end());
+	colPairsThisUpdate.erase(std::unique(colPairsThisUpdate.begin(), colPairsThisUpdate.end()), colPairsThisUpdate.end());
+
+	// Bodies that were removed since the last update are sorted so pairs that
+	// refer to them can be found with a binary search.
+	std::swap(removedBodies, removedBodiesThisUpdate);
+	bool const checkRemoved = removedBodiesThisUpdate.empty() == false;
+	if (checkRemoved) {
+		std::sort(removedBodiesThisUpdate.begin(), removedBodiesThisUpdate.end());
+	}
 
-	// Find the difference between gets colPairsLastUpdate and colPairsThisUpdate
-	// and push the difference into removedPairs
-	std::set_difference(colPairsLastUpdate.begin(), colPairsLastUpdate.end(),
-		colPairsThisUpdate.begin(), colPairsThisUpdate.end(),
-		std::inserter(removedPairs, removedPairs.begin()));
+	// Walk both sorted lists at once. Pairs only in this update are entering, pairs
+	// only in the last update are exiting, and pairs in both are staying. Events are
+	// buffered and dispatched after the update.
+	CollisionPairs::const_iterator last = colPairsLastUpdate.begin();
+	CollisionPairs::const_iterator current = colPairsThisUpdate.begin();
 
-	// Generate separation events for removed pairs
-	for (CollisionPairs::const_iterator iter = removedPairs.begin();
-		iter != removedPairs.end(); ++iter)
+	while (last != colPairsLastUpdate.end() || current != colPairsThisUpdate.end())
 	{
-		CollisionExit((btRigidBody*)iter->first, (btRigidBody*)iter->second);
-	}
+		if (last != colPairsLastUpdate.end() && checkRemoved &&
+			(std::binary_search(removedBodiesThisUpdate.begin(), removedBodiesThisUpdate.end(), last->bodies.first) ||
+			 std::binary_search(removedBodiesThisUpdate.begin(), removedBodiesThisUpdate.end(), last->bodies.second))) {
 
-	// Set of pairs removed during this update
-	CollisionPairs stayPairs;
+			// The body no longer exists. Drop the pair without an event.
+			++last;
+		}
+		else if (last == colPairsLastUpdate.end() || (current != colPairsThisUpdate.end() && *current < *last)) {
 
-	// Find the difference between gets colPairsLastUpdate and removedPairs
-	// and push the difference into stayPairs
-	std::set_difference(colPairsLastUpdate.begin(), colPairsLastUpdate.end(),
-		removedPairs.begin(), removedPairs.end(),
-		std::inserter(stayPairs, stayPairs.begin()));
+			collisionEvents.push_back({ COLLISION_ENTER, *current });
+			++current;
+		}
+		else if (current == colPairsThisUpdate.end() || *last < *current) {
 
-	// Generate stay events for pairs that have remained in contact
-	for (CollisionPairs::const_iterator iter = stayPairs.begin();
-		iter != stayPairs.end(); ++iter)
-	{
-		CollisionStay((btRigidBody*)iter->first, (btRigidBody*)iter->second);
+			collisionEvents.push_back({ COLLISION_EXIT, *last });
+			++last;
+		}
+		else {
+
+			collisionEvents.push_back({ COLLISION_STAY, *current });
+			++last;
+			++current;
+		}
 	}
 
-	// Save set of collision pairs for next update
-	colPairsLastUpdate = colPairsThisUpdate;
+	removedBodiesThisUpdate.clear();
+
+	// Save the collision pairs for the next update
+	std::swap(colPairsLastUpdate, colPairsThisUpdate);
 
 } // end collisionEventCallback
 
 
-void PhysicsEngine::CollisionEnter(const btRigidBody* rigBody0, const btRigidBody* rigBody1)
+void PhysicsEngine::DispatchCollisionEvents()
 {
-	const RigidBodyComponent* moState0 = static_cast<const RigidBodyComponent*>(rigBody0->getMotionState());
-	const RigidBodyComponent* moState1 = static_cast<const RigidBodyComponent*>(rigBody1->getMotionState());
+	for (const CollisionEventRecord& record : collisionEvents) {
 
-	moState0->CollisionEnter(moState1);
-	moState1->CollisionEnter(moState0);
+		// Every collision object in the world belongs to a RigidBodyComponent
+		const RigidBodyComponent* moState0 = static_cast<const RigidBodyComponent*>(record.contact.bodies.first->getUserPointer());
+		const RigidBodyComponent* moState1 = static_cast<const RigidBodyComponent*>(record.contact.bodies.second->getUserPointer());
 
-} // end CollisionEnter
+		CollisionEvent event;
 
-void PhysicsEngine::CollisionStay(const btRigidBody* rigBody0, const btRigidBody* rigBody1)
-{
-	const RigidBodyComponent* moState0 = static_cast<const RigidBodyComponent*>(rigBody0->getMotionState());
-	const RigidBodyComponent* moState1 = static_cast<const RigidBodyComponent*>(rigBody1->getMotionState());
+		if (record.type == COLLISION_EXIT) {
+
+			event.contactPoint = ZERO_V3;
+			event.normal = ZERO_V3;
+			event.impulse = 0.0f;
+		}
+		else {
 
-	moState0->CollisionStay(moState1);
-	moState1->CollisionStay(moState0);
+			event.contactPoint = vec3(record.contact.point.x(), record.contact.point.y(), record.contact.point.z());
+			event.normal = vec3(record.contact.normal.x(), record.contact.normal.y(), record.contact.normal.z());
+			event.impulse = record.contact.impulse;
+		}
 
-} // end CollisionExit
+		// The normal points toward the first body
+		event.other = moState1;
+		moState0->dispatchCollisionEvent(record.type, event);
 
-void PhysicsEngine::CollisionExit(const btRigidBody* rigBody0, const btRigidBody* rigBody1)
-{
-	const RigidBodyComponent* moState0 = static_cast<const RigidBodyComponent*>(rigBody0->getMotionState());
-	const RigidBodyComponent* moState1 = static_cast<const RigidBodyComponent*>(rigBody1->getMotionState());
+		event.other = moState0;
+		event.normal = -event.normal;
+		moState1->dispatchCollisionEvent(record.type, event);
+	}
 
-	moState0->CollisionExit(moState1);
-	moState1->CollisionExit(moState0);
+	// Keep the storage for the next update
+	collisionEvents.clear();
 
-} // end CollisionExit
+} // end DispatchCollisionEvents
 
 
 // Converts a glm::mat4 into a btTransform
@@ -259,47 +484,701 @@ glm::mat4 PhysicsEngine::convertTransform(const btTransform& trans)
 bool PhysicsEngine::checkForRayIntersection(glm::vec3 origin, glm::vec3 direction)
 {
 	// Make a ray using the origin and direction
-	glm::vec3 out_end = origin + direction * 1000.0f;
+	RayQuery query;
+	query.from = origin;
+	query.to = origin + direction * 1000.0f;
+
+	return RayCast(query).hasHit;
 
-	// Create a ray callback using the above array.
-	btCollisionWorld::ClosestRayResultCallback RayCallback(
-		btVector3(origin.x, origin.y, origin.z),
-		btVector3(out_end.x, out_end.y, out_end.z)
-		);
+} // checkForRayIntersection
 
-	// Use the callback to raytest against the world.
-	dynamicsWorld->rayTest(
-		btVector3(origin.x, origin.y, origin.z),
-		btVector3(out_end.x, out_end.y, out_end.z),
-		RayCallback
-		);
 
-	// If we have a hit, return the game object.
-	if (RayCallback.hasHit()) {
+// Number of queries in each chunk handed to a physics thread
+static const int QUERY_GRAIN_SIZE = 64;
 
-		//?????????????????????
-		//cout << "mesh " << (int)RayCallback.m_collisionObject->getUserPointer();
+// Fills in the rigid body component that owns a collision object
+static void setHitObject(QueryHit& hit, const btCollisionObject* collisionObject)
+{
+	hit.hasHit = true;
+	hit.collisionObject = collisionObject;
+	hit.rigidBody = static_cast<const RigidBodyComponent*>(collisionObject->getUserPointer());
+
+} // end setHitObject
+
+
+// Builds the transform of a query shape at a position
+static btTransform queryTransform(const ShapeQuery& query, const vec3& position)
+{
+	return btTransform(btQuaternion(query.orientation.x, query.orientation.y, query.orientation.z, query.orientation.w),
+					   btVector3(position.x, position.y, position.z));
+
+} // end queryTransform
+
+
+/**
+ * Keeps the deepest contact found by an overlap query. The query shape may be
+ * either body of a contact, depending on the collision algorithm that found it.
+ */
+struct OverlapResultCallback : public btCollisionWorld::ContactResultCallback
+{
+	const btCollisionObject& queryObject;
+	const btCollisionObject* deepestObject = nullptr;
+	btVector3 point;
+	btVector3 normal;
+	btScalar depth = 0.0f;
+
+	OverlapResultCallback(const btCollisionObject& queryObject) : queryObject(queryObject) {}
+
+	virtual btScalar addSingleResult(btManifoldPoint& cp,
+									 const btCollisionObjectWrapper* colObj0Wrap, int partId0, int index0,
+									 const btCollisionObjectWrapper* colObj1Wrap, int partId1, int index1) override
+	{
+		if (cp.getDistance() <= 0.0f && (deepestObject == nullptr || cp.getDistance() < depth)) {
+
+			bool queryIsBody0 = colObj0Wrap->getCollisionObject() == &queryObject;
+			const btCollisionObjectWrapper* hitWrap = queryIsBody0 ? colObj1Wrap : colObj0Wrap;
+
+			// The normal on B points from B toward A. Report the point on the object that
+			// was hit and its normal pointing toward the query shape.
+			deepestObject = hitWrap->getCollisionObject();
+			point = queryIsBody0 ? cp.getPositionWorldOnB() : cp.getPositionWorldOnA();
+			normal = queryIsBody0 ? cp.m_normalWorldOnB : -cp.m_normalWorldOnB;
+			depth = cp.getDistance();
+		}
+
+		return 0.0f;
 	}
+};
 
-	return RayCallback.hasHit();
 
-} // checkForRayIntersection
+/**
+ * Casts a range of rays.
+ */
+struct RayQueryLoop : public btIParallelForBody
+{
+	const RayQuery* queries;
+	QueryHit* results;
+
+	RayQueryLoop(const RayQuery* queries, QueryHit* results) : queries(queries), results(results) {}
+
+	virtual void forLoop(int iBegin, int iEnd) const override
+	{
+		for (int i = iBegin; i < iEnd; i++) {
+
+			const RayQuery& query = queries[i];
+			QueryHit& hit = results[i];
+			hit = QueryHit();
+
+			btVector3 from(query.from.x, query.from.y, query.from.z);
+			btVector3 to(query.to.x, query.to.y, query.to.z);
+
+			btCollisionWorld::ClosestRayResultCallback rayCallback(from, to);
+			rayCallback.m_collisionFilterMask = query.collisionFilterMask;
+
+			PhysicsEngine::dynamicsWorld->rayTest(from, to, rayCallback);
+
+			if (rayCallback.hasHit()) {
+
+				setHitObject(hit, rayCallback.m_collisionObject);
+				hit.point = vec3(rayCallback.m_hitPointWorld.x(), rayCallback.m_hitPointWorld.y(), rayCallback.m_hitPointWorld.z());
+				hit.normal = vec3(rayCallback.m_hitNormalWorld.x(), rayCallback.m_hitNormalWorld.y(), rayCallback.m_hitNormalWorld.z());
+				hit.fraction = rayCallback.m_closestHitFraction;
+			}
+		}
+	}
+};
+
+
+/**
+ * Sweeps or overlap tests a range of shapes. The shapes are created on the stack
+ * of the thread performing the query.
+ */
+struct ShapeQueryLoop : public btIParallelForBody
+{
+	const ShapeQuery* queries;
+	QueryHit* results;
+	bool sweep;
+
+	ShapeQueryLoop(const ShapeQuery* queries, QueryHit* results, bool sweep)
+		: queries(queries), results(results), sweep(sweep) {}
+
+	virtual void forLoop(int iBegin, int iEnd) const override
+	{
+		for (int i = iBegin; i < iEnd; i++) {
+
+			const ShapeQuery& query = queries[i];
+			QueryHit& hit = results[i];
+			hit = QueryHit();
+
+			btSphereShape sphere(query.halfExtents.x);
+			btBoxShape box(btVector3(query.halfExtents.x, query.halfExtents.y, query.halfExtents.z));
+			btConvexShape* shape = query.shape == QUERY_SPHERE ? static_cast<btConvexShape*>(&sphere) : &box;
+
+			if (sweep) {
+
+				btTransform from = queryTransform(query, query.from);
+				btTransform to = queryTransform(query, query.to);
+
+				btCollisionWorld::ClosestConvexResultCallback sweepCallback(from.getOrigin(), to.getOrigin());
+				sweepCallback.m_collisionFilterMask = query.collisionFilterMask;
+
+				PhysicsEngine::dynamicsWorld->convexSweepTest(shape, from, to, sweepCallback);
+
+				if (sweepCallback.hasHit()) {
+
+					setHitObject(hit, sweepCallback.m_hitCollisionObject);
+					hit.point = vec3(sweepCallback.m_hitPointWorld.x(), sweepCallback.m_hitPointWorld.y(), sweepCallback.m_hitPointWorld.z());
+					hit.normal = vec3(sweepCallback.m_hitNormalWorld.x(), sweepCallback.m_hitNormalWorld.y(), sweepCallback.m_hitNormalWorld.z());
+					hit.fraction = sweepCallback.m_closestHitFraction;
+				}
+			}
+			else {
+
+				btCollisionObject queryObject;
+				queryObject.setCollisionShape(shape);
+				queryObject.setWorldTransform(queryTransform(query, query.from));
+
+				OverlapResultCallback overlapCallback(queryObject);
+				overlapCallback.m_collisionFilterMask = query.collisionFilterMask;
+
+				PhysicsEngine::dynamicsWorld->contactTest(&queryObject, overlapCallback);
+
+				if (overlapCallback.deepestObject != nullptr) {
+
+					setHitObject(hit, overlapCallback.deepestObject);
+					hit.point = vec3(overlapCallback.point.x(), overlapCallback.point.y(), overlapCallback.point.z());
+					hit.normal = vec3(overlapCallback.normal.x(), overlapCallback.normal.y(), overlapCallback.normal.z());
+					hit.fraction = 0.0f;
+				}
+			}
+		}
+	}
+};
+
+
+void PhysicsEngine::RunQueries(int count, const btIParallelForBody& body)
+{
+	if (count == 0 || dynamicsWorld == nullptr) {
+		return;
+	}
+
+	// Queries only read the world, so they can share the physics threads. Parallel
+	// loops are only legal when Bullet is built for the multithreaded pipeline.
+	if (taskScheduler != nullptr) {
+
+		btParallelFor(0, count, QUERY_GRAIN_SIZE, body);
+	}
+	else {
+
+		body.forLoop(0, count);
+	}
+
+} // end RunQueries
+
+
+QueryHit PhysicsEngine::RayCast(const RayQuery& query)
+{
+	QueryHit hit;
+
+	if (dynamicsWorld != nullptr) {
+
+		RayQueryLoop(&query, &hit).forLoop(0, 1);
+	}
+
+	return hit;
+
+} // end RayCast
+
+
+void PhysicsEngine::RayCastBatch(const std::vector<RayQuery>& queries, std::vector<QueryHit>& results)
+{
+	results.assign(queries.size(), QueryHit());
+
+	if (queries.size() > 0) {
+
+		RunQueries(static_cast<int>(queries.size()), RayQueryLoop(&queries[0], &results[0]));
+	}
+
+} // end RayCastBatch
+
+
+void PhysicsEngine::SweepBatch(const std::vector<ShapeQuery>& queries, std::vector<QueryHit>& results)
+{
+	results.assign(queries.size(), QueryHit());
+
+	if (queries.size() > 0) {
+
+		RunQueries(static_cast<int>(queries.size()), ShapeQueryLoop(&queries[0], &results[0], true));
+	}
+
+} // end SweepBatch
+
+
+void PhysicsEngine::OverlapBatch(const std::vector<ShapeQuery>& queries, std::vector<QueryHit>& results)
+{
+	results.assign(queries.size(), QueryHit());
+
+	if (queries.size() > 0) {
+
+		RunQueries(static_cast<int>(queries.size()), ShapeQueryLoop(&queries[0], &results[0], false));
+	}
+
+} // end OverlapBatch
+
+void PhysicsEngine::AddMovedBody(RigidBodyComponent* body)
+{
+	// Bullet only synchronizes the motion states of active bodies
+	movedBodies[btGetCurrentThreadIndex()].push_back(body);
+
+} // end AddMovedBody
+
+
+void PhysicsEngine::AddKinematicBody(RigidBodyComponent* body)
+{
+	// Read the starting transform even if the game object never moves
+	movedKinematicBodies.push_back(body);
+
+} // end AddKinematicBody
 
-void PhysicsEngine::RemoveFromColPairsLastUpdate(const btMotionState* removed)
+
+void PhysicsEngine::RemoveKinematicBody(RigidBodyComponent* body)
+{
+	movedKinematicBodies.erase(std::remove(movedKinematicBodies.begin(), movedKinematicBodies.end(), body),
+							   movedKinematicBodies.end());
+
+} // end RemoveKinematicBody
+
+
+void PhysicsEngine::SyncKinematicBodies()
 {
+	GameObject::CollectMovedKinematicBodies(movedKinematicBodies);
 
-	for (auto& pair : colPairsLastUpdate) {
+	// A body is found once for each of its ancestors that moved
+	std::sort(movedKinematicBodies.begin(), movedKinematicBodies.end());
+	movedKinematicBodies.erase(std::unique(movedKinematicBodies.begin(), movedKinematicBodies.end()),
+							   movedKinematicBodies.end());
 
-		if (removed == pair.first->getMotionState() || removed == pair.second->getMotionState()) {
+	for (RigidBodyComponent* body : movedKinematicBodies) {
+		body->cacheKinematicTransform();
+	}
 
-			if (VERBOSE) cout << "collision pair removed" << endl;
+	movedKinematicBodies.clear();
 
-			// Remove the pair. Collision exit events will not be sent.
-			colPairsLastUpdate.erase(pair);
+} // end SyncKinematicBodies
 
-			break;
 
+void PhysicsEngine::SyncMovedBodies()
+{
+	for (std::vector<RigidBodyComponent*>& threadBodies : movedBodies) {
+
+		for (RigidBodyComponent* body : threadBodies) {
+			body->syncSceneTransform();
 		}
+
+		// Keep the storage for the next update
+		threadBodies.clear();
 	}
+
+} // end SyncMovedBodies
+
+
+void PhysicsEngine::RemoveFromColPairsLastUpdate(const btCollisionObject* removed)
+{
+	if (VERBOSE) cout << "collision pairs removed" << endl;
+
+	// Pairs are dropped during the next update. Collision exit events will not be sent.
+	removedBodies.push_back(removed);
+
+} // end RemoveFromColPairsLastUpdate
+
+
+// Identifies a physics snapshot buffer
+static const unsigned int SNAPSHOT_MAGIC = 0x53594850;
+
+// Start of every snapshot
+struct SnapshotHeader
+{
+	unsigned int magic;
+	int numObjects;
+	int numManifolds;
+	int numPairs;
+	unsigned long long simulationTick;
+	double stepAccumulator;
+};
+
+// State of one collision object
+struct BodySnapshot
+{
+	btTransform worldTransform;
+	btTransform interpolationWorldTransform;
+	btVector3 linearVelocity;
+	btVector3 angularVelocity;
+	btVector3 interpolationLinearVelocity;
+	btVector3 interpolationAngularVelocity;
+	btScalar deactivationTime;
+	int activationState;
+};
+
+// Persistent manifold. Followed by numContacts btManifoldPoints.
+struct ManifoldSnapshot
+{
+	int body0;
+	int body1;
+	int numContacts;
+};
+
+// Collision pair from the last update
+struct PairSnapshot
+{
+	int first;
+	int second;
+	btVector3 point;
+	btVector3 normal;
+	btScalar impulse;
+};
+
+// Copies a value into a buffer and advances the write position
+template <typename T>
+static void writeSnapshot(char*& write, const T& value)
+{
+	memcpy(write, &value, sizeof(T));
+	write += sizeof(T);
+}
+
+// Copies a value out of a buffer and advances the read position
+template <typename T>
+static void readSnapshot(const char*& read, T& value)
+{
+	memcpy(&value, read, sizeof(T));
+	read += sizeof(T);
+}
+
+// Same as readSnapshot, but fails instead of reading past the end
+template <typename T>
+static bool readSnapshotChecked(const char*& read, const char* end, T& value)
+{
+	if (static_cast<size_t>(end - read) < sizeof(T)) {
+		return false;
+	}
+
+	readSnapshot(read, value);
+	return true;
 }
 
+// Walks a whole snapshot without changing anything. Snapshots can come from the
+// network or a replay file, so every count and index is checked before use.
+static bool validateSnapshot(const char* read, const char* end, int numObjects)
+{
+	SnapshotHeader header;
+
+	if (!readSnapshotChecked(read, end, header) || header.magic != SNAPSHOT_MAGIC ||
+		header.numObjects != numObjects || header.numManifolds < 0 || header.numPairs < 0) {
+		return false;
+	}
+
+	if (static_cast<size_t>(end - read) / sizeof(BodySnapshot) < static_cast<size_t>(numObjects)) {
+		return false;
+	}
+	read += numObjects * sizeof(BodySnapshot);
+
+	for (int i = 0; i < header.numManifolds; i++) {
+
+		ManifoldSnapshot manifold;
+
+		if (!readSnapshotChecked(read, end, manifold) ||
+			manifold.body0 < 0 || manifold.body0 >= numObjects ||
+			manifold.body1 < 0 || manifold.body1 >= numObjects ||
+			manifold.numContacts < 0 || manifold.numContacts > MANIFOLD_CACHE_SIZE ||
+			static_cast<size_t>(end - read) < manifold.numContacts * sizeof(btManifoldPoint)) {
+			return false;
+		}
+
+		read += manifold.numContacts * sizeof(btManifoldPoint);
+	}
+
+	for (int i = 0; i < header.numPairs; i++) {
+
+		PairSnapshot pair;
+
+		if (!readSnapshotChecked(read, end, pair) ||
+			pair.first < 0 || pair.first >= numObjects ||
+			pair.second < 0 || pair.second >= numObjects) {
+			return false;
+		}
+	}
+
+	// SaveSnapshot writes nothing after the pairs
+	return read == end;
+
+} // end validateSnapshot
+
+
+void PhysicsEngine::SortManifolds()
+{
+	manifoldKeys.clear();
+
+	for (int i = 0; i < dispatcher->getNumManifolds(); i++) {
+
+		btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(i);
+
+		manifoldKeys.push_back({ manifold->getBody0()->getWorldArrayIndex(),
+								 manifold->getBody1()->getWorldArrayIndex(), manifold, nullptr, 0 });
+	}
+
+	std::stable_sort(manifoldKeys.begin(), manifoldKeys.end());
+
+} // end SortManifolds
+
+
+void PhysicsEngine::SaveSnapshot(std::vector<char>& buffer)
+{
+	const btCollisionObjectArray& objects = dynamicsWorld->getCollisionObjectArray();
+
+	SortManifolds();
+
+	// Find the size of the snapshot. Empty manifolds are not saved.
+	int numManifolds = 0;
+	size_t size = sizeof(SnapshotHeader) + objects.size() * sizeof(BodySnapshot)
+				+ colPairsLastUpdate.size() * sizeof(PairSnapshot);
+
+	for (const ManifoldKey& key : manifoldKeys) {
+
+		if (key.manifold->getNumContacts() > 0) {
+
+			numManifolds++;
+			size += sizeof(ManifoldSnapshot) + key.manifold->getNumContacts() * sizeof(btManifoldPoint);
+		}
+	}
+
+	buffer.resize(size);
+	char* write = buffer.data();
+
+	SnapshotHeader header = { SNAPSHOT_MAGIC, objects.size(), numManifolds,
+							  static_cast<int>(colPairsLastUpdate.size()), simulationTick, stepAccumulator };
+	writeSnapshot(write, header);
+
+	for (int i = 0; i < objects.size(); i++) {
+
+		const btCollisionObject* object = objects[i];
+
+		BodySnapshot body;
+		body.worldTransform = object->getWorldTransform();
+		body.interpolationWorldTransform = object->getInterpolationWorldTransform();
+		body.interpolationLinearVelocity = object->getInterpolationLinearVelocity();
+		body.interpolationAngularVelocity = object->getInterpolationAngularVelocity();
+		body.deactivationTime = object->getDeactivationTime();
+		body.activationState = object->getActivationState();
+
+		const btRigidBody* rigidBody = btRigidBody::upcast(object);
+
+		if (rigidBody != nullptr) {
+
+			body.linearVelocity = rigidBody->getLinearVelocity();
+			body.angularVelocity = rigidBody->getAngularVelocity();
+		}
+		else {
+
+			body.linearVelocity.setZero();
+			body.angularVelocity.setZero();
+		}
+
+		writeSnapshot(write, body);
+	}
+
+	// The contact cache. Restoring it lets the solver warm start exactly as it
+	// would have if the simulation had not been rolled back.
+	for (const ManifoldKey& key : manifoldKeys) {
+
+		int numContacts = key.manifold->getNumContacts();
+
+		if (numContacts > 0) {
+
+			writeSnapshot(write, ManifoldSnapshot{ key.body0, key.body1, numContacts });
+
+			for (int c = 0; c < numContacts; c++) {
+				writeSnapshot(write, key.manifold->getContactPoint(c));
+			}
+		}
+	}
+
+	for (const ContactPair& pair : colPairsLastUpdate) {
+
+		writeSnapshot(write, PairSnapshot{ pair.bodies.first->getWorldArrayIndex(), pair.bodies.second->getWorldArrayIndex(),
+										   pair.point, pair.normal, pair.impulse });
+	}
+
+} // end SaveSnapshot
+
+
+bool PhysicsEngine::RestoreSnapshot(const std::vector<char>& buffer, int* droppedManifolds)
+{
+	btCollisionObjectArray& objects = dynamicsWorld->getCollisionObjectArray();
+
+	const char* read = buffer.data();
+	const char* end = read + buffer.size();
+
+	// Nothing is changed unless the whole snapshot is readable
+	if (!validateSnapshot(read, end, objects.size())) {
+
+		if (VERBOSE) cout << "Physics snapshot is damaged or does not match the world." << endl;
+		return false;
+	}
+
+	SnapshotHeader header;
+	readSnapshot(read, header);
+
+	simulationTick = header.simulationTick;
+	stepAccumulator = header.stepAccumulator;
+
+	for (int i = 0; i < objects.size(); i++) {
+
+		btCollisionObject* object = objects[i];
+
+		BodySnapshot body;
+		readSnapshot(read, body);
+
+		object->setWorldTransform(body.worldTransform);
+		object->setInterpolationWorldTransform(body.interpolationWorldTransform);
+		object->setInterpolationLinearVelocity(body.interpolationLinearVelocity);
+		object->setInterpolationAngularVelocity(body.interpolationAngularVelocity);
+		object->setDeactivationTime(body.deactivationTime);
+		object->forceActivationState(body.activationState);
+
+		btRigidBody* rigidBody = btRigidBody::upcast(object);
+
+		if (rigidBody != nullptr) {
+
+			rigidBody->setLinearVelocity(body.linearVelocity);
+			rigidBody->setAngularVelocity(body.angularVelocity);
+
+			// The world inertia tensor depends on the orientation
+			rigidBody->updateInertiaTensor();
+
+			// Move the game object of the body
+			if (!rigidBody->isStaticOrKinematicObject() && rigidBody->getMotionState() != nullptr) {
+				rigidBody->getMotionState()->setWorldTransform(body.worldTransform);
+			}
+		}
+	}
+
+	// Saved manifolds are already sorted by their bodies
+	savedManifoldKeys.clear();
+
+	for (int i = 0; i < header.numManifolds; i++) {
+
+		ManifoldSnapshot manifold;
+		readSnapshot(read, manifold);
+
+		savedManifoldKeys.push_back({ manifold.body0, manifold.body1, nullptr, read, manifold.numContacts });
+		read += manifold.numContacts * sizeof(btManifoldPoint);
+	}
+
+	// Copy the saved contact points into the manifolds of the same pairs of bodies.
+	// Manifolds that were empty when the snapshot was saved are emptied. Saved
+	// manifolds without a live match are dropped. See the header.
+	SortManifolds();
+
+	auto saved = savedManifoldKeys.begin();
+	int restoredManifolds = 0;
+
+	for (const ManifoldKey& live : manifoldKeys) {
+
+		while (saved != savedManifoldKeys.end() && *saved < live) {
+			++saved;
+		}
+
+		if (saved != savedManifoldKeys.end() && !(live < *saved)) {
+
+			const char* points = saved->savedPoints;
+
+			live.manifold->setNumContacts(saved->numSavedPoints);
+
+			for (int c = 0; c < saved->numSavedPoints; c++) {
+
+				btManifoldPoint& point = live.manifold->getContactPoint(c);
+				readSnapshot(points, point);
+				point.m_userPersistentData = nullptr;
+			}
+
+			++saved;
+			restoredManifolds++;
+		}
+		else {
+
+			live.manifold->clearManifold();
+		}
+	}
+
+	if (VERBOSE && restoredManifolds < header.numManifolds) {
+		cout << "Physics snapshot dropped " << header.numManifolds - restoredManifolds << " manifolds." << endl;
+	}
+
+	if (droppedManifolds != nullptr) {
+		*droppedManifolds = header.numManifolds - restoredManifolds;
+	}
+
+	colPairsLastUpdate.clear();
+
+	for (int i = 0; i < header.numPairs; i++) {
+
+		PairSnapshot pair;
+		readSnapshot(read, pair);
+
+		ContactPair contact;
+		contact.bodies = CollisionPair(objects[pair.first], objects[pair.second]);
+		contact.point = pair.point;
+		contact.normal = pair.normal;
+		contact.impulse = pair.impulse;
+
+		colPairsLastUpdate.push_back(contact);
+	}
+
+	// The pairs were saved sorted by the pointers of the same objects, so they are still sorted
+
+	SyncMovedBodies();
+
+	return true;
+
+} // end RestoreSnapshot
+
+
+bool PhysicsEngine::CheckDamagedSnapshots()
+{
+	const btCollisionObjectArray& objects = dynamicsWorld->getCollisionObjectArray();
+
+	// State that a partial restore would change
+	unsigned long long tick = simulationTick;
+	size_t numPairs = colPairsLastUpdate.size();
+	std::vector<btTransform> transforms;
+
+	for (int i = 0; i < objects.size(); i++) {
+		transforms.push_back(objects[i]->getWorldTransform());
+	}
+
+	std::vector<char> original;
+	SaveSnapshot(original);
+
+	std::vector<char> damaged(original.begin(), original.end() - 1);
+	bool rejected = !RestoreSnapshot(damaged);
+
+	if (numPairs > 0) {
+
+		// The last record of the snapshot is a collision pair
+		damaged = original;
+		PairSnapshot pair;
+		memcpy(&pair, damaged.data() + damaged.size() - sizeof(PairSnapshot), sizeof(PairSnapshot));
+		pair.second = objects.size();
+		memcpy(damaged.data() + damaged.size() - sizeof(PairSnapshot), &pair, sizeof(PairSnapshot));
+
+		rejected = rejected && !RestoreSnapshot(damaged);
+	}
+
+	bool unchanged = simulationTick == tick && colPairsLastUpdate.size() == numPairs;
+
+	for (int i = 0; i < objects.size() && unchanged; i++) {
+		unchanged = objects[i]->getWorldTransform() == transforms[i];
+	}
+
+	return rejected && unchanged;
+
+} // end CheckDamagedSnapshots
@@ -1,29 +1,158 @@
 #pragma once
 
 #include "Bullet/btBulletDynamicsCommon.h"
+#include "Bullet/BulletCollision/CollisionDispatch/btGhostObject.h"
 #include "MathLibsConstsFuncs.h"
+#include "Component.h"
+#include "PhysicsTaskScheduler.h"
 
-#include <set>			// For holding sets or collision pairs
-#include <algorithm>    // std::set_difference, std::sort
-#include <iterator>		// std::inserter
+#include <vector>		// For holding sorted collision pairs
+#include <algorithm>    // std::sort, std::unique, std::binary_search
 
 using namespace constants_and_types;
 
+// Forward declaration. Only used by the multithreaded pipeline.
+class btConstraintSolverPoolMt;
+
 // typedefs for collision events
-typedef std::pair<const btRigidBody*, const btRigidBody*> CollisionPair;
-typedef std::set<CollisionPair> CollisionPairs;
+typedef std::pair<const btCollisionObject*, const btCollisionObject*> CollisionPair;
+
+/**
+ * A pair of bodies in contact during an internal tick along with a summary of
+ * the contact. Pairs are ordered by the bodies only.
+ */
+struct ContactPair
+{
+	// The bodies ordered by pointer value
+	CollisionPair bodies;
+
+	// Average of the contact points in World coordinates
+	btVector3 point;
+
+	// Contact normal in World coordinates pointing from bodies.second toward bodies.first
+	btVector3 normal;
+
+	// Total impulse applied by the contact points
+	btScalar impulse;
+
+	bool operator<(const ContactPair& other) const { return bodies < other.bodies; }
+	bool operator==(const ContactPair& other) const { return bodies == other.bodies; }
+};
+
+typedef std::vector<ContactPair> CollisionPairs;
+
+/**
+ * Collision event buffered during a physics update. Buffered events are dispatched
+ * once after the update has finished.
+ */
+struct CollisionEventRecord
+{
+	COLLISION_EVENT_TYPE type;
+	ContactPair contact;
+};
+
+/**
+ * Collision event passed to the Components that listen for collisions.
+ */
+struct CollisionEvent
+{
+	// The rigid body that was collided with
+	const class RigidBodyComponent* other;
+
+	// Contact point in World coordinates. Zero for exit events.
+	vec3 contactPoint;
+
+	// Contact normal in World coordinates pointing from the other body toward this one.
+	// Zero for exit events.
+	vec3 normal;
+
+	// Total impulse applied during the last internal tick. Zero for exit events.
+	float impulse;
+};
+
+// Collision shapes that can be used by sweep and overlap queries
+enum QUERY_SHAPE_TYPE { QUERY_SPHERE, QUERY_BOX };
+
+/**
+ * Ray cast against the physics world. Only the closest hit is reported.
+ */
+struct RayQuery
+{
+	// Start and end of the ray in World coordinates
+	vec3 from = ZERO_V3;
+	vec3 to = ZERO_V3;
+
+	// Bullet collision filter mask. Objects whose group is not in the mask are ignored.
+	int collisionFilterMask = btBroadphaseProxy::AllFilter;
+};
+
+/**
+ * Sphere or box that is swept from one position to another or tested for overlap
+ * at a single position. Only the closest (sweep) or deepest (overlap) contact is
+ * reported.
+ */
+struct ShapeQuery
+{
+	QUERY_SHAPE_TYPE shape = QUERY_SPHERE;
+
+	// Half extents of a box. The x component is the radius of a sphere.
+	vec3 halfExtents = vec3(0.5f);
+
+	// Orientation of the shape in World coordinates
+	quat orientation = quat(1.0f, 0.0f, 0.0f, 0.0f);
+
+	// Start and end positions of a sweep in World coordinates. Overlap tests only use from.
+	vec3 from = ZERO_V3;
+	vec3 to = ZERO_V3;
+
+	// Bullet collision filter mask. Objects whose group is not in the mask are ignored.
+	int collisionFilterMask = btBroadphaseProxy::AllFilter;
+};
+
+/**
+ * Result of a ray, sweep, or overlap query.
+ */
+struct QueryHit
+{
+	bool hasHit = false;
+
+	// Rigid body component that owns the collision object that was hit. Null if there
+	// was no hit or if the collision object does not belong to a RigidBodyComponent.
+	const class RigidBodyComponent* rigidBody = nullptr;
+
+	// Bullet collision object that was hit
+	const btCollisionObject* collisionObject = nullptr;
+
+	// Point and surface normal of the hit in World coordinates
+	vec3 point = ZERO_V3;
+	vec3 normal = ZERO_V3;
+
+	// Fraction of the distance between from and to at which the hit occured. Zero for overlaps.
+	float fraction = 1.0f;
+};
 
 
 class PhysicsEngine
 {
 public:
 
-	static void RemoveFromColPairsLastUpdate(const btMotionState* removed);
+	/**
+	 * Stops collision events from being generated for a body that is being removed
+	 * from the simulation. The body is recorded and its pairs are dropped during the
+	 * next update, so this is O(1) no matter how many pairs the body is part of.
+	 * Collision exit events will not be sent for the removed body.
+	 * @param removed - body that is being removed. It is never dereferenced.
+	 */
+	static void RemoveFromColPairsLastUpdate(const btCollisionObject* removed);
 
 	/**
 	 * Initialize the engine.
+	 * @param multithreaded - true to use the multithreaded Bullet pipeline. Requires
+	 * Bullet to be built with BT_THREADSAFE.
+	 * @param numThreads - number of threads used by the multithreaded pipeline. Values
+	 * less than one use the number of hardware threads.
 	 */
-	static bool Init();
+	static bool Init(bool multithreaded = false, int numThreads = 0);
 
 	/**
 	 * Update the engine. Call this once each frame.
@@ -31,6 +160,79 @@ public:
 	 */
 	static void Update(const float& deltaTime = 0.0f);
 
+	/**
+	 * Switches deterministic stepping on or off. In deterministic mode Update only takes
+	 * whole steps of a fixed size, the solver uses a fixed number of iterations in a
+	 * fixed order, and overlapping pairs are processed in the order the bodies were
+	 * added. Two worlds built the same way then produce the same results for the same
+	 * inputs. Call after Init. The single threaded pipeline should be used.
+	 * @param deterministic - true to step deterministically.
+	 * @param fixedTimeStep - length of each step in seconds.
+	 * @param solverIterations - number of constraint solver iterations per step.
+	 */
+	static void SetDeterministic(bool deterministic, float fixedTimeStep = 1.0f / 60.0f, int solverIterations = 10);
+
+	/**
+	 * Takes a number of fixed steps regardless of the time that has passed. Used to
+	 * simulate forward again after a snapshot is restored. Only valid in deterministic mode.
+	 * @param numSteps - number of fixed steps.
+	 */
+	static void StepDeterministic(int numSteps = 1);
+
+	/**
+	 * Gets the number of fixed steps taken in deterministic mode. Saved in snapshots.
+	 */
+	static unsigned long long GetSimulationTick() { return simulationTick; }
+
+	/**
+	 * Gets the number of collision pairs found by the last update. Saved in snapshots.
+	 */
+	static int GetNumCollisionPairs() { return static_cast<int>(colPairsLastUpdate.size()); }
+
+	/**
+	 * Saves the complete state of the simulation to a binary buffer: the transforms,
+	 * velocities, and activation states of all collision objects, the contact points
+	 * of their persistent manifolds, and the collision pairs used for events.
+	 * @param buffer - resized to hold the snapshot. Reusing the same buffer avoids allocation.
+	 */
+	static void SaveSnapshot(std::vector<char>& buffer);
+
+	/**
+	 * Restores a snapshot saved by SaveSnapshot. The world must contain the same
+	 * collision objects, added in the same order, as when the snapshot was saved.
+	 * The game objects of the dynamic bodies are moved to the restored positions.
+	 *
+	 * Saved contact points are only written back into manifolds that exist in the
+	 * world. A manifold belongs to the collision algorithm of its broadphase pair,
+	 * so one that was destroyed after the snapshot was saved cannot be recreated
+	 * here. Its contacts are dropped and the solver starts that pair cold.
+	 * @param buffer - the snapshot.
+	 * @param droppedManifolds - if not null, set to the number of saved manifolds that had no live match.
+	 * @return true if the snapshot was restored. False if it is truncated, damaged, or
+	 *         does not match the world, in which case the world is left unchanged.
+	 */
+	static bool RestoreSnapshot(const std::vector<char>& buffer, int* droppedManifolds = nullptr);
+
+	/**
+	 * Checks that RestoreSnapshot rejects a truncated snapshot and one with a bad
+	 * collision pair index, and that the world is unchanged afterwards. Used by
+	 * the physics benchmark. The pair index is only checked if there are pairs.
+	 * @return true if both snapshots were rejected and the world did not change.
+	 */
+	static bool CheckDamagedSnapshots();
+
+	/**
+	 * Gets the wall clock time taken by the last call to Update.
+	 * @return time in seconds.
+	 */
+	static double GetLastUpdateTime() { return lastUpdateTime; }
+
+	/**
+	 * Gets the number of times Update has been called. Tells whether
+	 * GetLastUpdateTime describes a new update.
+	 */
+	static unsigned long long GetUpdateCount() { return updateCount; }
+
 	/**
 	 * Stop the engine. Call when closing down.
 	 */
@@ -44,26 +246,38 @@ public:
 	static void collisionEventCallback(btDynamicsWorld* world, btScalar timeStep);
 
 	/**
-	 * Passes events to Components in the Game Engine at the beginning of a collision.
-	 * @param rigBody0 - first rigid body involved in the collision.
-	 * @param rigBody1 - second rigid body involved in the collision.
+	 * Records a rigid body that was moved by the simulation. Called by Bullet, possibly
+	 * from several physics threads at once, while motion states are synchronized.
+	 * @param body - the rigid body component that was moved.
 	 */
-	static void CollisionEnter(const btRigidBody* rigBody0, const btRigidBody* rigBody1);
+	static void AddMovedBody(class RigidBodyComponent* body);
 
 	/**
-	 * Passes events to Components in the Game Engine after the beginning and before the
-	 * end of a collision.
-	 * @param rigBody0 - first rigid body involved in the collision.
-	 * @param rigBody1 - second rigid body involved in the collision.
+	 * Adds a kinematic rigid body whose transform is read from the scene graph
+	 * before the next update. After that it is only read again when the game
+	 * object or one of its ancestors moves.
+	 * @param body - the rigid body component.
 	 */
-	static void CollisionStay(const btRigidBody* rigBody0, const btRigidBody* rigBody1);
+	static void AddKinematicBody(class RigidBodyComponent* body);
 
 	/**
-	 * Passes events to Components in the Game Engine at the end of a collision.
-	 * @param rigBody0 - first rigid body involved in the collision.
-	 * @param rigBody1 - second rigid body involved in the collision.
+	 * Stops reading the transform of a kinematic rigid body from the scene graph.
+	 * @param body - the rigid body component.
 	 */
-	static void CollisionExit(const btRigidBody* rigBody0, const btRigidBody* rigBody1);
+	static void RemoveKinematicBody(class RigidBodyComponent* body);
+
+	/**
+	 * Copies the transforms of the bodies moved during the last update into the scene
+	 * graph. Only bodies that Bullet reported as moving are visited, so sleeping bodies
+	 * cost nothing.
+	 */
+	static void SyncMovedBodies();
+
+	/**
+	 * Passes all collision events buffered during the last update to the Components in
+	 * the Game Engine that are listening for them. Called once after each update.
+	 */
+	static void DispatchCollisionEvents();
 
 	/**
 	 * Converts a glm::mat4 into a btTransform.
@@ -89,17 +303,140 @@ public:
 	*/
 	static bool checkForRayIntersection(glm::vec3 origin, glm::vec3 direction);
 
+	/**
+	* Casts a single ray and finds the closest hit.
+	*
+	* @param query:		The ray.
+	*
+	* @return Description of the closest hit.
+	*/
+	static QueryHit RayCast(const RayQuery& query);
+
+	/**
+	* Casts a batch of rays. When the multithreaded pipeline is in use, the rays are
+	* divided among the physics threads. Must not be called while the simulation
+	* is being stepped.
+	*
+	* @param queries:		The rays.
+	* @param results:		Resized to hold the closest hit of each ray in the same order.
+	*/
+	static void RayCastBatch(const std::vector<RayQuery>& queries, std::vector<QueryHit>& results);
+
+	/**
+	* Sweeps a batch of spheres or boxes from their start positions to their end
+	* positions and finds the first hit of each. Divided among the physics threads
+	* in the same way as RayCastBatch.
+	*
+	* @param queries:		The shapes to sweep. from and to should not be equal.
+	* @param results:		Resized to hold the closest hit of each sweep in the same order.
+	*/
+	static void SweepBatch(const std::vector<ShapeQuery>& queries, std::vector<QueryHit>& results);
+
+	/**
+	* Checks a batch of spheres or boxes for overlap with the objects in the physics
+	* world. Divided among the physics threads in the same way as RayCastBatch.
+	*
+	* @param queries:		The shapes placed at their from positions.
+	* @param results:		Resized to hold the deepest contact of each shape in the same order.
+	*/
+	static void OverlapBatch(const std::vector<ShapeQuery>& queries, std::vector<QueryHit>& results);
+
 	// See Init method for purpose of each of these objects.
 	static btBroadphaseInterface* broadphase;
 	static btDefaultCollisionConfiguration* collisionConfiguration;
 	static btCollisionDispatcher* dispatcher;
-	static btSequentialImpulseConstraintSolver* solver;
+	static btConstraintSolver* solver;
+
+	// Keeps the overlapping object lists of trigger ghost objects up to date
+	static btGhostPairCallback* ghostPairCallback;
+
+	// Applies the collision layers and keeps stationary bodies from pairing with each other
+	static btOverlapFilterCallback* overlapFilterCallback;
+
+	// Only used by the multithreaded pipeline
+	static btConstraintSolverPoolMt* solverPool;
+	static PhysicsTaskScheduler* taskScheduler;
 
 	// Physic world in which all simulation is completed
 	static btDiscreteDynamicsWorld* dynamicsWorld;
 
-	// Collision event pairs from the last update
+	// Sorted collision event pairs from the last update
 	static CollisionPairs colPairsLastUpdate;
 
+	// Sorted collision event pairs found during the current update. Swapped with
+	// colPairsLastUpdate at the end of each update so that neither is reallocated.
+	static CollisionPairs colPairsThisUpdate;
+
+	// Collision events buffered during the current update
+	static std::vector<CollisionEventRecord> collisionEvents;
+
+	// Bodies removed since the last update whose pairs must be dropped
+	static std::vector<const btCollisionObject*> removedBodies;
+
+	// Sorted copy of removedBodies used during an update. Bodies removed by
+	// collision event handlers are added to removedBodies for the next update.
+	static std::vector<const btCollisionObject*> removedBodiesThisUpdate;
+
+	// Rigid bodies moved during the current update. Each thread that synchronizes
+	// motion states has its own list so that no locking is needed.
+	static std::vector<class RigidBodyComponent*> movedBodies[BT_MAX_THREAD_COUNT];
+
+	// Kinematic rigid bodies and triggers whose transforms must be read from the
+	// scene graph before the next update. Filled from the moved scene graph nodes.
+	static std::vector<class RigidBodyComponent*> movedKinematicBodies;
+
+	// Deterministic stepping. See SetDeterministic.
+	static bool deterministic;
+	static btScalar fixedTimeStep;
+	static double stepAccumulator;
+	static unsigned long long simulationTick;
+
+protected:
+
+	// Wall clock time in seconds taken by the last update and the number of updates
+	static double lastUpdateTime;
+	static unsigned long long updateCount;
+
+	/**
+	 * Runs body over the range [0, count). Uses the physics threads when the
+	 * multithreaded pipeline is in use.
+	 */
+	static void RunQueries(int count, const btIParallelForBody& body);
+
+	/**
+	 * Passes the transforms of the kinematic rigid bodies that moved since the last
+	 * update to Bullet. Bodies that did not move are not visited.
+	 */
+	static void SyncKinematicBodies();
+
+	/**
+	 * Persistent manifold along with the world array indices of its bodies.
+	 */
+	struct ManifoldKey
+	{
+		int body0;
+		int body1;
+		btPersistentManifold* manifold;
+
+		// Contact points of a manifold read from a snapshot
+		const char* savedPoints;
+		int numSavedPoints;
+
+		bool operator<(const ManifoldKey& other) const
+		{
+			return body0 < other.body0 || (body0 == other.body0 && body1 < other.body1);
+		}
+	};
+
+	/**
+	 * Fills manifoldKeys with the manifolds of the dispatcher sorted by their bodies.
+	 * Manifolds of the same pair of bodies keep the order of the dispatcher.
+	 */
+	static void SortManifolds();
+
+	// Reused by SaveSnapshot and RestoreSnapshot
+	static std::vector<ManifoldKey> manifoldKeys;
+	static std::vector<ManifoldKey> savedManifoldKeys;
+
 };
 
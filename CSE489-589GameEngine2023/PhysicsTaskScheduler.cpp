@@ -0,0 +1,193 @@
+#include "PhysicsTaskScheduler.h"
+
+#include <algorithm>
+#include <iostream>
+
+#define VERBOSE false
+
+PhysicsTaskScheduler::PhysicsTaskScheduler(int numThreads)
+	: btITaskScheduler("PhysicsTaskScheduler"), nextIteration(0), jobRunning(false)
+{
+	setNumThreads(numThreads);
+
+} // end constructor
+
+
+PhysicsTaskScheduler::~PhysicsTaskScheduler()
+{
+	stopWorkers();
+
+} // end destructor
+
+
+void PhysicsTaskScheduler::setNumThreads(int numThreads)
+{
+	if (numThreads < 1) {
+		numThreads = static_cast<int>(std::thread::hardware_concurrency());
+	}
+
+	numThreads = std::max(1, std::min(numThreads, getMaxNumThreads()));
+
+	stopWorkers();
+
+	this->numThreads = numThreads;
+
+	startWorkers();
+
+	if (VERBOSE) std::cout << "PhysicsTaskScheduler using " << this->numThreads << " threads." << std::endl;
+
+} // end setNumThreads
+
+
+void PhysicsTaskScheduler::startWorkers()
+{
+	unsigned int generation = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		quit = false;
+		generation = jobGeneration;
+	}
+
+	// The calling thread does its share of each job
+	for (int i = 1; i < numThreads; i++) {
+
+		workers.emplace_back(&PhysicsTaskScheduler::workerLoop, this, generation);
+	}
+
+} // end startWorkers
+
+
+void PhysicsTaskScheduler::stopWorkers()
+{
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		quit = true;
+	}
+	jobPosted.notify_all();
+
+	for (auto& worker : workers) {
+		worker.join();
+	}
+	workers.clear();
+
+} // end stopWorkers
+
+
+void PhysicsTaskScheduler::workerLoop(unsigned int lastGeneration)
+{
+	while (true) {
+
+		{
+			std::unique_lock<std::mutex> lock(jobMutex);
+			jobPosted.wait(lock, [&] { return quit || jobGeneration != lastGeneration; });
+
+			if (quit) {
+				return;
+			}
+			lastGeneration = jobGeneration;
+		}
+
+		runJob();
+
+		{
+			std::lock_guard<std::mutex> lock(jobMutex);
+			workersBusy--;
+		}
+		jobFinished.notify_one();
+	}
+
+} // end workerLoop
+
+
+void PhysicsTaskScheduler::runJob()
+{
+	while (true) {
+
+		int begin = nextIteration.fetch_add(jobGrainSize);
+
+		if (begin >= jobEnd) {
+			break;
+		}
+
+		int end = std::min(begin + jobGrainSize, jobEnd);
+
+		if (forBody != nullptr) {
+
+			forBody->forLoop(begin, end);
+		}
+		else {
+
+			btScalar partialSum = sumBody->sumLoop(begin, end);
+
+			std::lock_guard<std::mutex> lock(sumMutex);
+			sumResult += partialSum;
+		}
+	}
+
+} // end runJob
+
+
+void PhysicsTaskScheduler::dispatch(int iBegin, int iEnd, int grainSize)
+{
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+
+		jobEnd = iEnd;
+		jobGrainSize = std::max(1, grainSize);
+		nextIteration = iBegin;
+		workersBusy = static_cast<int>(workers.size());
+		jobGeneration++;
+	}
+	jobPosted.notify_all();
+
+	// Take part in the job rather than waiting idle
+	runJob();
+
+	std::unique_lock<std::mutex> lock(jobMutex);
+	jobFinished.wait(lock, [&] { return workersBusy == 0; });
+
+} // end dispatch
+
+
+void PhysicsTaskScheduler::parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body)
+{
+	// Not worth waking the workers for a single chunk. A call made while a job
+	// is running would wait for workers that are busy with that job.
+	if (workers.empty() || iEnd - iBegin <= grainSize || jobRunning.exchange(true)) {
+
+		body.forLoop(iBegin, iEnd);
+		return;
+	}
+
+	forBody = &body;
+	sumBody = nullptr;
+
+	dispatch(iBegin, iEnd, grainSize);
+
+	forBody = nullptr;
+	jobRunning = false;
+
+} // end parallelFor
+
+
+btScalar PhysicsTaskScheduler::parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body)
+{
+	if (workers.empty() || iEnd - iBegin <= grainSize || jobRunning.exchange(true)) {
+
+		return body.sumLoop(iBegin, iEnd);
+	}
+
+	forBody = nullptr;
+	sumBody = &body;
+	sumResult = 0.0f;
+
+	dispatch(iBegin, iEnd, grainSize);
+
+	sumBody = nullptr;
+	btScalar result = sumResult;
+	jobRunning = false;
+
+	return result;
+
+} // end parallelSum
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+
+#include "Bullet/LinearMath/btThreads.h"
+
+/**
+ * @class	PhysicsTaskScheduler
+ *
+ * @brief	Task scheduler used by the multithreaded Bullet pipeline. Owns a
+ * 			fixed pool of worker threads. Each parallelFor or parallelSum call
+ * 			is broken into chunks of grainSize iterations that are pulled from
+ * 			a shared counter by the workers and by the calling thread.
+ * 			Bullet must be built with BT_THREADSAFE for the work to actually
+ * 			be performed in parallel.
+ */
+class PhysicsTaskScheduler : public btITaskScheduler
+{
+public:
+
+	/**
+	 * @fn	PhysicsTaskScheduler::PhysicsTaskScheduler(int numThreads);
+	 *
+	 * @brief	Constructor
+	 *
+	 * @param	numThreads	Total number of threads including the calling thread.
+	 * 						Values less than one use the number of hardware threads.
+	 */
+	PhysicsTaskScheduler(int numThreads);
+
+	/**
+	 * @fn	virtual PhysicsTaskScheduler::~PhysicsTaskScheduler();
+	 *
+	 * @brief	Destructor. Stops and joins the worker threads.
+	 */
+	virtual ~PhysicsTaskScheduler();
+
+	virtual int getMaxNumThreads() const override { return BT_MAX_THREAD_COUNT; }
+
+	virtual int getNumThreads() const override { return numThreads; }
+
+	/**
+	 * @fn	virtual void PhysicsTaskScheduler::setNumThreads(int numThreads) override;
+	 *
+	 * @brief	Restarts the worker pool with a different number of threads.
+	 *
+	 * @param	numThreads	Total number of threads including the calling thread.
+	 */
+	virtual void setNumThreads(int numThreads) override;
+
+	virtual void parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body) override;
+
+	virtual btScalar parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body) override;
+
+protected:
+
+	/**
+	 * @fn	void PhysicsTaskScheduler::startWorkers();
+	 *
+	 * @brief	Creates numThreads - 1 worker threads.
+	 */
+	void startWorkers();
+
+	/**
+	 * @fn	void PhysicsTaskScheduler::stopWorkers();
+	 *
+	 * @brief	Signals the worker threads to exit and joins them.
+	 */
+	void stopWorkers();
+
+	/**
+	 * @fn	void PhysicsTaskScheduler::workerLoop(unsigned int lastGeneration);
+	 *
+	 * @brief	Body of each worker thread. Sleeps until a job is posted.
+	 *
+	 * @param	lastGeneration	Job generation when the worker was created. Jobs
+	 * 							posted after that are run even if they are posted
+	 * 							before the thread starts running.
+	 */
+	void workerLoop(unsigned int lastGeneration);
+
+	/**
+	 * @fn	void PhysicsTaskScheduler::runJob();
+	 *
+	 * @brief	Processes chunks of the current job until none are left.
+	 */
+	void runJob();
+
+	/**
+	 * @fn	void PhysicsTaskScheduler::dispatch(int iBegin, int iEnd, int grainSize);
+	 *
+	 * @brief	Posts the current job to the workers, participates in it,
+	 * 			and waits for it to complete.
+	 */
+	void dispatch(int iBegin, int iEnd, int grainSize);
+
+	/** @brief	Total number of threads including the calling thread. */
+	int numThreads = 1;
+
+	/** @brief	The worker threads. */
+	std::vector<std::thread> workers;
+
+	/** @brief	Guards the job description and the worker wake up. */
+	std::mutex jobMutex;
+	std::condition_variable jobPosted;
+	std::condition_variable jobFinished;
+
+	/** @brief	Incremented each time a job is posted so workers can detect new work. */
+	unsigned int jobGeneration = 0;
+
+	/** @brief	Number of workers that have not yet finished the current job. */
+	int workersBusy = 0;
+
+	/** @brief	True when the workers should exit. */
+	bool quit = false;
+
+	/** @brief	Description of the current job. Exactly one of the bodies is non-null. */
+	const btIParallelForBody* forBody = nullptr;
+	const btIParallelSumBody* sumBody = nullptr;
+	int jobEnd = 0;
+	int jobGrainSize = 1;
+
+	/** @brief	First iteration of the next chunk to be claimed. */
+	std::atomic<int> nextIteration;
+
+	/** @brief	True while a job is running. Nested and concurrent calls run on the calling thread. */
+	std::atomic<bool> jobRunning;
+
+	/** @brief	Accumulated result of a parallelSum. */
+	btScalar sumResult = 0.0f;
+	std::mutex sumMutex;
+
+}; // end PhysicsTaskScheduler class
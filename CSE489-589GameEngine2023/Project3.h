@@ -164,8 +164,10 @@ protected:
 
 		// ***** Sound Setup *****
 
+		// The tracks are long so they are streamed rather than loaded into memory
+
 		// Sun Sound
-		auto sunSoundComp = std::make_shared<SoundSourceComponent>("Assets/nasa_sun.wav");
+		auto sunSoundComp = std::make_shared<SoundSourceComponent>("Assets/nasa_sun.wav", STREAM_FROM_FILE);
 		sunGameObject->addComponent(sunSoundComp);
 		sunSoundComp->setLooping(true);
 		sunSoundComp->setGain(0.5f);
@@ -173,7 +175,7 @@ protected:
 		sunSoundComp->play();
 
 		// Earth Sound
-		auto earthSoundComp = std::make_shared<SoundSourceComponent>("Assets/earth_tsunami.wav");
+		auto earthSoundComp = std::make_shared<SoundSourceComponent>("Assets/earth_tsunami.wav", STREAM_FROM_FILE);
 		earthGameObject->addComponent(earthSoundComp);
 		earthSoundComp->setLooping(true);
 		earthSoundComp->setGain(1.0f);
@@ -181,7 +183,7 @@ protected:
 		earthSoundComp->play();
 
 		// Moon Sound
-		auto moonSoundComp = std::make_shared<SoundSourceComponent>("Assets/moon_landing.wav");
+		auto moonSoundComp = std::make_shared<SoundSourceComponent>("Assets/moon_landing.wav", STREAM_FROM_FILE);
 		moonGameObject->addComponent(moonSoundComp);
 		moonSoundComp->setLooping(true);
 		moonSoundComp->setGain(1.0f);
@@ -189,7 +191,7 @@ protected:
 		moonSoundComp->play();
 
 		// Jupiter Sound
-		auto jupiterSoundComp = std::make_shared<SoundSourceComponent>("Assets/nasa_jupiter.wav");
+		auto jupiterSoundComp = std::make_shared<SoundSourceComponent>("Assets/nasa_jupiter.wav", STREAM_FROM_FILE);
 		jupiterGameObject->addComponent(jupiterSoundComp);
 		jupiterSoundComp->setLooping(true);
 		jupiterSoundComp->setGain(1.0f);
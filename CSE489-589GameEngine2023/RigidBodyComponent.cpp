@@ -1,4 +1,5 @@
 #include "RigidBodyComponent.h"
+#include "CollisionLayers.h"
 
 #define VERBOSE false
 
@@ -17,18 +18,23 @@ RigidBodyComponent::~RigidBodyComponent()
 
 	if (bulletRigidBody != nullptr && PhysicsEngine::dynamicsWorld != nullptr) {
 
-		PhysicsEngine::RemoveFromColPairsLastUpdate(bulletRigidBody->getMotionState());
+		PhysicsEngine::RemoveFromColPairsLastUpdate(bulletRigidBody);
 
 		PhysicsEngine::dynamicsWorld->removeRigidBody(bulletRigidBody);
 		delete bulletRigidBody;
 	}
 
-	if (ghostRigidBody != nullptr && PhysicsEngine::dynamicsWorld != nullptr) {
+	if (rigidbodyDynamics == KINEMATIC || rigidbodyDynamics == TRIGGER) {
 
-		PhysicsEngine::RemoveFromColPairsLastUpdate(ghostRigidBody->getMotionState());
+		PhysicsEngine::RemoveKinematicBody(this);
+	}
+
+	if (ghostObject != nullptr && PhysicsEngine::dynamicsWorld != nullptr) {
+
+		PhysicsEngine::RemoveFromColPairsLastUpdate(ghostObject);
 
-		PhysicsEngine::dynamicsWorld->removeRigidBody(ghostRigidBody);
-		delete ghostRigidBody;
+		PhysicsEngine::dynamicsWorld->removeCollisionObject(ghostObject);
+		delete ghostObject;
 	}
 
 } // end destructor
@@ -55,9 +61,10 @@ void RigidBodyComponent::initialize()
 			);
 
 		this->bulletRigidBody = new btRigidBody(rigidBodyCI);
+		bulletRigidBody->setUserPointer(this);
 		//bulletRigidBody->setCollisionFlags( btCollisionObject::CF_DYNAMIC_OBJECT);
 
-		PhysicsEngine::dynamicsWorld->addRigidBody(bulletRigidBody);
+		addToWorld();
 
 		// Enable or disable gravity
 		setGravityOn(applyGravity);
@@ -82,6 +89,7 @@ void RigidBodyComponent::initialize()
 			);
 
 		this->bulletRigidBody = new btRigidBody( rigidBodyCI );
+		bulletRigidBody->setUserPointer(this);
 
 		if (this->rigidbodyDynamics == KINEMATIC) {
 
@@ -89,23 +97,28 @@ void RigidBodyComponent::initialize()
 											   btCollisionObject::CF_KINEMATIC_OBJECT);
 			bulletRigidBody->setActivationState(DISABLE_DEACTIVATION);
 
+			PhysicsEngine::AddKinematicBody(this);
 		}
 		else { // STATIONARY
 
 			bulletRigidBody->setCollisionFlags( bulletRigidBody->getCollisionFlags() | 
 				btCollisionObject::CF_STATIC_OBJECT);
-
-			// "Ghost" Rigid body to enable collisions between KINEMATIC and STATIONARY
-			ghostRigidBody = new btRigidBody(rigidBodyCI);
-			ghostRigidBody->setCollisionFlags(btCollisionObject::CF_NO_CONTACT_RESPONSE);
-			PhysicsEngine::dynamicsWorld->addRigidBody(ghostRigidBody);
 		}
 
 		if (VERBOSE) cout << "Adding bulletRigidBody to the dydynamicsWorld" << endl;
 
-		PhysicsEngine::dynamicsWorld->addRigidBody(bulletRigidBody);
+		addToWorld();
 
 	}
+	else if (this->rigidbodyDynamics == TRIGGER) {
+
+		// Trigger volumes are ghost objects that report collisions without responding to them
+		createGhostObject();
+
+		PhysicsEngine::AddKinematicBody(this);
+
+		addToWorld();
+	}
 	else {
 		this->bulletRigidBody = nullptr;
 		this->bulletCollisionShape = nullptr;
@@ -114,6 +127,94 @@ void RigidBodyComponent::initialize()
 } // end initialize
 
 
+void RigidBodyComponent::createGhostObject()
+{
+	ghostObject = new btGhostObject();
+	ghostObject->setCollisionShape(bulletCollisionShape);
+	ghostObject->setUserPointer(this);
+
+	// Not static so that Bullet checks it against stationary bodies
+	ghostObject->setCollisionFlags(btCollisionObject::CF_NO_CONTACT_RESPONSE);
+
+	btTransform worldTrans;
+	getWorldTransform(worldTrans);
+	ghostObject->setWorldTransform(worldTrans);
+
+} // end createGhostObject
+
+
+void RigidBodyComponent::addToWorld()
+{
+	int group = CollisionLayers::GetFilterGroup(collisionLayer, rigidbodyDynamics);
+	int mask = CollisionLayers::GetFilterMask(collisionLayer, rigidbodyDynamics);
+
+	if (bulletRigidBody != nullptr) {
+
+		PhysicsEngine::dynamicsWorld->addRigidBody(bulletRigidBody, group, mask);
+	}
+
+	if (ghostObject != nullptr) {
+
+		PhysicsEngine::dynamicsWorld->addCollisionObject(ghostObject, group, mask);
+	}
+
+} // end addToWorld
+
+
+void RigidBodyComponent::setCollisionLayer(int layer)
+{
+	collisionLayer = layer;
+
+	// Re-add the body so that the broadphase uses the new filter
+	if (PhysicsEngine::dynamicsWorld != nullptr && (bulletRigidBody != nullptr || ghostObject != nullptr)) {
+
+		if (bulletRigidBody != nullptr) {
+			PhysicsEngine::dynamicsWorld->removeRigidBody(bulletRigidBody);
+		}
+
+		if (ghostObject != nullptr) {
+			PhysicsEngine::dynamicsWorld->removeCollisionObject(ghostObject);
+		}
+
+		addToWorld();
+
+		// Adding a rigid body resets its gravity
+		if (rigidbodyDynamics == DYNAMIC) {
+			setGravityOn(applyGravity);
+		}
+	}
+
+} // end setCollisionLayer
+
+
+void RigidBodyComponent::setCollisionLayer(const std::string& layerName)
+{
+	int layer = CollisionLayers::AddLayer(layerName);
+
+	if (layer >= 0) {
+		setCollisionLayer(layer);
+	}
+
+} // end setCollisionLayer
+
+
+std::vector<const RigidBodyComponent*> RigidBodyComponent::getOverlappingBodies() const
+{
+	std::vector<const RigidBodyComponent*> overlapping;
+
+	if (rigidbodyDynamics == TRIGGER && ghostObject != nullptr) {
+
+		for (int i = 0; i < ghostObject->getNumOverlappingObjects(); i++) {
+
+			overlapping.push_back(static_cast<const RigidBodyComponent*>(ghostObject->getOverlappingObject(i)->getUserPointer()));
+		}
+	}
+
+	return overlapping;
+
+} // end getOverlappingBodies
+
+
 void RigidBodyComponent::enableCCD(bool ccdOn)
 {
 	this->ccdOn = ccdOn;
@@ -163,94 +264,139 @@ void RigidBodyComponent::setGravityOn(bool gravityOn)
 	}
 }
 
-// Called by bullet to get the initial position and orientation of the object
+// Called by bullet to get the initial position and orientation of the object. Kinematic
+// bodies are also called on every internal step.
 void RigidBodyComponent::getWorldTransform(btTransform& worldTrans) const
 {
-	// Calculate current world transformation and set world trans to it 
-	worldTrans = PhysicsEngine::convertTransform(this->owningGameObject->getWorldTransform());
+	if (kinematicTransformCached) {
+
+		worldTrans = bulletTransform;
+	}
+	else {
+
+		// Calculate current world transformation and set world trans to it 
+		worldTrans = PhysicsEngine::convertTransform(this->owningGameObject->getWorldTransform());
+	}
 
 	if (VERBOSE) std::cout << "RigidBodyComponent::getWorldTransform " << getPositionVec3FromTransform(this->owningGameObject->getWorldTransform()) << std::endl;
 
 } // end getWorldTransform
 
-// Called by bullet to set the position and orient the object
+// Called by bullet to set the position and orient the object. Only called for active
+// bodies and possibly from several physics threads, so the scene graph is updated
+// later by syncSceneTransform.
 void RigidBodyComponent::setWorldTransform(const btTransform& worldTrans)
 {
 	bulletTransform = worldTrans;
 
-	glm::mat4 T = PhysicsEngine::convertTransform(worldTrans);
+	PhysicsEngine::AddMovedBody(this);
 
-	// Get the world transform of the parent
-	mat4 invParWorldTrans = glm::inverse(this->owningGameObject->parent->getWorldTransform());
+	if (VERBOSE) std::cout << "RigidBodyComponent::setWorldTransform" << std::endl;
 
-	this->owningGameObject->localTransform = invParWorldTrans * T;
+} // end setWorldTransform
 
-	if (VERBOSE) std::cout << "RigidBodyComponent::setWorldTransform" << std::endl;
-}
 
-void RigidBodyComponent::CollisionEnter(const RigidBodyComponent* collisionData) const
+void RigidBodyComponent::syncSceneTransform()
 {
-	if (collisionData->bulletRigidBody != this->ghostRigidBody &&
-		collisionData->bulletRigidBody != this->bulletRigidBody) {
+	glm::mat4 T = PhysicsEngine::convertTransform(bulletTransform);
 
-		if (VERBOSE) std::cout << "CollisionEnter" << std::endl;
+	GameObject* parent = this->owningGameObject->parent;
 
-	std::vector<std::shared_ptr<class Component>> buddys = owningGameObject->getComponents();
+	// The world transform of the children of the root is their local transform
+	if (parent->parent == nullptr && (parent->applyScaleToChildren == false || parent->localScale == mat4(1.0f))) {
 
-		for (auto& bud : buddys) {
+		this->owningGameObject->localTransform = T;
+	}
+	else {
 
-			if (bud != shared_from_this()) {
+		// Get the world transform of the parent
+		mat4 invParWorldTrans = glm::inverse(parent->getWorldTransform());
 
-				bud->collisionEnter(collisionData);
-			}
-		}
+		this->owningGameObject->localTransform = invParWorldTrans * T;
 	}
 
-} //  end CollisionEnter
+	// Kinematic bodies attached below the game object moved with it
+	this->owningGameObject->transformChanged();
+
+} // end syncSceneTransform
 
 
-void RigidBodyComponent::CollisionStay(const RigidBodyComponent* collisionData) const
+void RigidBodyComponent::cacheKinematicTransform()
 {
-	if (collisionData->bulletRigidBody != this->ghostRigidBody &&
-		collisionData->bulletRigidBody != this->bulletRigidBody) {
+	bulletTransform = PhysicsEngine::convertTransform(this->owningGameObject->getWorldTransform());
+	kinematicTransformCached = true;
 
-		if (VERBOSE) std::cout << "CollisionStay" << std::endl;
+	// Ghost objects are not moved by Bullet
+	if (ghostObject != nullptr) {
+		ghostObject->setWorldTransform(bulletTransform);
+	}
 
-	std::vector<std::shared_ptr<class Component>> buddys = owningGameObject->getComponents();
+} // end cacheKinematicTransform
 
-		for (auto& bud : buddys) {
 
-			if (bud != shared_from_this()) {
-				bud->collisionStay(collisionData);
-			}
-		}
+void RigidBodyComponent::addCollisionListener(Component* listener)
+{
+	if (listener == this) {
+		return;
+	}
+
+	int eventTypes = listener->getCollisionEventTypes();
+
+	if (eventTypes & COLLISION_ENTER) {
+		enterListeners.push_back(listener);
+	}
+	if (eventTypes & COLLISION_STAY) {
+		stayListeners.push_back(listener);
 	}
+	if (eventTypes & COLLISION_EXIT) {
+		exitListeners.push_back(listener);
+	}
+
+} // end addCollisionListener
+
+
+void RigidBodyComponent::removeCollisionListener(Component* listener)
+{
+	for (std::vector<Component*>* listeners : { &enterListeners, &stayListeners, &exitListeners }) {
 
-} //  end CollisionStay
+		listeners->erase(std::remove(listeners->begin(), listeners->end(), listener), listeners->end());
+	}
+
+} // end removeCollisionListener
 
 
-/**
- * @fn	void RigidBodyComponent::CollisionExit( const RigidBodyComponent * collisionData ) const
- *
- * @brief	Called whenever this rigid body exits a collision with another rigid body.
- *
- * @param	collisionData	Information describing the collision.
- */
-void RigidBodyComponent::CollisionExit(const RigidBodyComponent* collisionData) const
+void RigidBodyComponent::dispatchCollisionEvent(COLLISION_EVENT_TYPE type, const CollisionEvent& collision) const
 {
-	if (collisionData->bulletRigidBody != this->ghostRigidBody &&
-		collisionData->bulletRigidBody != this->bulletRigidBody) {
+	// Ignore collisions of a body with itself
+	if (collision.other == this) {
+		return;
+	}
 
-		if (VERBOSE) std::cout << "CollisionExit" << std::endl;
+	const std::vector<Component*>& listeners =
+		type == COLLISION_ENTER ? enterListeners : (type == COLLISION_STAY ? stayListeners : exitListeners);
 
-		std::vector<std::shared_ptr<class Component>> buddys = owningGameObject->getComponents();
+	unsigned int otherLayer = 1u << collision.other->collisionLayer;
 
-		for (auto & bud : buddys) {
+	for (Component* listener : listeners) {
+
+		if ((listener->getCollisionLayerFilter() & otherLayer) == 0) {
+			continue;
+		}
 
-			if (bud != shared_from_this()) {
-				bud->collisionExit(collisionData);
-			}
+		switch (type) {
+		case COLLISION_ENTER:
+			if (VERBOSE) std::cout << "CollisionEnter" << std::endl;
+			listener->collisionEnter(collision);
+			break;
+		case COLLISION_STAY:
+			if (VERBOSE) std::cout << "CollisionStay" << std::endl;
+			listener->collisionStay(collision);
+			break;
+		default:
+			if (VERBOSE) std::cout << "CollisionExit" << std::endl;
+			listener->collisionExit(collision);
+			break;
 		}
 	}
 
-} // end CollisionExit
+} // end dispatchCollisionEvent
@@ -50,6 +50,25 @@ public:
 	 */
 	virtual void setWorldTransform(const btTransform& worldTrans);
 
+	/**
+	 * @fn	void RigidBodyComponent::syncSceneTransform();
+	 *
+	 * @brief	Copies the transform most recently set by bullet into the local transform
+	 * 			of the owning game object. Called by the physics engine after each update
+	 * 			for the bodies that were moved.
+	 */
+	void syncSceneTransform();
+
+	/**
+	 * @fn	void RigidBodyComponent::cacheKinematicTransform();
+	 *
+	 * @brief	Reads the world transform of the owning game object for a kinematic body.
+	 * 			Called by the physics engine before an update when the game object or
+	 * 			one of its ancestors has moved, so that bullet does not walk the scene
+	 * 			graph on every internal step.
+	 */
+	void cacheKinematicTransform();
+
 	/**
 	 * @fn	virtual void RigidBodyComponent::setVelocity( vec3 worldVelocity );
 	 *
@@ -96,40 +115,102 @@ public:
 	virtual void initialize() override;
 
 	/**
-		* @fn	void RigidBodyComponent::CollisionEnter( const RigidBodyComponent * collisionData ) const
-		*
-		* @brief	Method is called whenever this rigid body first collides with another rigid body.
-		*
-		* @param	collisionData	Information describing the collision.
-		*/
-	void CollisionEnter(const RigidBodyComponent* collisionData) const;
+	 * @fn	void RigidBodyComponent::addCollisionListener(Component* listener);
+	 *
+	 * @brief	Registers a sibling component to receive the collision events it
+	 * 			listens for. Components that have not called listenForCollisions
+	 * 			are ignored. Called by the owning GameObject.
+	 *
+	 * @param [in]	listener	The component.
+	 */
+	void addCollisionListener(Component* listener);
 
 	/**
-		* @fn	void RigidBodyComponent::CollisionStay( const RigidBodyComponent * collisionData ) const
-		*
-		* @brief	Method is called after first collides with another rigid body first collides with another rigid body.
-		*
-		* @param	collisionData	Information describing the collision.
-		*/
-	void CollisionStay(const RigidBodyComponent* collisionData) const;
+	 * @fn	void RigidBodyComponent::removeCollisionListener(Component* listener);
+	 *
+	 * @brief	Stops a component from receiving collision events from this rigid body.
+	 *
+	 * @param [in]	listener	The component.
+	 */
+	void removeCollisionListener(Component* listener);
+
+	/**
+	 * @fn	void RigidBodyComponent::dispatchCollisionEvent(COLLISION_EVENT_TYPE type, const CollisionEvent& collision) const;
+	 *
+	 * @brief	Called by the physics engine once per collision event after the
+	 * 			simulation step. Passes the event to the listeners registered
+	 * 			for its type whose layer filter accepts the other rigid body.
+	 *
+	 * @param	type	 	Enter, stay, or exit.
+	 * @param	collision	Information describing the collision.
+	 */
+	void dispatchCollisionEvent(COLLISION_EVENT_TYPE type, const CollisionEvent& collision) const;
+
 	/**
-		* @fn	void RigidBodyComponent::CollisionExit( const RigidBodyComponent * collisionData ) const
-		*
-		* @brief	Called whenever this rigid body exits a collision with another rigid body.
-		*
-		* @param	collisionData	Information describing the collision.
-		*/
-	void CollisionExit(const RigidBodyComponent* collisionData) const;
+	 * @fn	void RigidBodyComponent::setCollisionLayer(int layer);
+	 *
+	 * @brief	Sets the collision layer of this rigid body. The layer determines which
+	 * 			other rigid bodies it collides with (see CollisionLayers). Listeners
+	 * 			also use the layer of the other rigid body to filter collision events.
+	 *
+	 * @param	layer	The layer. Must be less than CollisionLayers::MAX_LAYERS.
+	 */
+	void setCollisionLayer(int layer);
+
+	/**
+	 * @fn	void RigidBodyComponent::setCollisionLayer(const std::string& layerName);
+	 *
+	 * @brief	Sets the collision layer of this rigid body by name. The layer is added
+	 * 			if it does not exist yet.
+	 *
+	 * @param	layerName	Name of the layer.
+	 */
+	void setCollisionLayer(const std::string& layerName);
+
+	/** @brief	Gets the collision layer of this rigid body. */
+	int getCollisionLayer() const { return collisionLayer; }
+
+	/** @brief	Gets the dynamics state the rigid body was created with. */
+	DynamicsState getDynamicsState() const { return rigidbodyDynamics; }
+
+	/**
+	 * @fn	std::vector<const RigidBodyComponent*> RigidBodyComponent::getOverlappingBodies() const;
+	 *
+	 * @brief	Gets the rigid bodies whose bounding boxes currently overlap a TRIGGER.
+	 *
+	 * @returns	The overlapping rigid bodies. Empty if this is not a TRIGGER.
+	 */
+	std::vector<const RigidBodyComponent*> getOverlappingBodies() const;
 
 protected:
 
+	/**
+	 * @fn	void RigidBodyComponent::createGhostObject();
+	 *
+	 * @brief	Creates the ghost object of a TRIGGER.
+	 */
+	void createGhostObject();
+
+	/**
+	 * @fn	void RigidBodyComponent::addToWorld();
+	 *
+	 * @brief	Adds the rigid body and ghost object to the dynamics world using the
+	 * 			collision filter for the collision layer.
+	 */
+	void addToWorld();
+
 	/**
 	 * @class	btRigidBody*
 	 *
 	 * @brief	The rigid body that bullet holds in its physics simulation.
 	 */
 	class btRigidBody* bulletRigidBody = nullptr;
-	class btRigidBody* ghostRigidBody = nullptr;
+
+	/**
+	 * @brief	Ghost object that detects overlaps without a collision response. It is
+	 * 			the only collision object of a TRIGGER.
+	 */
+	class btGhostObject* ghostObject = nullptr;
 
 	/**
 	 * @class	btCollisionShape*
@@ -146,12 +227,17 @@ protected:
 	 */
 	class btTransform bulletTransform;
 
+	/** @brief	True once cacheKinematicTransform has stored the transform of a kinematic body. */
+	bool kinematicTransformCached = false;
+
 	/** @brief	The rigidbody dynamics state.
 	 *  NONE indicates that the object will be ignored by the physics engine.
 	 *  STATIONARY indicates that the object will not move, but that objects can collide with it
 	 *  KINEMATIC_MOVING indicates that the object will be moved and updated by a Component
 	 *  instead of the physics engine, but collisions will still be detected.
 	 *  DYNAMIC indicates that the object will be moved and updated by the physics engine.
+	 *  TRIGGER indicates that the object will be moved by a Component and will report
+	 *  collisions without responding to them.
 	 */
 	DynamicsState rigidbodyDynamics = NONE;
 
@@ -183,5 +269,13 @@ protected:
 	 *	for small fast moving rigidbodies.
 	 */
 	bool ccdOn = false;
+
+	/** @brief	Collision layer used by listeners to filter events. */
+	int collisionLayer = 0;
+
+	/** @brief	Sibling components registered for each type of collision event. */
+	std::vector<Component*> enterListeners;
+	std::vector<Component*> stayListeners;
+	std::vector<Component*> exitListeners;
 };
 
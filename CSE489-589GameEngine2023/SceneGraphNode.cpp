@@ -3,6 +3,18 @@
 
 #define VERBOSE false
 
+std::vector<SceneGraphNode*> SceneGraphNode::movedNodes;
+
+void SceneGraphNode::transformChanged()
+{
+	if (!transformMoved) {
+
+		transformMoved = true;
+		movedNodes.push_back(this);
+	}
+
+} // end transformChanged
+
 mat4 SceneGraphNode::getWorldTransform()
 {
 	// Base case
@@ -106,6 +118,7 @@ void SceneGraphNode::setPosition(vec3 position, Frame frame)
 
 		// Set the position in local coordinates
 		setPositionVec3ForTransform(localTransform, position);
+		transformChanged();
 	}
 	else {
 
@@ -115,6 +128,7 @@ void SceneGraphNode::setPosition(vec3 position, Frame frame)
 			mat4 invParentT = glm::inverse(parent->getWorldTransform());
 			setPositionVec3ForTransform(worldT, position);
 			localTransform = invParentT * worldT;
+			transformChanged();
 		}
 		else {
 			std::cerr << "ERROR: Setting position relative to WORLD coordinates"
@@ -131,6 +145,7 @@ void SceneGraphNode::setRotation(glm::mat4 rotation, Frame frame)
 
 		// Set the rotation in local coordinates
 		setRotationMat3ForTransform(localTransform, rotation);
+		transformChanged();
 	}
 	else {
 
@@ -139,7 +154,7 @@ void SceneGraphNode::setRotation(glm::mat4 rotation, Frame frame)
 			glm::mat4 parentWorldRotation = parent->getRotation(Frame::WORLD);
 			glm::mat4 newRotation = glm::inverse(parentWorldRotation) * rotation;
 			setRotationMat3ForTransform(localTransform, newRotation);
-
+			transformChanged();
 		}
 		else {
 			std::cerr << "ERROR: Setting rotation relative to WORLD coordinates"
@@ -156,6 +171,7 @@ void SceneGraphNode::setScale(const vec3& scale, Frame frame)
 
 		// Get the scale in local coordinates
 		this->localScale = glm::scale(scale);
+		transformChanged();
 	}
 	else {
 
@@ -163,7 +179,7 @@ void SceneGraphNode::setScale(const vec3& scale, Frame frame)
 
 			mat4 parentScale = glm::scale(getScaleFromTransform(parent->getWorldTransform()));
 			this->localScale = glm::inverse(parentScale) * glm::scale(scale);
-
+			transformChanged();
 		}
 		else {
 			std::cerr << "ERROR: Setting scale relative to WORLD coordinates"
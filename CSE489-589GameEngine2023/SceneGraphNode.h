@@ -9,6 +9,7 @@ class SceneGraphNode
 public:
 
 	friend class RigidBodyComponent;
+	friend class SteeringEngine;
 
 	/**
 	 * @fn	glm::mat4 getModelingTransformation();
@@ -163,6 +164,22 @@ public:
 
 protected:
 
+	/**
+	 * @fn	void SceneGraphNode::transformChanged();
+	 *
+	 * @brief	Records that the local transform or scale of the node changed so that
+	 * 			the kinematic rigid bodies at or below it are moved in the physics
+	 * 			world at the next physics update. Called by everything that writes
+	 * 			the local transform.
+	 */
+	void transformChanged();
+
+	/** @brief	True while the node is in movedNodes. */
+	bool transformMoved = false;
+
+	/** @brief	Nodes whose transforms changed since the last physics update. */
+	static std::vector<SceneGraphNode*> movedNodes;
+
 	/**
 	 * @fn	void SceneGraphNode::updateModelingTransformation();
 	 *
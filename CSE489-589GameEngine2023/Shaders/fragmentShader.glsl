@@ -9,8 +9,6 @@ out vec4 fragmentColor;
 
 const float gamma = 2.2;
 
-const int MaxLights = 16; // 16 lights
-
 // Structure for holding general light properties
 struct GeneralLight
 {
@@ -37,11 +35,44 @@ struct GeneralLight
 
 	bool enabled;			// true if light is "on"
 
+	int shadowIndex;		// index of the first shadow view or -1 if the light casts no shadows
+
+	int shadowCascades;		// number of cascades of each camera if the shadows of a directional light are cascaded
+
+};
+
+// Every light in the scene. There is no fixed limit.
+layout(std430) readonly buffer LightBlock
+{
+	GeneralLight lights[];
+};
+
+// Lights assigned to clusters of the view volume of the current camera
+layout(std430) readonly buffer ClusterBlock
+{
+	uvec4 clusterGridSize;	// clusters along x, y, and z. w is the number of global lights
+	vec4 clusterTiles;		// xy: viewport origin in pixels, zw: reciprocal of tile size in pixels
+	vec4 clusterDepthRow;	// third row of the viewing matrix
+	vec4 clusterSlices;		// x: slice scale, y: slice bias, z: index of the camera
+	uvec2 clusters[];		// offset into lightIndices and number of lights
+};
+
+// Global lights that reach every fragment followed by the lights of each cluster
+layout(std430) readonly buffer LightIndexBlock
+{
+	uint lightIndices[];
+};
+
+// A view of a light and the tile of the shadow map atlas rendered from it
+struct ShadowView
+{
+	mat4 viewProjection;
+	vec4 atlasRect;			// xy: lower left corner of the tile, zw: size of the tile
 };
 
-layout(shared) uniform LightBlock
+layout(std430) readonly buffer ShadowBlock
 {
-	GeneralLight lights[MaxLights];
+	ShadowView shadowViews[];
 };
 
 layout(shared) uniform worldEyeBlock
@@ -78,9 +109,21 @@ layout(shared) uniform FogBlock
 	int fogMode; // 0 no fog, 1 linear, 2 exponential, 3 expo two
 };
 
+// Variants of this shader are built with the texture and fog settings defined
+// as constants, so each variant only contains the code its materials need.
+// Without them the settings are read from the uniform blocks.
+#ifndef SHADER_VARIANT
+#define DIFFUSE_TEXTURE_ENABLED object.diffuseTextureEnabled
+#define SPECULAR_TEXTURE_ENABLED object.specularTextureEnabled
+#define NORMAL_MAP_ENABLED object.normalMapTextureEnabled
+#define TEXTURE_MODE object.textureMode
+#define FOG_MODE fogMode
+#endif
+
 layout(binding = 0) uniform sampler2D diffuseSampler;
 layout(binding = 1) uniform sampler2D specularSampler;
 layout(binding = 2) uniform sampler2D normalMapSampler;
+layout(binding = 3) uniform sampler2DShadow shadowAtlas;
 
 float distanceFromViewPoint;
 
@@ -100,6 +143,159 @@ float exponentialTwoFogFactor() {
 	return exp(-pow((fogDensity * distanceFromViewPoint),2));
 }
 
+// Finds the index of the cluster that contains the fragment
+uint findCluster()
+{
+	// Distance in front of the camera
+	float viewDepth = max(-dot(clusterDepthRow, vec4(worldPos, 1.0f)), 1e-4f);
+
+	ivec3 cell;
+	cell.xy = ivec2((gl_FragCoord.xy - clusterTiles.xy) * clusterTiles.zw);
+	cell.z = int(floor(log(viewDepth) * clusterSlices.x + clusterSlices.y));
+	cell = clamp(cell, ivec3(0), ivec3(clusterGridSize.xyz) - 1);
+
+	return (uint(cell.z) * clusterGridSize.y + uint(cell.y)) * clusterGridSize.x + uint(cell.x);
+}
+
+// Finds the position of the fragment in the shadow map of a view. False if the view does not contain it.
+bool findShadowPosition(ShadowView view, out vec3 shadowPos)
+{
+	vec4 clipPos = view.viewProjection * vec4(worldPos, 1.0f);
+	shadowPos = clipPos.xyz / clipPos.w * 0.5f + 0.5f;
+
+	return all(greaterThanEqual(shadowPos, vec3(0.0f))) && all(lessThanEqual(shadowPos, vec3(1.0f)));
+}
+
+// Compares the depth of the fragment with the tile of a view using hardware percentage closer filtering
+float sampleShadowView(ShadowView view, vec3 shadowPos)
+{
+	// Keep the filter inside the tile of this view
+	vec2 halfTexel = 0.5f / vec2(textureSize(shadowAtlas, 0));
+	vec2 atlasPos = clamp(view.atlasRect.xy + shadowPos.xy * view.atlasRect.zw,
+		view.atlasRect.xy + halfTexel, view.atlasRect.xy + view.atlasRect.zw - halfTexel);
+
+	return texture(shadowAtlas, vec3(atlasPos, shadowPos.z));
+}
+
+// Fraction of the light that reaches the fragment. Zero if it is in shadow.
+float shadowFactor(GeneralLight light)
+{
+	if (light.shadowIndex < 0) {
+		return 1.0f;
+	}
+
+	int viewIndex = light.shadowIndex;
+	vec3 shadowPos;
+
+	// Cascaded lights have views for each camera. Use the nearest cascade that contains the fragment.
+	if (light.shadowCascades > 0) {
+
+		viewIndex += int(clusterSlices.z) * light.shadowCascades;
+
+		for (int cascade = 0; cascade < light.shadowCascades; cascade++) {
+
+			if (findShadowPosition(shadowViews[viewIndex + cascade], shadowPos)) {
+				return sampleShadowView(shadowViews[viewIndex + cascade], shadowPos);
+			}
+		}
+
+		// Beyond the shadow distance
+		return 1.0f;
+	}
+
+	// Positional lights have a view for each face of a cube. Pick the face the fragment is on.
+	if (light.positionOrDirection.w >= 0.98f && light.isSpot == false) {
+
+		vec3 fromLight = worldPos - light.positionOrDirection.xyz;
+		vec3 size = abs(fromLight);
+
+		if (size.x >= size.y && size.x >= size.z) viewIndex += (fromLight.x > 0.0f) ? 0 : 1;
+		else if (size.y >= size.z) viewIndex += (fromLight.y > 0.0f) ? 2 : 3;
+		else viewIndex += (fromLight.z > 0.0f) ? 4 : 5;
+	}
+
+	ShadowView view = shadowViews[viewIndex];
+
+	// Nothing outside the view casts a shadow
+	if (!findShadowPosition(view, shadowPos)) {
+		return 1.0f;
+	}
+
+	return sampleShadowView(view, shadowPos);
+}
+
+// Calculates the ambient, diffuse, and specular reflection of a single light
+vec4 lightContribution(uint lightIndex, vec3 fragWorldNormal, vec3 viewVector, vec4 ambientColor, vec4 diffuseColor, vec4 specularColor)
+{
+	GeneralLight light = lights[lightIndex];
+
+	vec3 lightVector;
+
+	float attenuation;
+
+	float spotCosine = 1.0;
+
+	float fallOffFactor = 1.0f;
+
+	if(light.positionOrDirection.w < 0.98f) { // Directional
+					
+		// Normalize the light vector (points towards a light source that is an 
+		// "infinite" distance away and has no potition
+		lightVector = normalize(light.positionOrDirection.xyz);
+
+		// No attenuation for directional lights
+		attenuation = 1.0f;
+	}
+	else { // Positional
+					
+		// Calculate the light vector					
+		lightVector = normalize(light.positionOrDirection.xyz - worldPos);
+
+		// Calculate the distance to the light source
+		float distanceToLight = distance(light.positionOrDirection.xyz, worldPos);
+
+		// Calculate the attenuation to weakend the light with distance
+		attenuation = 1.0f / (light.constant + light.linear *distanceToLight + light.quadratic * distanceToLight * distanceToLight);
+
+		if (light.isSpot == true) {
+						
+			// Calculate the spot cosine used to determine if in the spotlight cone
+			spotCosine = dot(-lightVector, normalize(light.spotDirection));
+
+			// Caclate the fallOffFactor used to "blur" the edges of the spotlight cone
+			fallOffFactor = pow(spotCosine, light.spotExponent);  
+			//fallOffFactor = clamp( 1.0f - (1.0f - spotCosine) / (1.0f - light.spotCutoffCos), 0.0f, 1.0f);
+		}
+	}
+
+	vec4 color = vec4(0.0f);
+
+	// Is it a spot light and are we in the cone?
+	if ( light.isSpot == false || (light.isSpot == true && spotCosine >= light.spotCutoffCos) ) {
+
+		// Ambient reflection
+		color += attenuation * fallOffFactor * ambientColor * light.ambientColor;
+
+		// Shadows block the diffuse and specular reflection
+		fallOffFactor *= shadowFactor(light);
+
+		// Diffuse reflection
+		color += attenuation * fallOffFactor * max(dot(fragWorldNormal, lightVector), 0.0f) * diffuseColor * light.diffuseColor;
+
+		// Specular reflection
+
+		// Phong
+		vec3 reflection = normalize(reflect(-lightVector, fragWorldNormal));
+		color += attenuation * fallOffFactor * pow(max(dot(reflection, viewVector),0.0f),object.specularExp) * specularColor * light.specularColor;
+
+		// Blinn - Phong
+		//vec3 halfVector = normalize(lightVector + viewVector);
+		//color += attenuation * fallOffFactor * pow(max(dot(fragWorldNormal, halfVector),0.0f),object.specularExp) * specularColor * light.specularColor;
+	}
+
+	return color;
+}
+
 void main()
 {
 	vec4 totalColor = object.emmissiveMat;
@@ -114,7 +310,7 @@ void main()
 	// texture coordinate
 	// Needs to apply texture before lighting calculations
 	// as the texture color affects lighting.
-	if(object.diffuseTextureEnabled) {
+	if(DIFFUSE_TEXTURE_ENABLED) {
 		diffuseColor = texture( diffuseSampler, texCoord0 );
 		ambientColor = diffuseColor;
 	}
@@ -124,7 +320,7 @@ void main()
 	}
 
 	// Do the same for ambient colors
-	if (object.specularTextureEnabled) {
+	if (SPECULAR_TEXTURE_ENABLED) {
 		specularColor = texture(specularSampler, texCoord0);
 	} else {
 		specularColor = object.specularMat;
@@ -132,80 +328,29 @@ void main()
 
 	vec3 fragWorldNormal = normalize(worldNorm);
 
-	if (object.normalMapTextureEnabled) {
+	if (NORMAL_MAP_ENABLED) {
 
 		vec3 normal = texture(normalMapSampler, texCoord0).xyz;
 		normal = normalize(normal * 2.0f - 1.0f);
 		fragWorldNormal = normalize(TBN * normal);
 	}
 
-	if(object.textureMode != 1) {
-
-		 for(int i = 0; i < MaxLights ; i++) {
-
-			 if(lights[i].enabled == true ) {
-
-				vec3 lightVector;
-
-				float attenuation;
-
-				float spotCosine = 1.0;
+	if(TEXTURE_MODE != 1) {
 
-				float fallOffFactor = 1.0f;
+		vec3 viewVector = normalize(worldEyePosition - worldPos);
 
-				if(lights[i].positionOrDirection.w < 0.98f) { // Directional
-					
-					// Normalize the light vector (points towards a light source that is an 
-					// "infinite" distance away and has no potition
-					lightVector = normalize(lights[i].positionOrDirection.xyz);
-
-					// No attenuation for directional lights
-					attenuation = 1.0f;
-				}
-				else { // Positional
-					
-					// Calculate the light vector					
-					lightVector = normalize(lights[i].positionOrDirection.xyz - worldPos);
-
-					// Calculate the distance to the light source
-					float distanceToLight = distance(lights[i].positionOrDirection.xyz, worldPos);
-
-					// Calculate the attenuation to weakend the light with distance
-					attenuation = 1.0f / (lights[i].constant + lights[i].linear *distanceToLight + lights[i].quadratic * distanceToLight * distanceToLight);
-
-					if (lights[i].isSpot == true) {
-						
-						// Calculate the spot cosine used to determine if in the spotlight cone
-						spotCosine = dot(-lightVector, normalize(lights[i].spotDirection));
+		// Lights that reach everywhere
+		for (uint i = 0; i < clusterGridSize.w; i++) {
 
-						// Caclate the fallOffFactor used to "blur" the edges of the spotlight cone
-						fallOffFactor = pow(spotCosine, lights[i].spotExponent);  
-						//fallOffFactor = clamp( 1.0f - (1.0f - spotCosine) / (1.0f - lights[i].spotCutoffCos), 0.0f, 1.0f);
-					}
-				}
-
-				// Is it a spot light and are we in the cone?
-				if ( lights[i].isSpot == false || (lights[i].isSpot == true && spotCosine >= lights[i].spotCutoffCos) ) {
-
-					// Ambient reflection
-					totalColor += attenuation * fallOffFactor * ambientColor * lights[i].ambientColor;
-
-					// Diffuse reflection
-					totalColor += attenuation * fallOffFactor * max(dot(fragWorldNormal, lightVector), 0.0f) * diffuseColor * lights[i].diffuseColor;
-
-					// Specular reflection
+			totalColor += lightContribution(lightIndices[i], fragWorldNormal, viewVector, ambientColor, diffuseColor, specularColor);
+		}
 
-					vec3 viewVector = normalize(worldEyePosition - worldPos);
+		// Lights that reach the cluster containing this fragment
+		uvec2 cluster = clusters[findCluster()];
 
-					// Phong
-					vec3 reflection = normalize(reflect(-lightVector, fragWorldNormal));
-					totalColor += attenuation * fallOffFactor * pow(max(dot(reflection, viewVector),0.0f),object.specularExp) * specularColor * lights[i].specularColor;
+		for (uint i = cluster.x; i < cluster.x + cluster.y; i++) {
 
-					// Blinn - Phong
-					//vec3 halfVector = normalize(lightVector + viewVector);
-					//totalColor += attenuation * fallOffFactor * pow(max(dot(fragWorldNormal, halfVector),0.0f),object.specularExp) * specularColor * lights[i].specularColor;
-				}
-			}
+			totalColor += lightContribution(lightIndices[i], fragWorldNormal, viewVector, ambientColor, diffuseColor, specularColor);
 		}
 	}
 	else {
@@ -218,10 +363,10 @@ void main()
 	// Apply fog to the fragment
 	float fogFactor;
 	
-	if (fogMode == 0) fogFactor = 1.0f;
-	else if (fogMode == 1) fogFactor = linearFogFactor();
-	else if (fogMode == 2) fogFactor = exponentialFogFactor();
-	else if (fogMode == 3) fogFactor = exponentialTwoFogFactor();
+	if (FOG_MODE == 0) fogFactor = 1.0f;
+	else if (FOG_MODE == 1) fogFactor = linearFogFactor();
+	else if (FOG_MODE == 2) fogFactor = exponentialFogFactor();
+	else if (FOG_MODE == 3) fogFactor = exponentialTwoFogFactor();
 
 	fragmentColor = fogFactor * fragmentColor + (1 - fogFactor) * fogColor;
 
@@ -0,0 +1,8 @@
+// Targeting version 4.6 of GLSL. If the compiler does not support 4.6 it will cause an error.
+#version 460 core
+
+// Only depth is written to the shadow map
+
+void main()
+{
+}
@@ -0,0 +1,14 @@
+// Targeting version 4.6 of GLSL. If the compiler does not support 4.6 it will cause an error.
+#version 460 core
+
+// Renders the depth of shadow casters from the point of view of a light
+
+layout(location = 0) uniform mat4 lightViewProjection;
+layout(location = 1) uniform mat4 modelMatrix;
+
+layout (location = 0) in vec4 vertexPosition;
+
+void main()
+{
+	gl_Position = lightViewProjection * modelMatrix * vertexPosition;
+}
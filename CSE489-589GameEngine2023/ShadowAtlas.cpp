@@ -0,0 +1,122 @@
+#include "ShadowAtlas.h"
+
+#include <algorithm>
+
+#define VERBOSE false
+
+ShadowAtlas::ShadowAtlas(int atlasSize, int minTileSize)
+	: atlasSize(atlasSize)
+{
+	int numLevels = 1;
+	for (int size = atlasSize; size > minTileSize; size /= 2) {
+		numLevels++;
+	}
+
+	freeBlocks.resize(numLevels);
+
+	// The whole atlas starts out as one free block
+	freeBlocks[0].push_back(glm::ivec2(0, 0));
+
+} // end constructor
+
+
+int ShadowAtlas::getLevel(int tileSize) const
+{
+	int level = 0;
+	int size = atlasSize;
+
+	while (level < static_cast<int>(freeBlocks.size()) - 1 && size / 2 >= tileSize) {
+
+		size /= 2;
+		level++;
+	}
+
+	return level;
+
+} // end getLevel
+
+
+int ShadowAtlas::getTileSize(int tileSize) const
+{
+	return atlasSize >> getLevel(tileSize);
+
+} // end getTileSize
+
+
+bool ShadowAtlas::allocate(int tileSize, glm::ivec2& origin)
+{
+	int level = getLevel(tileSize);
+
+	// Find the smallest free block that is large enough
+	int freeLevel = level;
+	while (freeLevel >= 0 && freeBlocks[freeLevel].empty()) {
+		freeLevel--;
+	}
+
+	if (freeLevel < 0) {
+
+		if (VERBOSE) cout << "No room in the shadow atlas for a " << getTileSize(tileSize) << " tile" << endl;
+		return false;
+	}
+
+	glm::ivec2 block = freeBlocks[freeLevel].back();
+	freeBlocks[freeLevel].pop_back();
+
+	// Split it until it is the requested size. Keep the first quarter and free the rest.
+	for (int l = freeLevel + 1; l <= level; l++) {
+
+		int half = atlasSize >> l;
+
+		freeBlocks[l].push_back(block + glm::ivec2(half, 0));
+		freeBlocks[l].push_back(block + glm::ivec2(0, half));
+		freeBlocks[l].push_back(block + glm::ivec2(half, half));
+	}
+
+	origin = block;
+
+	return true;
+
+} // end allocate
+
+
+void ShadowAtlas::release(int tileSize, const glm::ivec2& origin)
+{
+	glm::ivec2 block = origin;
+
+	for (int level = getLevel(tileSize); level >= 0; level--) {
+
+		std::vector<glm::ivec2>& blocks = freeBlocks[level];
+
+		if (level == 0) {
+
+			blocks.push_back(block);
+			return;
+		}
+
+		// The block together with its three siblings makes up a block of the level above
+		int size = atlasSize >> level;
+		glm::ivec2 parent = (block / (2 * size)) * (2 * size);
+
+		int numFreeSiblings = 0;
+		for (const glm::ivec2& freeBlock : blocks) {
+
+			if (freeBlock != block && (freeBlock / (2 * size)) * (2 * size) == parent) {
+				numFreeSiblings++;
+			}
+		}
+
+		if (numFreeSiblings < 3) {
+
+			blocks.push_back(block);
+			return;
+		}
+
+		// Merge the four quarters and try again one level up
+		blocks.erase(std::remove_if(blocks.begin(), blocks.end(), [&](const glm::ivec2& freeBlock) {
+			return (freeBlock / (2 * size)) * (2 * size) == parent;
+		}), blocks.end());
+
+		block = parent;
+	}
+
+} // end release
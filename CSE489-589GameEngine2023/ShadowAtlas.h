@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vector>
+
+#include "MathLibsConstsFuncs.h"
+
+/**
+ * @class	ShadowAtlas
+ *
+ * @brief	Hands out square tiles of a shadow map atlas. Tile sizes are powers
+ * 			of two. Blocks are split in four until they are the requested size
+ * 			and merged again when all four quarters are free, so many lights
+ * 			with different resolutions can share a single texture.
+ */
+class ShadowAtlas
+{
+public:
+
+	/**
+	 * @fn	ShadowAtlas::ShadowAtlas(int atlasSize, int minTileSize = 128);
+	 *
+	 * @brief	Constructor.
+	 *
+	 * @param	atlasSize  	Width and height of the atlas in texels. Must be a power of two.
+	 * @param	minTileSize	(Optional) Size of the smallest tile that will be handed out.
+	 */
+	ShadowAtlas(int atlasSize, int minTileSize = 128);
+
+	/**
+	 * @fn	bool ShadowAtlas::allocate(int tileSize, glm::ivec2& origin);
+	 *
+	 * @brief	Finds a free tile. Sizes that are not powers of two are rounded up.
+	 *
+	 * @param 	   	tileSize	Width and height of the tile in texels.
+	 * @param [out]	origin  	Lower left corner of the tile in texels.
+	 *
+	 * @returns	True if a tile was found.
+	 */
+	bool allocate(int tileSize, glm::ivec2& origin);
+
+	/**
+	 * @fn	void ShadowAtlas::release(int tileSize, const glm::ivec2& origin);
+	 *
+	 * @brief	Returns a tile obtained from allocate.
+	 *
+	 * @param	tileSize	The size that was passed to allocate.
+	 * @param	origin  	The origin that allocate returned.
+	 */
+	void release(int tileSize, const glm::ivec2& origin);
+
+	/**
+	 * @fn	int ShadowAtlas::getTileSize(int tileSize) const;
+	 *
+	 * @brief	Gets the size of the tile that allocate hands out for a requested size.
+	 */
+	int getTileSize(int tileSize) const;
+
+	int getAtlasSize() const { return atlasSize; }
+
+protected:
+
+	/**
+	 * @fn	int ShadowAtlas::getLevel(int tileSize) const;
+	 *
+	 * @brief	Gets the level of the tiles of a requested size. Level zero is the
+	 * 			whole atlas and each level below has tiles half as wide.
+	 */
+	int getLevel(int tileSize) const;
+
+	int atlasSize;
+
+	/** @brief	Origins of the free blocks at each level. */
+	std::vector<std::vector<glm::ivec2>> freeBlocks;
+
+}; // end ShadowAtlas class
@@ -0,0 +1,703 @@
+#include "ShadowEngine.h"
+
+#include <algorithm>
+
+#include "BuildShaderProgram.h"
+#include "SharedLighting.h"
+#include "MeshComponent.h"
+#include "CameraComponent.h"
+
+#define VERBOSE false
+
+// Smallest tile a light is given when the atlas is too full for the size it asked for
+#define MIN_SHADOW_TILE_SIZE 128
+
+// Depth offset applied while rendering shadow maps to keep surfaces from shadowing themselves
+#define SHADOW_SLOPE_BIAS 2.0f
+#define SHADOW_CONSTANT_BIAS 4.0f
+
+// Clipping planes of the views of spot and positional lights. The far plane is
+// the range of the light when it has one.
+#define SHADOW_NEAR_CLIP 0.1f
+#define SHADOW_FAR_CLIP 1000.0f
+
+// Blend between logarithmic (1) and evenly spaced (0) cascade splits
+#define SHADOW_CASCADE_SPLIT_BLEND 0.75f
+
+// Number of cascades of each camera that are rendered every frame
+#define SHADOW_CASCADES_EVERY_FRAME 2
+
+// Locations of the uniforms in the depth only shader program
+#define LIGHT_VIEW_PROJECTION_LOCATION 0
+#define MODEL_MATRIX_LOCATION 1
+
+// ***** Definition of static members of the ShadowEngine class *****
+std::vector<ShadowEngine::ShadowLight> ShadowEngine::shadowLights;
+
+ShadowAtlas* ShadowEngine::atlas = nullptr;
+
+GLuint ShadowEngine::cacheTexture = 0;
+GLuint ShadowEngine::cacheFramebuffer = 0;
+GLuint ShadowEngine::frameTexture = 0;
+GLuint ShadowEngine::frameFramebuffer = 0;
+
+GLuint ShadowEngine::depthProgram = 0;
+
+GLuint ShadowEngine::shadowViewBuffer = 0;
+GLsizeiptr ShadowEngine::shadowViewBufferCapacity = 0;
+std::vector<ShadowView> ShadowEngine::shadowViews;
+
+std::vector<MeshComponent*> ShadowEngine::staticCasters;
+std::vector<MeshComponent*> ShadowEngine::dynamicCasters;
+
+unsigned int ShadowEngine::staticCasterVersion = 0;
+
+unsigned int ShadowEngine::frameCount = 0;
+
+std::vector<std::shared_ptr<CameraComponent>> ShadowEngine::cameras;
+
+int ShadowEngine::staticRenderCount = 0;
+
+// ********************************************************************
+
+// Creates a depth texture and a framebuffer that renders into it
+static bool createDepthTarget(int size, GLuint& texture, GLuint& framebuffer)
+{
+	glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+	glTextureStorage2D(texture, 1, GL_DEPTH_COMPONENT32F, size, size);
+
+	// Linear filtering with depth comparison gives 2x2 percentage closer filtering
+	glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(texture, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTextureParameteri(texture, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+	glCreateFramebuffers(1, &framebuffer);
+	glNamedFramebufferTexture(framebuffer, GL_DEPTH_ATTACHMENT, texture, 0);
+	glNamedFramebufferDrawBuffer(framebuffer, GL_NONE);
+	glNamedFramebufferReadBuffer(framebuffer, GL_NONE);
+
+	return glCheckNamedFramebufferStatus(framebuffer, GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+} // end createDepthTarget
+
+
+// Finds the planes of a view frustum. Points inside have a positive distance to all six.
+static void extractFrustumPlanes(const mat4& viewProjection, vec4 planes[6])
+{
+	mat4 m = glm::transpose(viewProjection);
+
+	planes[0] = m[3] + m[0];
+	planes[1] = m[3] - m[0];
+	planes[2] = m[3] + m[1];
+	planes[3] = m[3] - m[1];
+	planes[4] = m[3] + m[2];
+	planes[5] = m[3] - m[2];
+
+	for (int i = 0; i < 6; i++) {
+		planes[i] /= glm::length(vec3(planes[i]));
+	}
+
+} // end extractFrustumPlanes
+
+
+bool ShadowEngine::Init()
+{
+	ShaderInfo shaders[] = {
+		{ GL_VERTEX_SHADER, "Shaders/shadowVertexShader.glsl" },
+		{ GL_FRAGMENT_SHADER, "Shaders/shadowFragmentShader.glsl" },
+		{ GL_NONE, NULL } // signals that there are no more shaders
+	};
+
+	// The program is built while the scene loads and finished the first
+	// time the shadow maps are rendered
+	depthProgram = BuildShaderProgramAsync(shaders);
+
+	if (depthProgram == 0) {
+
+		std::cerr << "Shadow map shader program could not be built. Lights will not cast shadows." << endl;
+		return false;
+	}
+
+	bool complete = createDepthTarget(SHADOW_ATLAS_SIZE, cacheTexture, cacheFramebuffer);
+	complete = createDepthTarget(SHADOW_ATLAS_SIZE, frameTexture, frameFramebuffer) && complete;
+
+	if (!complete) {
+
+		std::cerr << "Shadow map framebuffers are incomplete. Lights will not cast shadows." << endl;
+		Stop();
+		return false;
+	}
+
+	atlas = new ShadowAtlas(SHADOW_ATLAS_SIZE, MIN_SHADOW_TILE_SIZE);
+
+	glCreateBuffers(1, &shadowViewBuffer);
+
+	if (VERBOSE) cout << "Shadow Engine Initialized" << endl;
+
+	return true;
+
+} // end Init
+
+
+void ShadowEngine::Stop()
+{
+	for (ShadowLight& shadowLight : shadowLights) {
+
+		releaseTiles(shadowLight);
+		SharedLighting::setShadowIndex(shadowLight.lightIndex, -1);
+	}
+	shadowLights.clear();
+	cameras.clear();
+
+	delete atlas;
+	atlas = nullptr;
+
+	glDeleteFramebuffers(1, &cacheFramebuffer);
+	glDeleteFramebuffers(1, &frameFramebuffer);
+	glDeleteTextures(1, &cacheTexture);
+	glDeleteTextures(1, &frameTexture);
+	glDeleteBuffers(1, &shadowViewBuffer);
+
+	cacheFramebuffer = frameFramebuffer = 0;
+	cacheTexture = frameTexture = 0;
+	shadowViewBuffer = 0;
+	shadowViewBufferCapacity = 0;
+
+	// Deleted along with the other shader programs
+	depthProgram = 0;
+
+} // end Stop
+
+
+ShadowEngine::ShadowLight* ShadowEngine::findShadowLight(int lightIndex)
+{
+	for (ShadowLight& shadowLight : shadowLights) {
+
+		if (shadowLight.lightIndex == lightIndex) {
+			return &shadowLight;
+		}
+	}
+
+	return nullptr;
+
+} // end findShadowLight
+
+
+void ShadowEngine::AddShadowLight(int lightIndex, int resolution)
+{
+	ShadowLight* shadowLight = findShadowLight(lightIndex);
+
+	if (shadowLight == nullptr) {
+
+		shadowLights.emplace_back();
+		shadowLight = &shadowLights.back();
+		shadowLight->lightIndex = lightIndex;
+	}
+	else {
+
+		releaseTiles(*shadowLight);
+	}
+
+	shadowLight->resolution = std::max(resolution, MIN_SHADOW_TILE_SIZE);
+
+} // end AddShadowLight
+
+
+void ShadowEngine::RemoveShadowLight(int lightIndex)
+{
+	for (auto iter = shadowLights.begin(); iter != shadowLights.end(); iter++) {
+
+		if (iter->lightIndex == lightIndex) {
+
+			releaseTiles(*iter);
+			SharedLighting::setShadowIndex(lightIndex, -1);
+
+			shadowLights.erase(iter);
+			return;
+		}
+	}
+
+} // end RemoveShadowLight
+
+
+void ShadowEngine::SetShadowRegion(int lightIndex, const vec3& center, float radius)
+{
+	ShadowLight* shadowLight = findShadowLight(lightIndex);
+
+	if (shadowLight != nullptr) {
+
+		shadowLight->regionCenter = center;
+		shadowLight->regionRadius = radius;
+	}
+
+} // end SetShadowRegion
+
+
+void ShadowEngine::SetShadowCascades(int lightIndex, int numCascades, float shadowDistance, int farCascadeInterval)
+{
+	ShadowLight* shadowLight = findShadowLight(lightIndex);
+
+	if (shadowLight != nullptr) {
+
+		// The tiles are laid out differently, so start over with new ones
+		releaseTiles(*shadowLight);
+
+		shadowLight->numCascades = glm::clamp(numCascades, 0, MAX_SHADOW_CASCADES);
+		shadowLight->shadowDistance = shadowDistance;
+		shadowLight->farCascadeInterval = std::max(farCascadeInterval, 1);
+	}
+
+} // end SetShadowCascades
+
+
+void ShadowEngine::StaticCastersChanged()
+{
+	staticCasterVersion++;
+
+} // end StaticCastersChanged
+
+
+void ShadowEngine::releaseTiles(ShadowLight& shadowLight)
+{
+	if (atlas != nullptr) {
+
+		for (const ShadowTile& tile : shadowLight.tiles) {
+			atlas->release(shadowLight.tileSize, tile.origin);
+		}
+	}
+
+	shadowLight.tiles.clear();
+
+} // end releaseTiles
+
+
+bool ShadowEngine::allocateTiles(ShadowLight& shadowLight, int numTiles)
+{
+	if (static_cast<int>(shadowLight.tiles.size()) == numTiles) {
+		return true;
+	}
+
+	releaseTiles(shadowLight);
+
+	for (int size = shadowLight.resolution; size >= MIN_SHADOW_TILE_SIZE; size /= 2) {
+
+		shadowLight.tileSize = atlas->getTileSize(size);
+
+		ShadowTile tile;
+		while (static_cast<int>(shadowLight.tiles.size()) < numTiles && atlas->allocate(size, tile.origin)) {
+			shadowLight.tiles.push_back(tile);
+		}
+
+		if (static_cast<int>(shadowLight.tiles.size()) == numTiles) {
+
+			if (VERBOSE && size != shadowLight.resolution) cout << "Shadow map of light " << shadowLight.lightIndex << " reduced to " << size << endl;
+			return true;
+		}
+
+		releaseTiles(shadowLight);
+	}
+
+	if (VERBOSE) cout << "No room in the shadow atlas for light " << shadowLight.lightIndex << endl;
+
+	return false;
+
+} // end allocateTiles
+
+
+int ShadowEngine::getNumViews(const ShadowLight& shadowLight)
+{
+	int lightIndex = shadowLight.lightIndex;
+
+	if (SharedLighting::getPositionOrDirection(lightIndex).w < 0.98f) {
+
+		return (shadowLight.numCascades > 0) ? shadowLight.numCascades * static_cast<int>(cameras.size()) : 1;
+	}
+
+	return SharedLighting::getIsSpot(lightIndex) ? 1 : 6;
+
+} // end getNumViews
+
+
+void ShadowEngine::computeViewProjections(const ShadowLight& shadowLight, std::vector<mat4>& viewProjections)
+{
+	int lightIndex = shadowLight.lightIndex;
+	vec4 positionOrDirection = SharedLighting::getPositionOrDirection(lightIndex);
+
+	viewProjections.clear();
+
+	if (positionOrDirection.w < 0.98f) {
+
+		vec3 towardLight = glm::normalize(vec3(positionOrDirection));
+
+		if (shadowLight.numCascades > 0) {
+
+			for (const std::shared_ptr<CameraComponent>& camera : cameras) {
+				computeCascades(shadowLight, towardLight, camera.get(), viewProjections);
+			}
+			return;
+		}
+
+		// Directional lights cover a sphere with an orthographic projection
+		vec3 up = (glm::abs(towardLight.y) < 0.99f) ? UNIT_Y_V3 : UNIT_Z_V3;
+
+		float radius = shadowLight.regionRadius;
+		mat4 view = glm::lookAt(shadowLight.regionCenter + radius * towardLight, shadowLight.regionCenter, up);
+		mat4 projection = glm::ortho(-radius, radius, -radius, radius, 0.0f, 2.0f * radius);
+
+		viewProjections.push_back(projection * view);
+		return;
+	}
+
+	vec3 position = vec3(positionOrDirection);
+	float farClip = std::min(SharedLighting::getRange(lightIndex), SHADOW_FAR_CLIP);
+	farClip = std::max(farClip, 2.0f * SHADOW_NEAR_CLIP);
+
+	if (SharedLighting::getIsSpot(lightIndex)) {
+
+		vec3 direction = SharedLighting::getSpotDirection(lightIndex);
+		vec3 up = (glm::abs(direction.y) < 0.99f) ? UNIT_Y_V3 : UNIT_Z_V3;
+
+		// Wide enough for the cone, but a perspective projection cannot reach 180 degrees
+		float cutoffCos = glm::clamp(SharedLighting::getSpotCutoffCos(lightIndex), -1.0f, 1.0f);
+		float fieldOfView = glm::clamp(2.0f * acos(cutoffCos), glm::radians(1.0f), glm::radians(170.0f));
+
+		mat4 view = glm::lookAt(position, position + direction, up);
+		mat4 projection = glm::perspective(fieldOfView, 1.0f, SHADOW_NEAR_CLIP, farClip);
+
+		viewProjections.push_back(projection * view);
+		return;
+	}
+
+	// Positional lights render a face of a cube in each of +X, -X, +Y, -Y, +Z, and -Z.
+	// The shaders pick the face from the largest component of the light to fragment vector.
+	static const vec3 faceDirections[6] = { UNIT_X_V3, -UNIT_X_V3, UNIT_Y_V3, -UNIT_Y_V3, UNIT_Z_V3, -UNIT_Z_V3 };
+	static const vec3 faceUps[6] = { UNIT_Y_V3, UNIT_Y_V3, UNIT_Z_V3, UNIT_Z_V3, UNIT_Y_V3, UNIT_Y_V3 };
+
+	mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, SHADOW_NEAR_CLIP, farClip);
+
+	for (int face = 0; face < 6; face++) {
+
+		viewProjections.push_back(projection * glm::lookAt(position, position + faceDirections[face], faceUps[face]));
+	}
+
+} // end computeViewProjections
+
+
+void ShadowEngine::computeCascades(const ShadowLight& shadowLight, const vec3& towardLight,
+	CameraComponent* camera, std::vector<mat4>& viewProjections)
+{
+	mat4 projection = camera->getProjectionMatrix();
+	mat4 inverseView = glm::inverse(camera->getViewMatrix());
+
+	// Distances to the clipping planes of the camera. Shadows end at the shadow distance.
+	float nearClip = projection[3][2] / (projection[2][2] - 1.0f);
+	float farClip = projection[3][2] / (projection[2][2] + 1.0f);
+	farClip = glm::clamp(shadowLight.shadowDistance, nearClip * 1.01f, farClip);
+
+	// Half the width and height of the view volume one unit in front of the camera
+	vec2 halfExtent(1.0f / projection[0][0], 1.0f / projection[1][1]);
+
+	// The light looks along -towardLight. Leaving out any translation keeps the
+	// texel grid of the light fixed in World coordinates.
+	vec3 up = (glm::abs(towardLight.y) < 0.99f) ? UNIT_Y_V3 : UNIT_Z_V3;
+	mat4 lightRotation = glm::lookAt(ZERO_V3, -towardLight, up);
+
+	int numCascades = shadowLight.numCascades;
+	float splitNear = nearClip;
+
+	for (int cascade = 0; cascade < numCascades; cascade++) {
+
+		// Logarithmic splits keep the texel density even with depth. Blending in
+		// evenly spaced ones keeps the first cascade from being too thin.
+		float fraction = static_cast<float>(cascade + 1) / numCascades;
+		float logSplit = nearClip * pow(farClip / nearClip, fraction);
+		float evenSplit = nearClip + (farClip - nearClip) * fraction;
+		float splitFar = glm::mix(evenSplit, logSplit, SHADOW_CASCADE_SPLIT_BLEND);
+
+		// Corners of the slice of the view volume in World coordinates
+		vec3 corners[8];
+		vec3 center = ZERO_V3;
+
+		for (int c = 0; c < 8; c++) {
+
+			float depth = (c < 4) ? splitNear : splitFar;
+			vec4 corner((c & 1) ? depth * halfExtent.x : -depth * halfExtent.x,
+				(c & 2) ? depth * halfExtent.y : -depth * halfExtent.y, -depth, 1.0f);
+
+			corners[c] = vec3(inverseView * corner);
+			center += corners[c] / 8.0f;
+		}
+
+		// A bounding sphere does not change size as the camera turns. Rounding the
+		// radius up keeps it from changing with floating point error.
+		float radius = 0.0f;
+		for (int c = 0; c < 8; c++) {
+			radius = std::max(radius, glm::length(corners[c] - center));
+		}
+		radius = ceil(radius * 16.0f) / 16.0f;
+
+		// Move the center in whole texels so the edges of the shadows do not shimmer.
+		// A border of one texel keeps the sphere inside after the center moves.
+		float halfSize = radius * shadowLight.tileSize / (shadowLight.tileSize - 2.0f);
+		float texelSize = 2.0f * halfSize / shadowLight.tileSize;
+		vec3 lightCenter = vec3(lightRotation * vec4(center, 1.0f));
+		lightCenter = glm::floor(lightCenter / texelSize) * texelSize;
+
+		// Reach back toward the light to pick up casters outside the sphere
+		mat4 cascadeProjection = glm::ortho(lightCenter.x - halfSize, lightCenter.x + halfSize,
+			lightCenter.y - halfSize, lightCenter.y + halfSize,
+			-lightCenter.z - halfSize - shadowLight.shadowDistance, -lightCenter.z + halfSize);
+
+		viewProjections.push_back(cascadeProjection * lightRotation);
+
+		splitNear = splitFar;
+	}
+
+} // end computeCascades
+
+
+bool ShadowEngine::isTileDue(const ShadowLight& shadowLight, int view)
+{
+	int numCascades = SharedLighting::getShadowCascades(shadowLight.lightIndex);
+
+	if (!shadowLight.tiles[view].rendered || numCascades == 0) {
+		return true;
+	}
+
+	int cascade = view % numCascades;
+
+	if (cascade < SHADOW_CASCADES_EVERY_FRAME) {
+		return true;
+	}
+
+	// Offset by the cascade so the far cascades take turns
+	return (frameCount + cascade) % shadowLight.farCascadeInterval == 0;
+
+} // end isTileDue
+
+
+// Casters without a bounding sphere are never culled
+static bool isOutsideView(MeshComponent* caster, const vec4 planes[6])
+{
+	vec3 center;
+	float radius;
+
+	if (caster->getBoundingSphere(center, radius)) {
+
+		for (int i = 0; i < 6; i++) {
+
+			if (glm::dot(vec3(planes[i]), center) + planes[i].w < -radius) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+
+} // end isOutsideView
+
+
+void ShadowEngine::renderCasters(const std::vector<MeshComponent*>& casters, const mat4& viewProjection,
+	const glm::ivec2& tile, int tileSize, bool clear)
+{
+	glViewport(tile.x, tile.y, tileSize, tileSize);
+	glScissor(tile.x, tile.y, tileSize, tileSize);
+
+	if (clear) {
+		glClear(GL_DEPTH_BUFFER_BIT);
+	}
+
+	glUniformMatrix4fv(LIGHT_VIEW_PROJECTION_LOCATION, 1, GL_FALSE, glm::value_ptr(viewProjection));
+
+	vec4 planes[6];
+	extractFrustumPlanes(viewProjection, planes);
+
+	for (MeshComponent* caster : casters) {
+
+		if (!isOutsideView(caster, planes)) {
+			caster->drawShadowCaster(MODEL_MATRIX_LOCATION);
+		}
+	}
+
+} // end renderCasters
+
+
+bool ShadowEngine::anyCasterInView(const std::vector<MeshComponent*>& casters, const mat4& viewProjection)
+{
+	vec4 planes[6];
+	extractFrustumPlanes(viewProjection, planes);
+
+	for (MeshComponent* caster : casters) {
+
+		if (!isOutsideView(caster, planes)) {
+			return true;
+		}
+	}
+
+	return false;
+
+} // end anyCasterInView
+
+
+void ShadowEngine::RenderShadowMaps()
+{
+	if (depthProgram == 0 || shadowLights.empty()) {
+		return;
+	}
+
+	depthProgram = finishShaderProgram(depthProgram);
+
+	if (depthProgram == 0) {
+
+		std::cerr << "Shadow map shader program could not be built. Lights will not cast shadows." << endl;
+		return;
+	}
+
+	staticCasters.clear();
+	dynamicCasters.clear();
+
+	for (auto& mesh : MeshComponent::GetMeshComponents()) {
+
+		if (mesh->getCastsShadows()) {
+
+			if (mesh->isStaticShadowCaster()) {
+				staticCasters.push_back(mesh.get());
+			}
+			else {
+				dynamicCasters.push_back(mesh.get());
+			}
+		}
+	}
+
+	glUseProgram(depthProgram);
+	glEnable(GL_SCISSOR_TEST);
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(SHADOW_SLOPE_BIAS, SHADOW_CONSTANT_BIAS);
+
+	shadowViews.clear();
+
+	cameras = CameraComponent::GetActiveCameras();
+	frameCount++;
+
+	std::vector<mat4> viewProjections;
+
+	// Bring the cached tiles that are due this frame up to date. This only renders
+	// when the view of a tile has changed or the static casters have changed.
+	glBindFramebuffer(GL_FRAMEBUFFER, cacheFramebuffer);
+
+	for (ShadowLight& shadowLight : shadowLights) {
+
+		int lightIndex = shadowLight.lightIndex;
+		shadowLight.active = false;
+
+		int numViews = SharedLighting::getEnabled(lightIndex) ? getNumViews(shadowLight) : 0;
+
+		if (numViews == 0 || !allocateTiles(shadowLight, numViews)) {
+
+			SharedLighting::setShadowIndex(lightIndex, -1);
+			continue;
+		}
+
+		bool directional = SharedLighting::getPositionOrDirection(lightIndex).w < 0.98f;
+		SharedLighting::setShadowCascades(lightIndex, directional ? shadowLight.numCascades : 0);
+
+		computeViewProjections(shadowLight, viewProjections);
+
+		for (int view = 0; view < numViews; view++) {
+
+			ShadowTile& tile = shadowLight.tiles[view];
+			tile.update = isTileDue(shadowLight, view);
+			tile.cacheChanged = false;
+
+			if (!tile.update) {
+				continue;
+			}
+
+			tile.viewProjection = viewProjections[view];
+
+			if (!tile.cacheValid || tile.cachedVersion != staticCasterVersion
+				|| tile.cachedViewProjection != tile.viewProjection) {
+
+				renderCasters(staticCasters, tile.viewProjection, tile.origin, shadowLight.tileSize, true);
+
+				tile.cachedViewProjection = tile.viewProjection;
+				tile.cachedVersion = staticCasterVersion;
+				tile.cacheValid = true;
+				tile.cacheChanged = true;
+				staticRenderCount++;
+			}
+		}
+
+		SharedLighting::setShadowIndex(lightIndex, static_cast<int>(shadowViews.size()));
+		shadowLight.active = true;
+
+		float size = static_cast<float>(shadowLight.tileSize) / SHADOW_ATLAS_SIZE;
+
+		for (const ShadowTile& tile : shadowLight.tiles) {
+
+			vec2 origin = vec2(tile.origin) / static_cast<float>(SHADOW_ATLAS_SIZE);
+			shadowViews.push_back({ tile.viewProjection, vec4(origin, size, size) });
+		}
+	}
+
+	// Start each due tile of the sampled atlas from its cached copy and add the
+	// moving casters. Tiles that are not due keep what was rendered before, as do
+	// due tiles that already match their unchanged cached copy and have no moving
+	// casters in view.
+	glBindFramebuffer(GL_FRAMEBUFFER, frameFramebuffer);
+
+	for (ShadowLight& shadowLight : shadowLights) {
+
+		if (!shadowLight.active) {
+			continue;
+		}
+
+		for (ShadowTile& tile : shadowLight.tiles) {
+
+			if (!tile.update) {
+				continue;
+			}
+
+			bool dynamicInView = anyCasterInView(dynamicCasters, tile.viewProjection);
+
+			if (tile.rendered && !tile.cacheChanged && !tile.hasDynamicCasters && !dynamicInView) {
+				continue;
+			}
+
+			glCopyImageSubData(cacheTexture, GL_TEXTURE_2D, 0, tile.origin.x, tile.origin.y, 0,
+				frameTexture, GL_TEXTURE_2D, 0, tile.origin.x, tile.origin.y, 0,
+				shadowLight.tileSize, shadowLight.tileSize, 1);
+
+			if (dynamicInView) {
+				renderCasters(dynamicCasters, tile.viewProjection, tile.origin, shadowLight.tileSize, false);
+			}
+
+			tile.hasDynamicCasters = dynamicInView;
+			tile.rendered = true;
+		}
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glDisable(GL_SCISSOR_TEST);
+
+	// Hand the views and the atlas to the shaders
+	GLsizeiptr size = shadowViews.size() * sizeof(ShadowView);
+
+	if (size > shadowViewBufferCapacity) {
+
+		shadowViewBufferCapacity = std::max(size, 2 * shadowViewBufferCapacity);
+		glNamedBufferData(shadowViewBuffer, shadowViewBufferCapacity, nullptr, GL_DYNAMIC_DRAW);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, shadowBufferBindingPoint, shadowViewBuffer);
+	}
+
+	if (size > 0) {
+		glNamedBufferSubData(shadowViewBuffer, 0, size, shadowViews.data());
+	}
+
+	glBindTextureUnit(SHADOW_ATLAS_TEXTURE_UNIT, frameTexture);
+
+} // end RenderShadowMaps
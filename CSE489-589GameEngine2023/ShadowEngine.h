@@ -0,0 +1,341 @@
+#pragma once
+
+#include "MathLibsConstsFuncs.h"
+#include "ShadowAtlas.h"
+
+using namespace constants_and_types;
+
+class MeshComponent;
+class CameraComponent;
+
+// Width and height in texels of the shadow map atlas
+#define SHADOW_ATLAS_SIZE 4096
+
+// Texture unit the shadow map atlas is bound to while the scene is rendered
+#define SHADOW_ATLAS_TEXTURE_UNIT 3
+
+// Largest number of cascades a directional light can split the view of each camera into
+#define MAX_SHADOW_CASCADES 4
+
+/**
+ * @struct	ShadowView
+ *
+ * @brief	Mirror of the ShadowView struct in the ShadowBlock of the shaders.
+ * 			One is needed for each view a light casts shadows from.
+ */
+struct ShadowView
+{
+	/** @brief	Transforms World coordinates to the clip coordinates of the view. */
+	mat4 viewProjection;
+
+	/** @brief	xy: lower left corner of the tile, zw: size of the tile. In texture coordinates. */
+	vec4 atlasRect;
+};
+
+/**
+ * @class	ShadowEngine
+ *
+ * @brief	Renders shadow maps for the lights that cast shadows. The depth maps
+ * 			of all lights share one atlas. Directional and spot lights use one
+ * 			tile and positional lights use six, one for each face of a cube.
+ *
+ * 			Directional lights can instead cascade their shadows. The view volume
+ * 			of each active camera is split into slices that get farther apart with
+ * 			distance and each slice gets a tile of its own, so nearby shadows are
+ * 			sharp while distant ones still reach the shadow distance. Cascades are
+ * 			snapped to whole texels of the light's view so the shadows do not
+ * 			shimmer as the camera moves. The far cascades can be rendered only
+ * 			every few frames.
+ *
+ * 			Meshes that are marked as static shadow casters are rendered into a
+ * 			cached copy of the atlas only when the view of a tile changes or the set
+ * 			of static casters changes. Each frame the cached tiles are copied into the atlas
+ * 			that is sampled by the shaders and the remaining casters are rendered
+ * 			on top, so the cost per frame depends on the moving objects only.
+ *
+ * 			The views and atlas tiles are passed to the shaders in the ShadowBlock.
+ * 			The shadowIndex of each light is the index of its first view. The views
+ * 			of a cascaded light hold the cascades of the first camera, nearest
+ * 			first, followed by those of each other camera.
+ *
+ * 			layout(std430) readonly buffer ShadowBlock
+ * 			{
+ * 				ShadowView shadowViews[];
+ * 			};
+ */
+class ShadowEngine
+{
+public:
+
+	/**
+	 * @fn	static bool ShadowEngine::Init();
+	 *
+	 * @brief	Creates the atlas textures and starts building the depth only shader
+	 * 			program, which is finished the first time the shadow maps are
+	 * 			rendered. Must be called after OpenGL has been initialized.
+	 *
+	 * @returns	True if it succeeds. Lights cast no shadows if it fails.
+	 */
+	static bool Init();
+
+	/**
+	 * @fn	static void ShadowEngine::RenderShadowMaps();
+	 *
+	 * @brief	Brings the shadow maps of all shadow casting lights up to date and
+	 * 			binds the atlas for the shaders. Call once each frame before the
+	 * 			lights are uploaded and the scene is rendered.
+	 */
+	static void RenderShadowMaps();
+
+	/**
+	 * @fn	static void ShadowEngine::Stop();
+	 *
+	 * @brief	Deletes the textures and buffers. Call while the OpenGL context still exists.
+	 */
+	static void Stop();
+
+	/**
+	 * @fn	static void ShadowEngine::AddShadowLight(int lightIndex, int resolution);
+	 *
+	 * @brief	Starts casting shadows from a light. Calling it again for the same
+	 * 			light changes the resolution.
+	 *
+	 * @param	lightIndex	Index of the light in SharedLighting.
+	 * @param	resolution	Width and height in texels of each shadow map of the light.
+	 */
+	static void AddShadowLight(int lightIndex, int resolution);
+
+	/**
+	 * @fn	static void ShadowEngine::RemoveShadowLight(int lightIndex);
+	 *
+	 * @brief	Stops casting shadows from a light and frees its tiles.
+	 */
+	static void RemoveShadowLight(int lightIndex);
+
+	/**
+	 * @fn	static void ShadowEngine::SetShadowRegion(int lightIndex, const vec3& center, float radius);
+	 *
+	 * @brief	Sets the sphere that the shadow map of a directional light covers.
+	 * 			The light must already cast shadows.
+	 *
+	 * @param	lightIndex	Index of the light in SharedLighting.
+	 * @param	center	  	Center of the sphere in World coordinates.
+	 * @param	radius	  	Radius of the sphere.
+	 */
+	static void SetShadowRegion(int lightIndex, const vec3& center, float radius);
+
+	/**
+	 * @fn	static void ShadowEngine::SetShadowCascades(int lightIndex, int numCascades, float shadowDistance, int farCascadeInterval);
+	 *
+	 * @brief	Makes a directional light fit cascades to the view volume of each
+	 * 			active camera instead of covering a fixed region. The light must
+	 * 			already cast shadows.
+	 *
+	 * @param	lightIndex		  	Index of the light in SharedLighting.
+	 * @param	numCascades		  	Number of cascades, up to MAX_SHADOW_CASCADES. Zero
+	 * 								goes back to the fixed region.
+	 * @param	shadowDistance	  	Distance from each camera at which shadows end.
+	 * @param	farCascadeInterval	Number of frames between renders of the cascades
+	 * 								after the first two. One renders every frame.
+	 */
+	static void SetShadowCascades(int lightIndex, int numCascades, float shadowDistance, int farCascadeInterval);
+
+	/**
+	 * @fn	static void ShadowEngine::StaticCastersChanged();
+	 *
+	 * @brief	Marks every cached shadow map as out of date. Called when a static
+	 * 			shadow caster is added or removed. Call it after moving one.
+	 */
+	static void StaticCastersChanged();
+
+	/**
+	 * @fn	static int ShadowEngine::GetStaticRenderCount()
+	 *
+	 * @brief	Gets the number of times a tile of the cached atlas has been rendered.
+	 */
+	static int GetStaticRenderCount() { return staticRenderCount; }
+
+protected:
+
+	/**
+	 * @struct	ShadowTile
+	 *
+	 * @brief	One tile of the atlas and the views its two copies were rendered from.
+	 */
+	struct ShadowTile
+	{
+		/** @brief	Lower left corner of the tile in the atlas. */
+		glm::ivec2 origin;
+
+		/** @brief	View the tile of the sampled atlas was last rendered from. */
+		mat4 viewProjection;
+
+		/** @brief	View and version of the static casters in the cached tile. */
+		mat4 cachedViewProjection;
+		unsigned int cachedVersion = 0;
+		bool cacheValid = false;
+
+		/** @brief	True once the tile of the sampled atlas has been rendered. */
+		bool rendered = false;
+
+		/** @brief	True if the cached tile was rendered this frame. */
+		bool cacheChanged = false;
+
+		/** @brief	True if moving casters were drawn over the sampled tile. */
+		bool hasDynamicCasters = false;
+
+		/** @brief	True if the tile is rendered this frame. */
+		bool update = false;
+	};
+
+	/**
+	 * @struct	ShadowLight
+	 *
+	 * @brief	Shadow state of one light.
+	 */
+	struct ShadowLight
+	{
+		int lightIndex;
+
+		/** @brief	Requested size of each tile. */
+		int resolution;
+
+		/** @brief	Size of the tiles and the tile of each view. */
+		int tileSize = 0;
+		std::vector<ShadowTile> tiles;
+
+		/** @brief	Region covered by a directional light without cascades. */
+		vec3 regionCenter = ZERO_V3;
+		float regionRadius = 50.0f;
+
+		/** @brief	Cascades of a directional light. None if it covers the region. */
+		int numCascades = 0;
+		float shadowDistance = 200.0f;
+		int farCascadeInterval = 1;
+
+		/** @brief	True if the light was given shadow views this frame. */
+		bool active = false;
+	};
+
+	/**
+	 * @fn	static ShadowLight* ShadowEngine::findShadowLight(int lightIndex);
+	 *
+	 * @brief	Finds the shadow state of a light. Returns null if the light casts no shadows.
+	 */
+	static ShadowLight* findShadowLight(int lightIndex);
+
+	/**
+	 * @fn	static int ShadowEngine::getNumViews(const ShadowLight& shadowLight);
+	 *
+	 * @brief	Gets the number of views a light casts shadows from. One for a
+	 * 			directional or spot light, six for a positional light, and the
+	 * 			number of cascades for each active camera for a cascaded light.
+	 */
+	static int getNumViews(const ShadowLight& shadowLight);
+
+	/**
+	 * @fn	static void ShadowEngine::computeViewProjections(const ShadowLight& shadowLight, std::vector<mat4>& viewProjections);
+	 *
+	 * @brief	Finds the views a light casts shadows from. The tiles of the light
+	 * 			must already be allocated.
+	 */
+	static void computeViewProjections(const ShadowLight& shadowLight, std::vector<mat4>& viewProjections);
+
+	/**
+	 * @fn	static void ShadowEngine::computeCascades(const ShadowLight& shadowLight, const vec3& towardLight, CameraComponent* camera, std::vector<mat4>& viewProjections);
+	 *
+	 * @brief	Splits the view volume of a camera into the cascades of a directional
+	 * 			light and adds the view of each cascade, nearest first.
+	 *
+	 * @param	shadowLight	   	The light.
+	 * @param	towardLight	   	Unit vector pointing toward the light.
+	 * @param	camera		   	The camera.
+	 * @param	viewProjections	The views are added to the end.
+	 */
+	static void computeCascades(const ShadowLight& shadowLight, const vec3& towardLight,
+		CameraComponent* camera, std::vector<mat4>& viewProjections);
+
+	/**
+	 * @fn	static bool ShadowEngine::isTileDue(const ShadowLight& shadowLight, int view);
+	 *
+	 * @brief	Decides whether the tile of a view is rendered this frame. Cascades
+	 * 			after the first two are spread out over the frames of their interval.
+	 */
+	static bool isTileDue(const ShadowLight& shadowLight, int view);
+
+	/**
+	 * @fn	static bool ShadowEngine::allocateTiles(ShadowLight& shadowLight, int numTiles);
+	 *
+	 * @brief	Makes sure a light has the right number of tiles. Halves the
+	 * 			resolution when the atlas is too full.
+	 *
+	 * @returns	True if the light has its tiles.
+	 */
+	static bool allocateTiles(ShadowLight& shadowLight, int numTiles);
+
+	/**
+	 * @fn	static void ShadowEngine::releaseTiles(ShadowLight& shadowLight);
+	 *
+	 * @brief	Returns the tiles of a light to the atlas.
+	 */
+	static void releaseTiles(ShadowLight& shadowLight);
+
+	/**
+	 * @fn	static void ShadowEngine::renderCasters(const std::vector<MeshComponent*>& casters, const mat4& viewProjection, const glm::ivec2& tile, int tileSize, bool clear);
+	 *
+	 * @brief	Renders the depth of shadow casters into one tile of the bound framebuffer.
+	 *
+	 * @param	casters		  	The meshes to render. Those outside the view are skipped.
+	 * @param	viewProjection	The view of the light.
+	 * @param	tile		  	Lower left corner of the tile.
+	 * @param	tileSize	  	Size of the tile.
+	 * @param	clear		  	True to clear the tile first.
+	 */
+	static void renderCasters(const std::vector<MeshComponent*>& casters, const mat4& viewProjection,
+		const glm::ivec2& tile, int tileSize, bool clear);
+
+	/**
+	 * @fn	static bool ShadowEngine::anyCasterInView(const std::vector<MeshComponent*>& casters, const mat4& viewProjection);
+	 *
+	 * @brief	Checks whether renderCasters would draw any of the casters.
+	 *
+	 * @param	casters		  	The meshes.
+	 * @param	viewProjection	The view of the light.
+	 *
+	 * @returns	False if every caster is outside the view.
+	 */
+	static bool anyCasterInView(const std::vector<MeshComponent*>& casters, const mat4& viewProjection);
+
+	static std::vector<ShadowLight> shadowLights;
+
+	static ShadowAtlas* atlas;
+
+	/** @brief	Atlas holding the static casters only and the atlas sampled by the shaders. */
+	static GLuint cacheTexture;
+	static GLuint cacheFramebuffer;
+	static GLuint frameTexture;
+	static GLuint frameFramebuffer;
+
+	/** @brief	Shader program that only writes depth. */
+	static GLuint depthProgram;
+
+	/** @brief	Buffer holding the views for the ShadowBlock and its size in bytes. */
+	static GLuint shadowViewBuffer;
+	static GLsizeiptr shadowViewBufferCapacity;
+	static std::vector<ShadowView> shadowViews;
+
+	/** @brief	Meshes that cast shadows, sorted into static and moving ones each frame. */
+	static std::vector<MeshComponent*> staticCasters;
+	static std::vector<MeshComponent*> dynamicCasters;
+
+	static unsigned int staticCasterVersion;
+
+	/** @brief	Number of times the shadow maps have been rendered. Paces the far cascades. */
+	static unsigned int frameCount;
+
+	/** @brief	Cameras the cascades are fit to this frame. */
+	static std::vector<std::shared_ptr<CameraComponent>> cameras;
+
+	static int staticRenderCount;
+
+}; // end ShadowEngine class
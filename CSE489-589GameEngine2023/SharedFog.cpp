@@ -47,6 +47,9 @@ float SharedFog::getFogEnd() {
 float SharedFog::getFogDensity() {
 	return fogDensity;
 }
+unsigned int SharedFog::getShaderFeatures() {
+	return static_cast<unsigned int>(glm::clamp(fogMode, 0, 3)) << SHADER_FOG_MODE_SHIFT;
+}
 
 // setters
 void SharedFog::setFogColor(glm::vec4 fogColor) {
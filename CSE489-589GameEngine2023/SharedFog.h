@@ -2,6 +2,7 @@
 
 #include "MathLibsConstsFuncs.h"
 #include "SharedUniformBlock.h"
+#include "BuildShaderProgram.h"
 
 #define sharedFogBlockBindingPoint 9
 
@@ -17,6 +18,9 @@ public:
 	static float getFogEnd();
 	static float getFogDensity();
 
+	// shader variant features for the current fog mode
+	static unsigned int getShaderFeatures();
+
 	// setters
 	static void setFogColor(glm::vec4 fogColor);
 	static void setFogMode(int fogMode);
@@ -1,167 +1,442 @@
 #include "SharedLighting.h"
 
-#include <sstream> 
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
 
-GeneralLight SharedLighting::lights[MAX_LIGHTS];
+#define VERBOSE false
 
-const std::string SharedLighting::generalLightBlockName = "LightBlock";
+// Lights whose contribution falls below this fraction of their brightest color are left out of a cluster
+#define LIGHT_CUTOFF_INTENSITY (1.0f / 256.0f)
 
-SharedUniformBlock SharedLighting::lightBlock(generalLightBlockBindingPoint);
+#define NUM_CLUSTERS (CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z)
+
+// Number of uvec2 entries in front of the clusters array that hold the ClusterHeader
+#define CLUSTER_HEADER_ENTRIES (sizeof(SharedLighting::ClusterHeader) / sizeof(glm::uvec2))
+
+// ***** Definition of static members of the SharedLighting class *****
+std::vector<GeneralLight> SharedLighting::lights;
+
+std::vector<bool> SharedLighting::lightsInUse;
+
+size_t SharedLighting::dirtyBegin = 0;
+size_t SharedLighting::dirtyEnd = 0;
+
+GLuint SharedLighting::lightBuffer = 0;
+GLsizeiptr SharedLighting::lightBufferCapacity = 0;
+GLuint SharedLighting::clusterBuffer = 0;
+GLsizeiptr SharedLighting::clusterBufferCapacity = 0;
+GLuint SharedLighting::lightIndexBuffer = 0;
+GLsizeiptr SharedLighting::lightIndexBufferCapacity = 0;
+
+std::vector<vec3> SharedLighting::clusterMin;
+std::vector<vec3> SharedLighting::clusterMax;
+
+std::vector<glm::uvec2> SharedLighting::clusterData;
+std::vector<GLuint> SharedLighting::lightIndices;
+int SharedLighting::numGlobalLights = 0;
+
+std::vector<glm::uvec2> SharedLighting::assignments;
+
+const std::string SharedLighting::lightBlockName = "LightBlock";
+const std::string SharedLighting::clusterBlockName = "ClusterBlock";
+const std::string SharedLighting::lightIndexBlockName = "LightIndexBlock";
+const std::string SharedLighting::shadowBlockName = "ShadowBlock";
+
+// ********************************************************************
+
+// Assigns a shader storage block of a shader program to a binding point
+static void bindStorageBlock(GLuint shaderProgram, const std::string& blockName, GLuint bindingPoint)
+{
+	GLuint blockIndex = glGetProgramResourceIndex(shaderProgram, GL_SHADER_STORAGE_BLOCK, blockName.c_str());
+
+	if (checkBlockLocationFound(blockName.c_str(), blockIndex)) {
+
+		glShaderStorageBlockBinding(shaderProgram, blockIndex, bindingPoint);
+	}
+
+} // end bindStorageBlock
 
 
 void SharedLighting::setUniformBlockForShader(GLuint shaderProgram)
 {
-	std::vector <std::string > lightBlockMemberNames = buildUniformBlockNameList();
+	bindStorageBlock(shaderProgram, lightBlockName, lightBufferBindingPoint);
+	bindStorageBlock(shaderProgram, clusterBlockName, clusterBufferBindingPoint);
+	bindStorageBlock(shaderProgram, lightIndexBlockName, lightIndexBufferBindingPoint);
+	bindStorageBlock(shaderProgram, shadowBlockName, shadowBufferBindingPoint);
+
+	if (lightBuffer == 0) {
+
+		glGenBuffers(1, &lightBuffer);
+		glGenBuffers(1, &clusterBuffer);
+		glGenBuffers(1, &lightIndexBuffer);
+
+		// Lights may have been added before the buffers existed
+		uploadBuffer(lightBuffer, lightBufferCapacity, lightBufferBindingPoint, lights.data(), lights.size() * sizeof(GeneralLight));
+		dirtyBegin = dirtyEnd = 0;
+
+		// A single empty cluster until the first camera culls the lights
+		ClusterHeader header = { glm::uvec4(1, 1, 1, 0), vec4(0.0f), vec4(0.0f), vec4(0.0f) };
+		clusterData.assign(CLUSTER_HEADER_ENTRIES + 1, glm::uvec2(0));
+		memcpy(clusterData.data(), &header, sizeof(ClusterHeader));
+		uploadBuffer(clusterBuffer, clusterBufferCapacity, clusterBufferBindingPoint, clusterData.data(), clusterData.size() * sizeof(glm::uvec2));
+		uploadBuffer(lightIndexBuffer, lightIndexBufferCapacity, lightIndexBufferBindingPoint, nullptr, 0);
+	}
+
+} // end setUniformBlockForShader
+
+
+void SharedLighting::uploadBuffer(GLuint buffer, GLsizeiptr& capacity, GLuint bindingPoint, const void* data, GLsizeiptr size)
+{
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+
+	if (size > capacity || capacity == 0) {
+
+		// Grow geometrically so that adding lights one at a time does not reallocate every time
+		capacity = std::max(std::max(size, 2 * capacity), static_cast<GLsizeiptr>(256));
+		glBufferData(GL_SHADER_STORAGE_BUFFER, capacity, nullptr, GL_DYNAMIC_DRAW);
 
-	std::vector<GLint> uniformOffsets = lightBlock.setUniformBlockForShader(shaderProgram,
-		generalLightBlockName,
-		lightBlockMemberNames);
-	int offsetIndex = 0;
+		// The binding refers to the buffer object, but set it here so new buffers are bound as well
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bindingPoint, buffer);
+	}
 
-	for (int i = 0; i < MAX_LIGHTS; i++) {
+	if (size > 0) {
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, data);
+	}
 
-		// Light color locations
-		lights[i].ambientColorLoc = uniformOffsets[offsetIndex++];
-		lights[i].diffuseColorLoc = uniformOffsets[offsetIndex++];
-		lights[i].specularColorLoc = uniformOffsets[offsetIndex++];
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
-		// Position and direction location
-		lights[i].positionOrDirectionLoc = uniformOffsets[offsetIndex++];
+} // end uploadBuffer
 
-		// Spotlight locations
-		lights[i].spotDirectionLoc = uniformOffsets[offsetIndex++];
-		lights[i].isSpotLoc = uniformOffsets[offsetIndex++];
-		lights[i].spotCutoffCosLoc = uniformOffsets[offsetIndex++];
-		lights[i].spotExponentLoc = uniformOffsets[offsetIndex++];
 
-		//Attenuation factor locations
-		lights[i].constantLoc = uniformOffsets[offsetIndex++];
-		lights[i].linearLoc = uniformOffsets[offsetIndex++];
-		lights[i].quadraticLoc = uniformOffsets[offsetIndex++];
+void SharedLighting::markDirty(size_t begin, size_t end)
+{
+	if (dirtyBegin >= dirtyEnd) {
 
-		// Enabled location
-		lights[i].enabledLoc = uniformOffsets[offsetIndex++];
+		dirtyBegin = begin;
+		dirtyEnd = end;
+	}
+	else {
 
-		// Initialize the attributes of the light to something meaningful
-		initilizeAttributes(i);
+		dirtyBegin = std::min(dirtyBegin, begin);
+		dirtyEnd = std::max(dirtyEnd, end);
 	}
 
-} // end setUniformBlockForShader
+} // end markDirty
 
 
-std::vector<std::string> SharedLighting::buildUniformBlockNameList()
+template <typename T>
+void SharedLighting::setLightMember(int lightIndex, T GeneralLight::* member, const T& value)
 {
-	static const int NUM_LIGHT_ATTRIBUTES = 12;
+	GeneralLight& light = lights[lightIndex];
 
-	// Get the indices of the uniform block variables in the shader
-	static const std::string names[NUM_LIGHT_ATTRIBUTES]
-		= { "ambientColor", "diffuseColor", "specularColor",
-		"positionOrDirection", "spotDirection",
-		"isSpot", "spotCutoffCos", "spotExponent",
-		"constant", "linear", "quadratic", "enabled" };
+	if (light.*member == value) {
+		return;
+	}
 
-	std::vector<std::string> uniformBlockNames;
+	light.*member = value;
 
-	for (int lightNumber = 0; lightNumber < MAX_LIGHTS; lightNumber++) {
+	size_t begin = lightIndex * sizeof(GeneralLight) + (reinterpret_cast<const char*>(&(light.*member)) - reinterpret_cast<const char*>(&light));
+	markDirty(begin, begin + sizeof(T));
 
-		// Get string representation of the int
-		std::string numberStrg = std::to_string(lightNumber);
+} // end setLightMember
 
-		std::string uniformNames[NUM_LIGHT_ATTRIBUTES];
 
-		for (int i = 0; i < NUM_LIGHT_ATTRIBUTES; i++) {
+void SharedLighting::uploadLights()
+{
+	if (lightBuffer == 0 || dirtyBegin >= dirtyEnd) {
+		return;
+	}
 
-			uniformBlockNames.push_back("lights[" + numberStrg + "]." + names[i]);
-		}
+	GLsizeiptr requiredSize = lights.size() * sizeof(GeneralLight);
+
+	if (requiredSize > lightBufferCapacity) {
 
+		// Lights were added that do not fit. Copy all of them into a larger buffer.
+		uploadBuffer(lightBuffer, lightBufferCapacity, lightBufferBindingPoint, lights.data(), requiredSize);
 	}
+	else {
 
-	return uniformBlockNames;
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, lightBuffer);
 
-}
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, dirtyBegin, dirtyEnd - dirtyBegin,
+			reinterpret_cast<const char*>(lights.data()) + dirtyBegin);
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	dirtyBegin = dirtyEnd = 0;
 
+} // end uploadLights
 
-void SharedLighting::initilizeAttributes(GLint lightNumber)
+
+int SharedLighting::allocateLight()
 {
-	setEnabled(lightNumber, lights[lightNumber].enabled);
+	for (int i = 0; i < static_cast<int>(lightsInUse.size()); i++) {
 
-	setAmbientColor(lightNumber, lights[lightNumber].ambientColor);
-	setDiffuseColor(lightNumber, lights[lightNumber].diffuseColor);
-	setSpecularColor(lightNumber, lights[lightNumber].specularColor);
+		if (lightsInUse[i] == false) {
 
-	setPositionOrDirection(lightNumber, lights[lightNumber].positionOrDirection);
+			lightsInUse[i] = true;
+			return i;
+		}
+	}
 
-	setIsSpot(lightNumber, lights[lightNumber].isSpot);
-	setSpotDirection(lightNumber, lights[lightNumber].spotDirection);
-	setSpotCutoffCos(lightNumber, lights[lightNumber].spotCutoffCos);
-	setSpotExponent(lightNumber, lights[lightNumber].spotExponent);
+	lights.emplace_back();
+	lightsInUse.push_back(true);
 
-	setConstantAttenuation(lightNumber, lights[lightNumber].constant);
-	setLinearAttenuation(lightNumber, lights[lightNumber].linear);
-	setQuadraticAttenuation(lightNumber, lights[lightNumber].quadratic);
+	int lightIndex = static_cast<int>(lights.size()) - 1;
+	markDirty(lightIndex * sizeof(GeneralLight), (lightIndex + 1) * sizeof(GeneralLight));
 
-}
+	return lightIndex;
 
+} // end allocateLight
 
-void SharedLighting::setEnabled(int lightIndex, bool on)
+
+void SharedLighting::releaseLight(int lightIndex)
 {
-	// Bind the buffer. 
-	glBindBuffer(GL_UNIFORM_BUFFER, lightBlock.getBuffer());
+	lights[lightIndex] = GeneralLight();
+	markDirty(lightIndex * sizeof(GeneralLight), (lightIndex + 1) * sizeof(GeneralLight));
 
-	lights[lightIndex].enabled = on;
+	lightsInUse[lightIndex] = false;
 
-	glBufferSubData(GL_UNIFORM_BUFFER, lights[lightIndex].enabledLoc, sizeof(bool), &lights[lightIndex].enabled);
+} // end releaseLight
 
-	// Unbind the buffer. 
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
-}
 
-void SharedLighting::setAmbientColor(int lightIndex, glm::vec4 color4)
+float SharedLighting::getLightRange(const GeneralLight& light)
 {
-	// Bind the buffer. 
-	glBindBuffer(GL_UNIFORM_BUFFER, lightBlock.getBuffer());
+	vec4 brightest = glm::max(glm::max(light.ambientColor, light.diffuseColor), light.specularColor);
+	float intensity = std::max(std::max(brightest.r, brightest.g), brightest.b);
 
-	lights[lightIndex].ambientColor = color4;
-	glBufferSubData(GL_UNIFORM_BUFFER, lights[lightIndex].ambientColorLoc, sizeof(glm::vec4), value_ptr(lights[lightIndex].ambientColor));
+	// Solve constant + linear * d + quadratic * d^2 = intensity / cutoff for d
+	float c = light.constant - intensity / LIGHT_CUTOFF_INTENSITY;
 
-	// Unbind the buffer. 
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
-}
+	if (c >= 0.0f) {
+		return 0.0f;
+	}
+	else if (light.quadratic > 0.0f) {
+		return (-light.linear + sqrt(light.linear * light.linear - 4.0f * light.quadratic * c)) / (2.0f * light.quadratic);
+	}
+	else if (light.linear > 0.0f) {
+		return -c / light.linear;
+	}
 
-void SharedLighting::setDiffuseColor(int lightIndex, glm::vec4 color4)
+	return POS_INFINITY;
+
+} // end getLightRange
+
+
+void SharedLighting::cullLights(const mat4& viewMatrix, const mat4& projectionMatrix, const glm::ivec4& viewport, int cameraIndex)
 {
-	// Bind the buffer. 
-	glBindBuffer(GL_UNIFORM_BUFFER, lightBlock.getBuffer());
+	if (lightBuffer == 0) {
+		return;
+	}
+
+	// Distances to the clipping planes of the perspective projection
+	float nearClip = projectionMatrix[3][2] / (projectionMatrix[2][2] - 1.0f);
+	float farClip = projectionMatrix[3][2] / (projectionMatrix[2][2] + 1.0f);
+
+	// Slices are spaced exponentially so clusters are roughly cube shaped at every depth
+	float logDepthRatio = log(farClip / nearClip);
+	float sliceScale = CLUSTER_GRID_Z / logDepthRatio;
+	float sliceBias = -CLUSTER_GRID_Z * log(nearClip) / logDepthRatio;
 
-	lights[lightIndex].diffuseColor = color4;
-	glBufferSubData(GL_UNIFORM_BUFFER, lights[lightIndex].diffuseColorLoc, sizeof(glm::vec4), value_ptr(lights[lightIndex].diffuseColor));
+	mat4 inverseProjection = glm::inverse(projectionMatrix);
+
+	// Find the view space bounds of each cluster from the corners of its tile
+	clusterMin.resize(NUM_CLUSTERS);
+	clusterMax.resize(NUM_CLUSTERS);
+
+	for (int y = 0; y < CLUSTER_GRID_Y; y++) {
+
+		for (int x = 0; x < CLUSTER_GRID_X; x++) {
+
+			// Points on the near plane at the corners of the tile
+			vec3 corners[4];
+			for (int c = 0; c < 4; c++) {
+
+				vec4 ndc(2.0f * (x + (c & 1)) / CLUSTER_GRID_X - 1.0f, 2.0f * (y + (c >> 1)) / CLUSTER_GRID_Y - 1.0f, -1.0f, 1.0f);
+				vec4 corner = inverseProjection * ndc;
+				corners[c] = vec3(corner) / corner.w;
+			}
+
+			for (int z = 0; z < CLUSTER_GRID_Z; z++) {
+
+				float sliceNear = nearClip * pow(farClip / nearClip, static_cast<float>(z) / CLUSTER_GRID_Z);
+				float sliceFar = nearClip * pow(farClip / nearClip, static_cast<float>(z + 1) / CLUSTER_GRID_Z);
+
+				int cluster = (z * CLUSTER_GRID_Y + y) * CLUSTER_GRID_X + x;
+				clusterMin[cluster] = vec3(POS_INFINITY);
+				clusterMax[cluster] = vec3(NEG_INFINITY);
+
+				for (const vec3& corner : corners) {
+
+					// Scale the ray through the corner out to the depth of each end of the slice
+					for (float depth : { sliceNear, sliceFar }) {
+
+						vec3 point = corner * (depth / -corner.z);
+						clusterMin[cluster] = glm::min(clusterMin[cluster], point);
+						clusterMax[cluster] = glm::max(clusterMax[cluster], point);
+					}
+				}
+			}
+		}
+	}
+
+	lightIndices.clear();
+	assignments.clear();
+
+	// Lights that reach every fragment come first
+	for (int i = 0; i < static_cast<int>(lights.size()); i++) {
+
+		const GeneralLight& light = lights[i];
+
+		if (lightsInUse[i] && light.enabled && (light.positionOrDirection.w < 0.98f || getLightRange(light) == POS_INFINITY)) {
+			lightIndices.push_back(i);
+		}
+	}
+	numGlobalLights = static_cast<int>(lightIndices.size());
 
-	// Unbind the buffer.
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	for (int i = 0; i < static_cast<int>(lights.size()); i++) {
+
+		const GeneralLight& light = lights[i];
+
+		if (!lightsInUse[i] || !light.enabled || light.positionOrDirection.w < 0.98f) {
+			continue;
+		}
+
+		float range = getLightRange(light);
+
+		if (range <= 0.0f || range == POS_INFINITY) {
+			continue;
+		}
+
+		vec3 center = vec3(viewMatrix * vec4(vec3(light.positionOrDirection), 1.0f));
+
+		// Depth range of the sphere of influence
+		float minDepth = -center.z - range;
+		float maxDepth = -center.z + range;
+
+		if (maxDepth < nearClip || minDepth > farClip) {
+			continue;
+		}
+
+		int minZ = glm::clamp(static_cast<int>(floor(log(std::max(minDepth, nearClip)) * sliceScale + sliceBias)), 0, CLUSTER_GRID_Z - 1);
+		int maxZ = glm::clamp(static_cast<int>(floor(log(std::min(maxDepth, farClip)) * sliceScale + sliceBias)), 0, CLUSTER_GRID_Z - 1);
+
+		int minX = 0, maxX = CLUSTER_GRID_X - 1;
+		int minY = 0, maxY = CLUSTER_GRID_Y - 1;
+
+		// Spheres that reach behind the near plane may cover any tile
+		if (minDepth > nearClip) {
+
+			// Project the corners of the box around the sphere to find the tiles it covers
+			vec2 ndcMin(POS_INFINITY), ndcMax(NEG_INFINITY);
+
+			for (int c = 0; c < 8; c++) {
+
+				vec3 corner = center + range * vec3((c & 1) ? 1.0f : -1.0f, (c & 2) ? 1.0f : -1.0f, (c & 4) ? 1.0f : -1.0f);
+				vec4 clip = projectionMatrix * vec4(corner, 1.0f);
+				vec2 ndc = vec2(clip) / clip.w;
+
+				ndcMin = glm::min(ndcMin, ndc);
+				ndcMax = glm::max(ndcMax, ndc);
+			}
+
+			if (ndcMax.x < -1.0f || ndcMin.x > 1.0f || ndcMax.y < -1.0f || ndcMin.y > 1.0f) {
+				continue;
+			}
+
+			minX = glm::clamp(static_cast<int>(floor((ndcMin.x + 1.0f) * 0.5f * CLUSTER_GRID_X)), 0, CLUSTER_GRID_X - 1);
+			maxX = glm::clamp(static_cast<int>(floor((ndcMax.x + 1.0f) * 0.5f * CLUSTER_GRID_X)), 0, CLUSTER_GRID_X - 1);
+			minY = glm::clamp(static_cast<int>(floor((ndcMin.y + 1.0f) * 0.5f * CLUSTER_GRID_Y)), 0, CLUSTER_GRID_Y - 1);
+			maxY = glm::clamp(static_cast<int>(floor((ndcMax.y + 1.0f) * 0.5f * CLUSTER_GRID_Y)), 0, CLUSTER_GRID_Y - 1);
+		}
+
+		float rangeSquared = range * range;
+
+		for (int z = minZ; z <= maxZ; z++) {
+
+			for (int y = minY; y <= maxY; y++) {
+
+				for (int x = minX; x <= maxX; x++) {
+
+					int cluster = (z * CLUSTER_GRID_Y + y) * CLUSTER_GRID_X + x;
+
+					// Distance from the center of the sphere to the closest point in the cluster
+					vec3 closest = glm::clamp(center, clusterMin[cluster], clusterMax[cluster]);
+					vec3 offset = closest - center;
+
+					if (glm::dot(offset, offset) <= rangeSquared) {
+						assignments.push_back(glm::uvec2(cluster, i));
+					}
+				}
+			}
+		}
+	}
+
+	// Counting sort of the assignments by cluster
+	clusterData.assign(CLUSTER_HEADER_ENTRIES + NUM_CLUSTERS, glm::uvec2(0));
+	glm::uvec2* clusters = clusterData.data() + CLUSTER_HEADER_ENTRIES;
+
+	for (const glm::uvec2& assignment : assignments) {
+		clusters[assignment.x].y++;
+	}
+
+	GLuint offset = numGlobalLights;
+	for (int cluster = 0; cluster < NUM_CLUSTERS; cluster++) {
+
+		clusters[cluster].x = offset;
+		offset += clusters[cluster].y;
+		clusters[cluster].y = 0;
+	}
+
+	lightIndices.resize(offset);
+
+	for (const glm::uvec2& assignment : assignments) {
+
+		glm::uvec2& cluster = clusters[assignment.x];
+		lightIndices[cluster.x + cluster.y++] = assignment.y;
+	}
+
+	// Values the fragment shader needs to find the cluster of a fragment
+	ClusterHeader header;
+	header.gridSize = glm::uvec4(CLUSTER_GRID_X, CLUSTER_GRID_Y, CLUSTER_GRID_Z, numGlobalLights);
+	header.tiles = vec4(viewport.x, viewport.y, static_cast<float>(CLUSTER_GRID_X) / viewport.z, static_cast<float>(CLUSTER_GRID_Y) / viewport.w);
+	header.depthRow = vec4(viewMatrix[0][2], viewMatrix[1][2], viewMatrix[2][2], viewMatrix[3][2]);
+	header.slices = vec4(sliceScale, sliceBias, static_cast<float>(cameraIndex), 0.0f);
+	memcpy(clusterData.data(), &header, sizeof(ClusterHeader));
+
+	uploadBuffer(clusterBuffer, clusterBufferCapacity, clusterBufferBindingPoint, clusterData.data(), clusterData.size() * sizeof(glm::uvec2));
+	uploadBuffer(lightIndexBuffer, lightIndexBufferCapacity, lightIndexBufferBindingPoint, lightIndices.data(), lightIndices.size() * sizeof(GLuint));
+
+	if (VERBOSE) cout << numGlobalLights << " global lights and " << assignments.size() << " cluster assignments" << endl;
+
+} // end cullLights
+
+
+void SharedLighting::setEnabled(int lightIndex, bool on)
+{
+	setLightMember(lightIndex, &GeneralLight::enabled, static_cast<GLuint>(on));
 }
 
-void SharedLighting::setSpecularColor(int lightIndex, glm::vec4 color4)
+void SharedLighting::setAmbientColor(int lightIndex, glm::vec4 color4)
 {
-	// Bind the buffer. 
-	glBindBuffer(GL_UNIFORM_BUFFER, lightBlock.getBuffer());
+	setLightMember(lightIndex, &GeneralLight::ambientColor, color4);
+}
 
-	lights[lightIndex].specularColor = color4;
-	glBufferSubData(GL_UNIFORM_BUFFER, lights[lightIndex].specularColorLoc, sizeof(glm::vec4), value_ptr(lights[lightIndex].specularColor));
+void SharedLighting::setDiffuseColor(int lightIndex, glm::vec4 color4)
+{
+	setLightMember(lightIndex, &GeneralLight::diffuseColor, color4);
+}
 
-	// Unbind the buffer. 
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+void SharedLighting::setSpecularColor(int lightIndex, glm::vec4 color4)
+{
+	setLightMember(lightIndex, &GeneralLight::specularColor, color4);
 }
 
 void SharedLighting::setPositionOrDirection(int lightIndex, glm::vec4 positOrDirect)
 {
-	// Bind the buffer. 
-	glBindBuffer(GL_UNIFORM_BUFFER, lightBlock.getBuffer());
-
-	lights[lightIndex].positionOrDirection = positOrDirect;
-	glBufferSubData(GL_UNIFORM_BUFFER, lights[lightIndex].positionOrDirectionLoc, sizeof(glm::vec4), value_ptr(lights[lightIndex].positionOrDirection));
-
-	// Unbind the buffer. 
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	setLightMember(lightIndex, &GeneralLight::positionOrDirection, positOrDirect);
 }
 
 void SharedLighting::setAttenuationFactors(int lightIndex, glm::vec3 factors)
@@ -174,81 +449,45 @@ void SharedLighting::setAttenuationFactors(int lightIndex, glm::vec3 factors)
 
 void SharedLighting::setConstantAttenuation(int lightIndex, float factor)
 {
-	// Bind the buffer. 
-	glBindBuffer(GL_UNIFORM_BUFFER, lightBlock.getBuffer());
-
-	lights[lightIndex].constant = factor;
-	glBufferSubData(GL_UNIFORM_BUFFER, lights[lightIndex].constantLoc, sizeof(float), &lights[lightIndex].constant);
-
-	// Unbind the buffer. 
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	setLightMember(lightIndex, &GeneralLight::constant, factor);
 }
 
 void SharedLighting::setLinearAttenuation(int lightIndex, float factor)
 {
-	// Bind the buffer. 
-	glBindBuffer(GL_UNIFORM_BUFFER, lightBlock.getBuffer());
-
-	lights[lightIndex].linear = factor;
-	glBufferSubData(GL_UNIFORM_BUFFER, lights[lightIndex].linearLoc, sizeof(float), &lights[lightIndex].linear);
-
-	// Unbind the buffer. 
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	setLightMember(lightIndex, &GeneralLight::linear, factor);
 }
 
 void SharedLighting::setQuadraticAttenuation(int lightIndex, float factor)
 {
-	// Bind the buffer. 
-	glBindBuffer(GL_UNIFORM_BUFFER, lightBlock.getBuffer());
-
-	lights[lightIndex].quadratic = factor;
-	glBufferSubData(GL_UNIFORM_BUFFER, lights[lightIndex].quadraticLoc, sizeof(float), &lights[lightIndex].quadratic);
-
-	// Unbind the buffer. 
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	setLightMember(lightIndex, &GeneralLight::quadratic, factor);
 }
 
 void SharedLighting::setIsSpot(int lightIndex, bool spotOn)
 {
-	glBindBuffer(GL_UNIFORM_BUFFER, lightBlock.getBuffer());
-
-	lights[lightIndex].isSpot = spotOn;
-
-	glBufferSubData(GL_UNIFORM_BUFFER, lights[lightIndex].isSpotLoc, sizeof(bool), &lights[lightIndex].isSpot);
-
-	// Unbind the buffer. 
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	setLightMember(lightIndex, &GeneralLight::isSpot, static_cast<GLuint>(spotOn));
 }
 
 void SharedLighting::setSpotDirection(int lightIndex, glm::vec3 spotDirect)
 {
-	glBindBuffer(GL_UNIFORM_BUFFER, lightBlock.getBuffer());
-
-	lights[lightIndex].spotDirection = glm::normalize(spotDirect);
-	glBufferSubData(GL_UNIFORM_BUFFER, lights[lightIndex].spotDirectionLoc, sizeof(glm::vec3), value_ptr(lights[lightIndex].spotDirection));
-
-	// Unbind the buffer. 
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	setLightMember(lightIndex, &GeneralLight::spotDirection, glm::normalize(spotDirect));
 }
 
 void SharedLighting::setSpotCutoffCos(int lightIndex, float cutoffCos)
 {
-	glBindBuffer(GL_UNIFORM_BUFFER, lightBlock.getBuffer());
-
-	lights[lightIndex].spotCutoffCos = cutoffCos;
-	glBufferSubData(GL_UNIFORM_BUFFER, lights[lightIndex].spotCutoffCosLoc, sizeof(float), &lights[lightIndex].spotCutoffCos);
-
-	// Unbind the buffer. 
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	setLightMember(lightIndex, &GeneralLight::spotCutoffCos, cutoffCos);
 }
 
 void SharedLighting::setSpotExponent(int lightIndex, float spotEx)
 {
-	glBindBuffer(GL_UNIFORM_BUFFER, lightBlock.getBuffer());
+	setLightMember(lightIndex, &GeneralLight::spotExponent, spotEx);
+}
 
-	lights[lightIndex].spotExponent = spotEx;
-	glBufferSubData(GL_UNIFORM_BUFFER, lights[lightIndex].spotExponentLoc, sizeof(float), &lights[lightIndex].spotExponent);
+void SharedLighting::setShadowIndex(int lightIndex, int shadowIndex)
+{
+	setLightMember(lightIndex, &GeneralLight::shadowIndex, static_cast<GLint>(shadowIndex));
+}
 
-	// Unbind the buffer. 
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
-}
\ No newline at end of file
+void SharedLighting::setShadowCascades(int lightIndex, int numCascades)
+{
+	setLightMember(lightIndex, &GeneralLight::shadowCascades, static_cast<GLint>(numCascades));
+}
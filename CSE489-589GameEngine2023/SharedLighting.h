@@ -2,63 +2,152 @@
 
 #include "SharedUniformBlock.h"
 
-#define generalLightBlockBindingPoint 24
-
-// Maximum number of lights
-// If this is increased, the enumerated type below needs to be extended and the 
-// size of the lights array in the shader program needs to be adjusted.
-#define MAX_LIGHTS 16
-
-// Structure for holding the attributes of an individual light source
+// Binding points of the shader storage blocks that hold the lights and the clusters
+#define lightBufferBindingPoint 24
+#define clusterBufferBindingPoint 25
+#define lightIndexBufferBindingPoint 26
+#define shadowBufferBindingPoint 27
+
+// Number of clusters across, up, and into the view volume of each camera.
+// These must match the values used to size the ClusterBlock in the shaders.
+#define CLUSTER_GRID_X 16
+#define CLUSTER_GRID_Y 9
+#define CLUSTER_GRID_Z 24
+
+// Structure for holding the attributes of an individual light source. The
+// layout matches the std430 layout of GeneralLight in the shader programs
+// so lights can be copied straight into the shader storage buffer.
 struct GeneralLight {
 
-	GLint ambientColorLoc;
 	vec4 ambientColor = 0.15f * WHITE_RGBA;		// ambient color of the light
-	GLint diffuseColorLoc;
 	vec4 diffuseColor = WHITE_RGBA;				// diffuse color of the light
-	GLint specularColorLoc;
 	vec4 specularColor = WHITE_RGBA;			// specular color of the light
 
 	// Either the position or direction
 	// if w = 0 then the light is directional
 	// if w = 1 then the light is positional
 	// direction is the negative of the direction the light is shinning
-	GLint positionOrDirectionLoc;
 	glm::vec4 positionOrDirection = vec4(1.0f, 1.0f, 1.0f, 0.0f);
 
 	// spotlight attributes
-	GLint spotDirectionLoc;
-	glm::vec3 spotDirection = vec3(0.0f, 0.0f, -1.0f);		// the direction the cone of light is shinning      
-	GLint isSpotLoc;
-	bool isSpot = false;					// true if the light is a spotlight
-	GLint spotCutoffCosLoc;
+	glm::vec3 spotDirection = vec3(0.0f, 0.0f, -1.0f);		// the direction the cone of light is shinning
+	GLuint isSpot = false;					// true if the light is a spotlight
 	float spotCutoffCos = glm::radians(180.0f);	// Cosine of the spot cutoff angle
-	GLint spotExponentLoc;
 	float spotExponent = 50.0f;				// spot exponent for falloff calculation
 
 	// attenuation coefficients
-	GLint constantLoc;
 	float constant = 1.0f;
-	GLint linearLoc;
 	float linear = 0.0f;
-	GLint quadraticLoc;
 	float quadratic = 0.0f;
 
-	GLint enabledLoc;
-	bool enabled = false;			// true if light is "on"
+	GLuint enabled = false;			// true if light is "on"
+
+	GLint shadowIndex = -1;			// index of the first shadow view of the light or -1 if it casts no shadows
+
+	GLint shadowCascades = 0;		// number of cascades of each camera if the shadow views of a directional light are cascaded
+};
+
+static_assert(sizeof(GeneralLight) == 112, "GeneralLight must match the std430 layout of the shader struct");
+
+/**
+
+A static class that holds the attributes of every light in the scene and assigns
+the lights to clusters for clustered forward shading.
+
+There is no fixed limit on the number of lights. They are stored in a shader
+storage buffer. Before the scene is rendered from the perspective of a camera,
+cullLights divides the view volume of the camera into a grid of clusters (tiles
+of the viewport that are sliced exponentially in depth) and finds the positional
+lights whose range overlaps each cluster. The fragment shader looks up the cluster
+containing each fragment and only shades with the lights in that cluster.
+Directional lights and positional lights without attenuation reach everywhere,
+so they are kept in a short list that every fragment uses.
+
+setUniformBlockForShader should be called for every shader program that includes
+the shader storage blocks below.
+
+The setters only change the copy of the lights kept here and widen the range of
+bytes that differ from the buffer. Setting a value a light already has changes
+nothing. uploadLights copies the changed range in a single call and should be
+called once per frame before the scene is rendered.
+
+layout(std430) readonly buffer LightBlock
+{
+	GeneralLight lights[];
+};
+
+layout(std430) readonly buffer ClusterBlock
+{
+	uvec4 clusterGridSize;	// clusters along x, y, and z. w is the number of global lights
+	vec4 clusterTiles;		// xy: viewport origin in pixels, zw: reciprocal of tile size in pixels
+	vec4 clusterDepthRow;	// third row of the viewing matrix
+	vec4 clusterSlices;		// x: slice scale, y: slice bias, z: index of the camera
+	uvec2 clusters[];		// offset into lightIndices and number of lights
+};
 
-	bool inUse = false;
+layout(std430) readonly buffer LightIndexBlock
+{
+	uint lightIndices[];	// global lights followed by the lights of each cluster
 };
 
+The ShadowBlock is filled by the ShadowEngine.
+
+*/
 class SharedLighting
 {
 public:
 
 	friend class LightComponent;
 
+	/**
+	 * @fn	static void SharedLighting::setUniformBlockForShader(GLuint shaderProgram);
+	 *
+	 * @brief	Binds the light, cluster, light index, and shadow storage blocks of a
+	 * 			shader program to their binding points. Creates the buffers the first time
+	 * 			it is called.
+	 *
+	 * @param	shaderProgram	The shader program.
+	 */
 	static void setUniformBlockForShader(GLuint shaderProgram);
 
-	static bool getEnabled(int lightIndex) { return lights[lightIndex].enabled; }
+	/**
+	 * @fn	static void SharedLighting::cullLights(const mat4& viewMatrix, const mat4& projectionMatrix, const glm::ivec4& viewport, int cameraIndex);
+	 *
+	 * @brief	Assigns the enabled lights to the clusters of a camera and uploads
+	 * 			the result. Call after the viewing and projection matrices for a
+	 * 			camera have been set and before anything is rendered with them.
+	 *
+	 * @param	viewMatrix			The viewing transformation of the camera.
+	 * @param	projectionMatrix	The perspective projection of the camera.
+	 * @param	viewport			Lower left corner, width, and height of the viewport in pixels.
+	 * @param	cameraIndex			Position of the camera in the active cameras. Selects the
+	 * 								shadow cascades that were fit to the camera.
+	 */
+	static void cullLights(const mat4& viewMatrix, const mat4& projectionMatrix, const glm::ivec4& viewport, int cameraIndex);
+
+	/**
+	 * @fn	static void SharedLighting::uploadLights();
+	 *
+	 * @brief	Copies the lights that have changed since the last call into the
+	 * 			light buffer with a single upload.
+	 */
+	static void uploadLights();
+
+	/**
+	 * @fn	static int SharedLighting::getNumLights()
+	 *
+	 * @brief	Gets the number of light slots. Includes slots that are not in use.
+	 */
+	static int getNumLights() { return static_cast<int>(lights.size()); }
+
+	/**
+	 * @fn	static int SharedLighting::getNumClusteredLights()
+	 *
+	 * @brief	Gets the number of light to cluster assignments made for the last camera.
+	 */
+	static int getNumClusteredLights() { return static_cast<int>(lightIndices.size()) - numGlobalLights; }
+
+	static bool getEnabled(int lightIndex) { return lights[lightIndex].enabled != 0; }
 	static void setEnabled(int lightIndex, bool on);
 
 	static glm::vec4 getAmbientColor(int lightIndex) { return lights[lightIndex].ambientColor; }
@@ -84,7 +173,7 @@ public:
 	static float getQuadraticAttenuation(int lightIndex) { return lights[lightIndex].quadratic; }
 	static void setQuadraticAttenuation(int lightIndex, float factor);
 
-	static bool getIsSpot(int lightIndex) { return lights[lightIndex].isSpot; }
+	static bool getIsSpot(int lightIndex) { return lights[lightIndex].isSpot != 0; }
 	static void setIsSpot(int lightIndex, bool spotOn);
 
 	static glm::vec3 getSpotDirection(int lightIndex) { return lights[lightIndex].spotDirection; }
@@ -96,17 +185,118 @@ public:
 	static float getSpotExponent(int lightIndex) { return lights[lightIndex].spotExponent; }
 	static void setSpotExponent(int lightIndex, float spotEx);
 
-protected:
-
-	static std::vector<std::string> buildUniformBlockNameList();
+	static int getShadowIndex(int lightIndex) { return lights[lightIndex].shadowIndex; }
+	static void setShadowIndex(int lightIndex, int shadowIndex);
 
-	static void initilizeAttributes(GLint lightNumber);
+	static int getShadowCascades(int lightIndex) { return lights[lightIndex].shadowCascades; }
+	static void setShadowCascades(int lightIndex, int numCascades);
 
-	static GeneralLight lights[MAX_LIGHTS];
+	/**
+	 * @fn	static float SharedLighting::getRange(int lightIndex)
+	 *
+	 * @brief	Gets the distance beyond which a positional light no longer
+	 * 			visibly lights anything. Infinite if it does not fade with distance.
+	 */
+	static float getRange(int lightIndex) { return getLightRange(lights[lightIndex]); }
 
-	static SharedUniformBlock lightBlock;
+protected:
 
-	const static std::string generalLightBlockName;
+	/**
+	 * @struct	ClusterHeader
+	 *
+	 * @brief	Mirror of the members at the start of the ClusterBlock.
+	 */
+	struct ClusterHeader
+	{
+		glm::uvec4 gridSize;
+		vec4 tiles;
+		vec4 depthRow;
+		vec4 slices;
+	};
+
+	/**
+	 * @fn	static int SharedLighting::allocateLight();
+	 *
+	 * @brief	Finds a light slot that is not in use or adds a new one.
+	 *
+	 * @returns	The index of the light.
+	 */
+	static int allocateLight();
+
+	/**
+	 * @fn	static void SharedLighting::releaseLight(int lightIndex);
+	 *
+	 * @brief	Restores the default attributes of a light and makes it available for reuse.
+	 */
+	static void releaseLight(int lightIndex);
+
+	/**
+	 * @fn	static float SharedLighting::getLightRange(const GeneralLight& light);
+	 *
+	 * @brief	Finds the distance beyond which a positional light is too dim to
+	 * 			change the color of a fragment.
+	 *
+	 * @returns	The range. Infinite if the light does not fade with distance.
+	 */
+	static float getLightRange(const GeneralLight& light);
+
+	/**
+	 * @fn	template <typename T> static void SharedLighting::setLightMember(int lightIndex, T GeneralLight::* member, const T& value);
+	 *
+	 * @brief	Changes one member of a light and marks its bytes as needing to
+	 * 			be uploaded. Does nothing if the member already has the value.
+	 *
+	 * @param	lightIndex	Index of the light.
+	 * @param	member	  	The member.
+	 * @param	value	  	The new value.
+	 */
+	template <typename T>
+	static void setLightMember(int lightIndex, T GeneralLight::* member, const T& value);
+
+	/**
+	 * @fn	static void SharedLighting::markDirty(size_t begin, size_t end);
+	 *
+	 * @brief	Widens the range of bytes of the light buffer that need to be uploaded.
+	 */
+	static void markDirty(size_t begin, size_t end);
+
+	/**
+	 * @fn	static void SharedLighting::uploadBuffer(GLuint buffer, GLsizeiptr& capacity, GLuint bindingPoint, const void* data, GLsizeiptr size);
+	 *
+	 * @brief	Copies data into a shader storage buffer, growing the buffer first if it is too small.
+	 */
+	static void uploadBuffer(GLuint buffer, GLsizeiptr& capacity, GLuint bindingPoint, const void* data, GLsizeiptr size);
+
+	static std::vector<GeneralLight> lights;
+
+	static std::vector<bool> lightsInUse;
+
+	/** @brief	Range of bytes of the light buffer that differ from the lights. Empty when begin is not less than end. */
+	static size_t dirtyBegin;
+	static size_t dirtyEnd;
+
+	/** @brief	Identifiers and allocated sizes in bytes of the shader storage buffers. */
+	static GLuint lightBuffer;
+	static GLsizeiptr lightBufferCapacity;
+	static GLuint clusterBuffer;
+	static GLsizeiptr clusterBufferCapacity;
+	static GLuint lightIndexBuffer;
+	static GLsizeiptr lightIndexBufferCapacity;
+
+	/** @brief	View space bounding boxes of the clusters of the last camera. */
+	static std::vector<vec3> clusterMin;
+	static std::vector<vec3> clusterMax;
+
+	/** @brief	Header and offset and count of each cluster followed by the light indices. */
+	static std::vector<glm::uvec2> clusterData;
+	static std::vector<GLuint> lightIndices;
+	static int numGlobalLights;
+
+	/** @brief	Cluster and light of each assignment made while culling. */
+	static std::vector<glm::uvec2> assignments;
+
+	const static std::string lightBlockName;
+	const static std::string clusterBlockName;
+	const static std::string lightIndexBlockName;
+	const static std::string shadowBlockName;
 };
-
-
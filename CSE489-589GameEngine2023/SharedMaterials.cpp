@@ -107,3 +107,25 @@ void SharedMaterials::cleanUpMaterial(const Material & material)
 		glDisable(GL_BLEND);
 	}
 }
+
+
+unsigned int SharedMaterials::getShaderFeatures(const Material & material)
+{
+	unsigned int features = static_cast<unsigned int>(material.textureMode) << SHADER_TEXTURE_MODE_SHIFT;
+
+	if (material.diffuseTextureEnabled == true) {
+
+		features |= SHADER_DIFFUSE_TEXTURE_BIT;
+	}
+	if (material.specularTextureEnabled == true) {
+
+		features |= SHADER_SPECULAR_TEXTURE_BIT;
+	}
+	if (material.normalMapTextureEnabled == true) {
+
+		features |= SHADER_NORMAL_MAP_BIT;
+	}
+
+	return features;
+
+} // end getShaderFeatures
@@ -4,6 +4,7 @@
 #include "SharedUniformBlock.h"
 
 #include "Material.h"
+#include "BuildShaderProgram.h"
 
 #define materialBlockBindingPoint 12
 #define diffuseSamplerLocation 100
@@ -27,6 +28,10 @@ public:
 	// Cleans Material*properties after rendering an object.
 	static void cleanUpMaterial(const Material & material);
 
+	// Gets the shader variant features that the Material*uses. Combine
+	// with the fog features and pass to getShaderVariant.
+	static unsigned int getShaderFeatures(const Material & material);
+
 protected:
 
 	static GLuint ambientMatLocation; // Byte offset ambient material color
@@ -0,0 +1,236 @@
+#include "SoundBackend.h"
+
+#include <chrono>
+
+#define VERBOSE false
+
+// ALC_SOFT_loopback. Declared here because not every OpenAL SDK has alext.h.
+#ifndef ALC_SOFT_loopback
+#define ALC_FORMAT_CHANNELS_SOFT 0x1990
+#define ALC_FORMAT_TYPE_SOFT 0x1991
+#define ALC_STEREO_SOFT 0x1501
+#define ALC_SHORT_SOFT 0x1402
+#endif
+
+typedef ALCdevice* (ALC_APIENTRY* LoopbackOpenDeviceFunction)(const ALCchar* deviceName);
+typedef void (ALC_APIENTRY* RenderSamplesFunction)(ALCdevice* device, ALCvoid* buffer, ALCsizei samples);
+
+static RenderSamplesFunction alcRenderSamplesSOFT = nullptr;
+
+// ********** Helper Functions ************************
+
+// Writes a little endian unsigned integer of numBytes bytes
+static void writeLittleEndian(std::ofstream& file, unsigned int value, int numBytes)
+{
+	for (int i = 0; i < numBytes; i++) {
+
+		file.put(static_cast<char>(value & 0xFF));
+		value >>= 8;
+	}
+
+} // end writeLittleEndian
+
+
+bool DeviceSoundBackend::open()
+{
+	alutInit(0, 0);
+
+	return SoundEngine::check_alut_errors();
+
+} // end open
+
+
+void DeviceSoundBackend::close()
+{
+	alutExit();
+	SoundEngine::check_alut_errors();
+
+} // end close
+
+
+bool NullSoundBackend::open()
+{
+	if (!alcIsExtensionPresent(NULL, "ALC_SOFT_loopback")) {
+
+		std::cerr << "ALC_SOFT_loopback is not supported. OpenAL Soft is required to run without a device." << std::endl;
+		return false;
+	}
+
+	auto alcLoopbackOpenDeviceSOFT = reinterpret_cast<LoopbackOpenDeviceFunction>(
+		alcGetProcAddress(NULL, "alcLoopbackOpenDeviceSOFT"));
+	alcRenderSamplesSOFT = reinterpret_cast<RenderSamplesFunction>(alcGetProcAddress(NULL, "alcRenderSamplesSOFT"));
+
+	device = alcLoopbackOpenDeviceSOFT(NULL);
+
+	if (device == nullptr) {
+
+		std::cerr << "Unable to open an OpenAL loopback device." << std::endl;
+		return false;
+	}
+
+	// The format of the samples returned by alcRenderSamplesSOFT
+	ALCint attributes[] = {
+		ALC_FORMAT_CHANNELS_SOFT, ALC_STEREO_SOFT,
+		ALC_FORMAT_TYPE_SOFT, ALC_SHORT_SOFT,
+		ALC_FREQUENCY, frequency,
+		0
+	};
+
+	context = alcCreateContext(device, attributes);
+
+	if (context == nullptr || !alcMakeContextCurrent(context)) {
+
+		std::cerr << "Unable to create an OpenAL loopback context." << std::endl;
+
+		if (context != nullptr) {
+			alcDestroyContext(context);
+			context = nullptr;
+		}
+		alcCloseDevice(device);
+		device = nullptr;
+
+		return false;
+	}
+
+	// ALUT is still used to load sound files
+	alutInitWithoutContext(0, 0);
+
+	if (VERBOSE) cout << "Loopback device opened at " << frequency << " Hz" << endl;
+
+	return SoundEngine::check_alut_errors();
+
+} // end open
+
+
+void NullSoundBackend::close()
+{
+	if (context != nullptr) {
+
+		alutExit();
+
+		alcMakeContextCurrent(NULL);
+		alcDestroyContext(context);
+		context = nullptr;
+	}
+
+	if (device != nullptr) {
+
+		alcCloseDevice(device);
+		device = nullptr;
+	}
+
+} // end close
+
+
+void NullSoundBackend::render(float deltaTime)
+{
+	// Sources only advance when the loopback device mixes
+	renderFrame(deltaTime);
+
+} // end render
+
+
+int NullSoundBackend::renderFrame(float deltaTime)
+{
+	// Exactly the samples covered by the frame. The fraction left over is
+	// carried so that no time is lost between frames.
+	carriedSamples += static_cast<double>(deltaTime) * frequency;
+
+	int numSamples = static_cast<int>(carriedSamples);
+	carriedSamples -= numSamples;
+
+	if (numSamples > 0) {
+		renderSamples(numSamples);
+	}
+
+	return numSamples;
+
+} // end renderFrame
+
+
+void NullSoundBackend::renderSamples(int numSamples)
+{
+	samples.resize(2 * static_cast<size_t>(numSamples));
+
+	auto start = std::chrono::steady_clock::now();
+
+	alcRenderSamplesSOFT(device, samples.data(), numSamples);
+
+	renderMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - start).count();
+	renderedSamples += numSamples;
+
+} // end renderSamples
+
+
+bool OfflineSoundBackend::open()
+{
+	if (!NullSoundBackend::open()) {
+		return false;
+	}
+
+	if (fileName.size() > 0) {
+
+		file.open(fileName, std::ios::binary);
+
+		if (!file) {
+
+			std::cerr << "Unable to open " << fileName << " for writing." << std::endl;
+			NullSoundBackend::close();
+			return false;
+		}
+
+		// RIFF header of a stereo 16 bit PCM file. The sizes are filled in by close.
+		file.write("RIFF", 4);
+		writeLittleEndian(file, 0, 4);
+		file.write("WAVE", 4);
+
+		file.write("fmt ", 4);
+		writeLittleEndian(file, 16, 4);
+		writeLittleEndian(file, 1, 2);
+		writeLittleEndian(file, 2, 2);
+		writeLittleEndian(file, frequency, 4);
+		writeLittleEndian(file, frequency * 4, 4);
+		writeLittleEndian(file, 4, 2);
+		writeLittleEndian(file, 16, 2);
+
+		file.write("data", 4);
+		writeLittleEndian(file, 0, 4);
+	}
+
+	return true;
+
+} // end open
+
+
+void OfflineSoundBackend::close()
+{
+	if (file.is_open()) {
+
+		file.seekp(4);
+		writeLittleEndian(file, 36 + dataSize, 4);
+		file.seekp(40);
+		writeLittleEndian(file, dataSize, 4);
+
+		file.close();
+	}
+
+	NullSoundBackend::close();
+
+} // end close
+
+
+void OfflineSoundBackend::render(float deltaTime)
+{
+	if (renderFrame(deltaTime) <= 0) {
+		return;
+	}
+
+	if (file.is_open()) {
+
+		// Samples are in native byte order which is little endian on every supported platform
+		file.write(reinterpret_cast<const char*>(samples.data()), samples.size() * sizeof(short));
+		dataSize += static_cast<unsigned int>(samples.size() * sizeof(short));
+	}
+
+} // end render
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <string>
+#include <fstream>
+#include <vector>
+#include <atomic>
+
+#include "SoundEngine.h"
+
+/**
+ * @class	SoundBackend
+ *
+ * @brief	Creates and destroys the OpenAL device and context used by the
+ * 			sound engine. Pass one to SoundEngine::Init to run without audio
+ * 			hardware. The engine takes ownership of the backend.
+ */
+class SoundBackend
+{
+public:
+
+	virtual ~SoundBackend() {}
+
+	/**
+	 * @fn	virtual bool SoundBackend::open() = 0;
+	 *
+	 * @brief	Opens the device, makes a context current, and initializes ALUT.
+	 *
+	 * @returns	True if it succeeds, false if it fails.
+	 */
+	virtual bool open() = 0;
+
+	/**
+	 * @fn	virtual void SoundBackend::close() = 0;
+	 *
+	 * @brief	Shuts down ALUT and destroys the context and the device.
+	 */
+	virtual void close() = 0;
+
+	/**
+	 * @fn	virtual void SoundBackend::render(float deltaTime)
+	 *
+	 * @brief	Called by the audio thread once each frame after the sounds have been
+	 * 			updated. Backends without their own mixing thread mix the samples
+	 * 			for the frame here.
+	 *
+	 * @param	deltaTime	The delta time.
+	 */
+	virtual void render(float deltaTime) {}
+
+	/**
+	 * @fn	double SoundBackend::getRenderTime() const
+	 *
+	 * @brief	Gets the total time spent mixing in render. Safe to call from the game thread.
+	 *
+	 * @returns	The render time in seconds.
+	 */
+	double getRenderTime() const { return renderMicroseconds / 1000000.0; }
+
+	/**
+	 * @fn	long long SoundBackend::getRenderedSamples() const
+	 *
+	 * @brief	Gets the number of sample frames mixed in render. Safe to call from the game thread.
+	 *
+	 * @returns	The number of sample frames.
+	 */
+	long long getRenderedSamples() const { return renderedSamples; }
+
+protected:
+
+	SoundBackend() : renderMicroseconds(0), renderedSamples(0) {}
+
+	/** @brief	Totals updated by render. */
+	std::atomic<long long> renderMicroseconds;
+	std::atomic<long long> renderedSamples;
+
+}; // end SoundBackend class
+
+
+/**
+ * @class	DeviceSoundBackend
+ *
+ * @brief	Plays through the default audio device. Used when no backend is
+ * 			passed to SoundEngine::Init.
+ */
+class DeviceSoundBackend : public SoundBackend
+{
+public:
+
+	virtual bool open() override;
+
+	virtual void close() override;
+
+}; // end DeviceSoundBackend class
+
+
+/**
+ * @class	NullSoundBackend
+ *
+ * @brief	A null device. Uses an OpenAL Soft loopback device
+ * 			(ALC_SOFT_loopback), which only mixes when asked to and needs no
+ * 			audio hardware. Each frame the samples covered by the frame's delta
+ * 			time are mixed and thrown away, so sounds advance, end, and stream
+ * 			as they would on a device while the scene stays silent. Use it for
+ * 			headless runs.
+ */
+class NullSoundBackend : public SoundBackend
+{
+public:
+
+	/**
+	 * @fn	NullSoundBackend::NullSoundBackend(int frequency = 44100);
+	 *
+	 * @brief	Constructor
+	 *
+	 * @param	frequency	(Optional) The mixing frequency.
+	 */
+	NullSoundBackend(int frequency = 44100) : frequency(frequency) {}
+
+	virtual bool open() override;
+
+	virtual void close() override;
+
+	virtual void render(float deltaTime) override;
+
+protected:
+
+	/**
+	 * @fn	int NullSoundBackend::renderFrame(float deltaTime);
+	 *
+	 * @brief	Mixes exactly as many samples as the delta time covers into the
+	 * 			samples vector. The fraction left over is carried to the next frame.
+	 *
+	 * @param	deltaTime	The delta time.
+	 *
+	 * @returns	The number of sample frames mixed.
+	 */
+	int renderFrame(float deltaTime);
+
+	/**
+	 * @fn	void NullSoundBackend::renderSamples(int numSamples);
+	 *
+	 * @brief	Mixes stereo 16 bit samples into the samples vector.
+	 *
+	 * @param	numSamples	Number of sample frames.
+	 */
+	void renderSamples(int numSamples);
+
+	int frequency;
+
+	ALCdevice* device = nullptr;
+	ALCcontext* context = nullptr;
+
+	/** @brief	Mixed samples. Two per sample frame. */
+	std::vector<short> samples;
+
+	/** @brief	Part of a sample frame carried over to the next render. */
+	double carriedSamples = 0.0;
+
+}; // end NullSoundBackend class
+
+
+/**
+ * @class	OfflineSoundBackend
+ *
+ * @brief	Mixes exactly as many samples as the frame's delta time covers
+ * 			and writes them to a wave file. With a fixed delta time the output
+ * 			is deterministic, and the render time measures the cost of mixing
+ * 			the scene.
+ */
+class OfflineSoundBackend : public NullSoundBackend
+{
+public:
+
+	/**
+	 * @fn	OfflineSoundBackend::OfflineSoundBackend(const std::string& fileName, int frequency = 44100);
+	 *
+	 * @brief	Constructor
+	 *
+	 * @param	fileName 	Wave file the mix is written to. Empty to discard the mix.
+	 * @param	frequency	(Optional) The mixing frequency.
+	 */
+	OfflineSoundBackend(const std::string& fileName, int frequency = 44100)
+		: NullSoundBackend(frequency), fileName(fileName) {}
+
+	virtual bool open() override;
+
+	virtual void close() override;
+
+	virtual void render(float deltaTime) override;
+
+protected:
+
+	std::string fileName;
+	std::ofstream file;
+
+	/** @brief	Bytes of samples written to the file. */
+	unsigned int dataSize = 0;
+
+}; // end OfflineSoundBackend class
@@ -21,14 +21,26 @@ void SoundBaseComponent::initialize()
 void SoundBaseComponent::update(const float& deltaTime)
 {
 	// Get current position and the forward and up directions
-	soundPosition = this->owningGameObject->getPosition( WORLD );
-	soundForward = this->owningGameObject->getFowardDirection( WORLD );
-	soundUp = this->owningGameObject->getUpDirection( WORLD );
+	vec3 position = this->owningGameObject->getPosition( WORLD );
+	vec3 forward = this->owningGameObject->getFowardDirection( WORLD );
+	vec3 up = this->owningGameObject->getUpDirection( WORLD );
 
 	// Calculate the velocity 
+	vec3 velocity = soundVelocity;
 	if( deltaTime > 0.0f ) {
 
-		soundVelocity = (soundPosition - lastPosition) / deltaTime;
+		velocity = (position - lastPosition) / deltaTime;
+	}
+
+	// Nothing is sent to OpenAL for sounds and listeners that have not moved
+	if (position != soundPosition || velocity != soundVelocity ||
+		forward != soundForward || up != soundUp) {
+
+		soundPosition = position;
+		soundVelocity = velocity;
+		soundForward = forward;
+		soundUp = up;
+		transformDirty = true;
 	}
 
 	// Save position for next update
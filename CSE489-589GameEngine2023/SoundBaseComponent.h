@@ -26,6 +26,7 @@ class SoundBaseComponent : public Component
 	 *
 	 * @brief	Performs update calculations are are common to all SoundBase sub-classes i.e. the
 	 * 			data members of this class based on the world transformation of the SceneNode.
+	 * 			Sets transformDirty if any of them changed.
 	 *
 	 * @param	deltaTime	The delta time.
 	 */
@@ -40,5 +41,8 @@ class SoundBaseComponent : public Component
 
 	vec3 lastPosition = ZERO_V3;
 
+	/** @brief	True if the values above have changed since they were last passed to OpenAL. */
+	bool transformDirty = true;
+
 };
 
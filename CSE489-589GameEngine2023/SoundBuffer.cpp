@@ -0,0 +1,138 @@
+#include "SoundBuffer.h"
+
+#define VERBOSE false
+
+std::unordered_map<std::string, SoundBuffer*> SoundBuffer::loadedBuffers;
+
+std::mutex SoundBuffer::cacheMutex;
+
+SoundBuffer* SoundBuffer::GetSoundBuffer(const std::string& fileName)
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+
+	// Pointer to the buffer to be loaded or retrieved.
+	SoundBuffer* soundBufferPtr = nullptr;
+
+	// Search for the buffer among those that were previously loaded
+	auto iter = loadedBuffers.find(fileName);
+
+	// Check if the buffer was previously loaded
+	if (iter != loadedBuffers.end()) {
+
+		if (VERBOSE) std::cout << "Retrieving sound buffer: " << fileName << std::endl;
+		soundBufferPtr = iter->second;
+	}
+	else {
+
+		if (VERBOSE) std::cout << "Loading sound buffer: " << fileName << std::endl;
+
+		// Load the sound file into a buffer.
+		ALuint bufferID = alutCreateBufferFromFile(fileName.c_str());
+
+		if (SoundEngine::check_alut_errors() && bufferID != AL_NONE) {
+
+			soundBufferPtr = new SoundBuffer();
+			soundBufferPtr->bufferID = bufferID;
+			soundBufferPtr->fileName = fileName;
+
+			// Used to track the playback position of sources that are not heard
+			ALint size, channels, bits, frequency;
+			alGetBufferi(bufferID, AL_SIZE, &size);
+			alGetBufferi(bufferID, AL_CHANNELS, &channels);
+			alGetBufferi(bufferID, AL_BITS, &bits);
+			alGetBufferi(bufferID, AL_FREQUENCY, &frequency);
+
+			if (channels > 0 && bits > 0 && frequency > 0) {
+				soundBufferPtr->duration = static_cast<float>(size / (channels * bits / 8)) / frequency;
+			}
+
+			// Add the loaded buffer to those that were previously loaded
+			loadedBuffers.emplace(fileName, soundBufferPtr);
+		}
+		else {
+
+			std::cerr << "Unable to load sound file " << fileName << std::endl;
+		}
+	}
+
+	if (soundBufferPtr != nullptr) {
+		soundBufferPtr->referenceCount++;
+	}
+
+	return soundBufferPtr;
+
+} // end GetSoundBuffer
+
+
+void SoundBuffer::ReleaseSoundBuffer(SoundBuffer* soundBuffer)
+{
+	if (soundBuffer == nullptr) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(cacheMutex);
+
+	soundBuffer->referenceCount--;
+
+	if (soundBuffer->referenceCount == 0) {
+
+		if (VERBOSE) std::cout << "Unloading sound buffer: " << soundBuffer->fileName << std::endl;
+
+		// The buffer may already have been deleted when the sound engine stopped
+		if (soundBuffer->bufferID != 0) {
+
+			alDeleteBuffers(1, &soundBuffer->bufferID);
+			loadedBuffers.erase(soundBuffer->fileName);
+		}
+
+		delete soundBuffer;
+	}
+
+} // end ReleaseSoundBuffer
+
+
+bool SoundBuffer::Preload(const std::string& fileName)
+{
+	SoundBuffer* soundBufferPtr = GetSoundBuffer(fileName);
+
+	if (soundBufferPtr == nullptr) {
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(cacheMutex);
+
+	// Only one reference is held for preloading no matter how many times it is requested
+	if (soundBufferPtr->preloaded) {
+		soundBufferPtr->referenceCount--;
+	}
+	soundBufferPtr->preloaded = true;
+
+	return true;
+
+} // end Preload
+
+
+void SoundBuffer::unloadSoundBuffers()
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+
+	for (auto i : loadedBuffers) {
+
+		alDeleteBuffers(1, &i.second->bufferID);
+		i.second->bufferID = 0;
+
+		// Drop the preload reference. Buffers still in use by sources are deleted
+		// when their last reference is released.
+		if (i.second->preloaded) {
+
+			i.second->referenceCount--;
+			i.second->preloaded = false;
+		}
+
+		if (i.second->referenceCount == 0) {
+			delete i.second;
+		}
+	}
+	loadedBuffers.clear();
+
+} // end unloadSoundBuffers
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <unordered_map>
+#include <string>
+#include <mutex>
+
+#include "SoundEngine.h"
+
+/**
+ * @class	SoundBuffer
+ *
+ * @brief	An OpenAL buffer holding the samples of a sound file. Buffers are
+ * 			cached by file name and reference counted so that every source
+ * 			playing the same file shares one buffer and the file is only read
+ * 			and decoded once.
+ */
+class SoundBuffer
+{
+public:
+
+	/**
+	 * @fn	static SoundBuffer* SoundBuffer::GetSoundBuffer(const std::string& fileName);
+	 *
+	 * @brief	Loads a sound file or retrieves it if it was loaded previously. Each
+	 * 			call adds a reference that must be released with ReleaseSoundBuffer.
+	 *
+	 * @param	fileName	Contains the relative path and the name of the file.
+	 *
+	 * @returns	Null if it fails, else a pointer to the buffer.
+	 */
+	static SoundBuffer* GetSoundBuffer(const std::string& fileName);
+
+	/**
+	 * @fn	static void SoundBuffer::ReleaseSoundBuffer(SoundBuffer* soundBuffer);
+	 *
+	 * @brief	Releases a reference to a buffer. The buffer is deleted when the last
+	 * 			reference is released unless it was preloaded.
+	 *
+	 * @param [in]	soundBuffer	The buffer. May be null.
+	 */
+	static void ReleaseSoundBuffer(SoundBuffer* soundBuffer);
+
+	/**
+	 * @fn	static bool SoundBuffer::Preload(const std::string& fileName);
+	 *
+	 * @brief	Loads a sound file ahead of time so that creating sources that play it
+	 * 			does not read the disk. Preloaded buffers stay loaded until
+	 * 			unloadSoundBuffers is called.
+	 *
+	 * @param	fileName	Contains the relative path and the name of the file.
+	 *
+	 * @returns	True if the file was loaded.
+	 */
+	static bool Preload(const std::string& fileName);
+
+	/**
+	 * @fn	static void SoundBuffer::unloadSoundBuffers();
+	 *
+	 * @brief	Deletes the OpenAL buffers of ALL sound buffers. Called when the sound
+	 * 			engine stops.
+	 */
+	static void unloadSoundBuffers();
+
+	/**
+	 * @fn	ALuint SoundBuffer::getBufferObject() const
+	 *
+	 * @brief	Gets the identifier of the OpenAL buffer.
+	 *
+	 * @returns	The buffer object.
+	 */
+	ALuint getBufferObject() const { return bufferID; }
+
+	/**
+	 * @fn	const std::string& SoundBuffer::getFileName() const
+	 *
+	 * @brief	Gets the name of the file the buffer was loaded from.
+	 *
+	 * @returns	The file name.
+	 */
+	const std::string& getFileName() const { return fileName; }
+
+	/**
+	 * @fn	float SoundBuffer::getDuration() const
+	 *
+	 * @brief	Gets the length of the sound.
+	 *
+	 * @returns	The duration in seconds.
+	 */
+	float getDuration() const { return duration; }
+
+protected:
+
+	/**
+	 * @fn	SoundBuffer::SoundBuffer()
+	 *
+	 * @brief	Default constructor. Protected so that is not possible to create
+	 * 			SoundBuffer objects without them being added to the cache.
+	 */
+	SoundBuffer() {}
+
+	/** @brief	Identifier of the OpenAL buffer. Zero once unloaded. */
+	ALuint bufferID = 0;
+
+	/** @brief	Length of the sound in seconds. */
+	float duration = 0.0f;
+
+	/** @brief	Number of sources using the buffer. A preload counts as one reference. */
+	int referenceCount = 0;
+
+	/** @brief	True if the buffer holds a reference for Preload. */
+	bool preloaded = false;
+
+	/** @brief	Name of the file the buffer was loaded from. */
+	std::string fileName;
+
+	/** @brief	All of the buffers that are currently loaded. */
+	static std::unordered_map<std::string, SoundBuffer*> loadedBuffers;
+
+	/** @brief	Guards the cache and the reference counts. Sounds are loaded on the
+	 * 			audio thread but may be preloaded by the game.
+	 */
+	static std::mutex cacheMutex;
+
+}; // end SoundBuffer class
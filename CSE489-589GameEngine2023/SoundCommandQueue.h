@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+
+#include "MathLibsConstsFuncs.h"
+
+using namespace constants_and_types;
+
+class SoundInstance;
+
+/**
+ * @enum	SOUND_COMMAND_TYPE
+ *
+ * @brief	Requests passed from the game to the audio thread.
+ */
+enum SOUND_COMMAND_TYPE {
+	CREATE_SOUND, DESTROY_SOUND, PLAY_SOUND, STOP_SOUND, PAUSE_SOUND, CONTINUE_SOUND,
+	SET_SOUND_GAIN, SET_SOUND_LOOPING, SET_SOUND_REFERENCE_DISTANCE, SET_SOUND_ROLL_OFF_FACTOR,
+	SET_SOUND_MAX_DISTANCE, SET_SOUND_PRIORITY, SET_SOUND_TRANSFORM, SET_LISTENER_TRANSFORM,
+	UPDATE_SOUND_FRAME
+};
+
+/**
+ * @struct	SoundCommand
+ *
+ * @brief	A single request for the audio thread. Only the fields used by
+ * 			the type of command are set.
+ */
+struct SoundCommand
+{
+	SOUND_COMMAND_TYPE type = UPDATE_SOUND_FRAME;
+
+	/** @brief	The sound the command applies to. Null for listener and frame commands. */
+	SoundInstance* instance = nullptr;
+
+	/** @brief	Gain, distance, roll off factor, or delta time. */
+	float value = 0.0f;
+
+	/** @brief	Play identifier, priority, or looping flag. */
+	int intValue = 0;
+
+	/** @brief	World position, velocity, and orientation. */
+	vec3 position;
+	vec3 velocity;
+	vec3 forward;
+	vec3 up;
+};
+
+/**
+ * @class	SoundCommandQueue
+ *
+ * @brief	Fixed size lock-free ring of commands with a single producer
+ * 			(the game thread) and a single consumer (the audio thread).
+ * 			Neither side ever waits for the other unless the ring is full.
+ */
+class SoundCommandQueue
+{
+public:
+
+	/** @brief	Number of commands the ring holds. Must be a power of two. */
+	static const unsigned int CAPACITY = 8192;
+
+	SoundCommandQueue() : head(0), tail(0) {}
+
+	/**
+	 * @fn	bool SoundCommandQueue::push(const SoundCommand& command)
+	 *
+	 * @brief	Adds a command to the back of the queue. Only called by the producer.
+	 *
+	 * @param	command	The command.
+	 *
+	 * @returns	False if the queue is full.
+	 */
+	bool push(const SoundCommand& command)
+	{
+		unsigned int back = tail.load(std::memory_order_relaxed);
+
+		if (back - head.load(std::memory_order_acquire) == CAPACITY) {
+			return false;
+		}
+
+		slots[back & (CAPACITY - 1)] = command;
+
+		// Publishes the command to the consumer
+		tail.store(back + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	/**
+	 * @fn	bool SoundCommandQueue::pop(SoundCommand& command)
+	 *
+	 * @brief	Removes the command at the front of the queue. Only called by the consumer.
+	 *
+	 * @param [out]	command	The command.
+	 *
+	 * @returns	False if the queue is empty.
+	 */
+	bool pop(SoundCommand& command)
+	{
+		unsigned int front = head.load(std::memory_order_relaxed);
+
+		if (front == tail.load(std::memory_order_acquire)) {
+			return false;
+		}
+
+		command = slots[front & (CAPACITY - 1)];
+
+		// Hands the slot back to the producer
+		head.store(front + 1, std::memory_order_release);
+
+		return true;
+	}
+
+protected:
+
+	SoundCommand slots[CAPACITY];
+
+	/** @brief	Index of the next command to pop. Written only by the consumer. */
+	alignas(64) std::atomic<unsigned int> head;
+
+	/** @brief	Index of the next slot to push. Written only by the producer. */
+	alignas(64) std::atomic<unsigned int> tail;
+
+}; // end SoundCommandQueue class
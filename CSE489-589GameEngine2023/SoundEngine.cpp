@@ -1,4 +1,11 @@
 #include "SoundEngine.h"
+#include "SoundBuffer.h"
+#include "SoundStream.h"
+#include "SoundInstance.h"
+#include "SoundBackend.h"
+
+#include <algorithm>
+#include <chrono>
 
 //https://indiegamedev.net/2020/02/15/the-complete-guide-to-openal-with-c-part-1-playing-a-sound/
 
@@ -8,20 +15,85 @@
 #define VERBOSE false
 
 // ********** Static data members ************************
+std::vector<ALuint> SoundEngine::voices;
+
+std::vector<ALuint> SoundEngine::freeVoices;
+
+std::vector<SoundInstance*> SoundEngine::soundInstances;
+
+vec3 SoundEngine::listenerPosition = ZERO_V3;
+
+vec3 SoundEngine::listenerVelocity = ZERO_V3;
+
+vec3 SoundEngine::listenerForward = vec3(0.0f, 0.0f, -1.0f);
+
+vec3 SoundEngine::listenerUp = vec3(0.0f, 1.0f, 0.0f);
+
+bool SoundEngine::listenerDirty = false;
+
+ALint SoundEngine::distanceModel = AL_INVERSE_DISTANCE;
+
+SoundBackend* SoundEngine::backend = nullptr;
+
+SoundCommandQueue SoundEngine::commands;
+
+std::thread SoundEngine::audioThread;
+
+std::mutex SoundEngine::wakeMutex;
+
+std::condition_variable SoundEngine::wakeUp;
+
+std::atomic<bool> SoundEngine::quitAudio(false);
+
+// Sounds quieter than this at the listener are not given a voice (-60 dB)
+static const float INAUDIBLE_GAIN = 0.001f;
+
 //ALCdevice* SoundEngine::device;
 
 //ALCcontext* SoundEngine::context;
 
+// Entry points of the AL_SOFT_deferred_updates extension. Null if it is not supported.
+typedef void (AL_APIENTRY* DeferUpdatesFunction)(void);
+
+static DeferUpdatesFunction alDeferUpdatesSOFT = nullptr;
+
+static DeferUpdatesFunction alProcessUpdatesSOFT = nullptr;
+
 // ********** Helper Functions ************************
 static void list_audio_devices(const ALCchar* devices);
 static bool check_alc_errors(ALCdevice* device);
 
-bool SoundEngine::Init(ALint distanceModel, ALfloat dopplerFactor)
+bool SoundEngine::Init(ALint distanceModel, ALfloat dopplerFactor, int maxVoices, SoundBackend* backend)
 {
 	if (VERBOSE) cout << "Init called" << endl;
 
-	alutInit(0, 0);
-	check_alut_errors();
+	if (backend == nullptr) {
+
+		backend = new DeviceSoundBackend();
+
+		// Scenes still run on machines without a usable audio device
+		if (!backend->open()) {
+
+			std::cerr << "Warning: unable to open the audio device. Sounds will not be heard." << endl;
+
+			delete backend;
+			backend = new NullSoundBackend();
+
+			if (!backend->open()) {
+
+				// Without OpenAL Soft there is nothing to play sounds on. Commands are dropped.
+				delete backend;
+				return true;
+			}
+		}
+	}
+	else if (!backend->open()) {
+
+		delete backend;
+		return false;
+	}
+
+	SoundEngine::backend = backend;
 
 	//device = alcOpenDevice(NULL);
 
@@ -90,9 +162,39 @@ bool SoundEngine::Init(ALint distanceModel, ALfloat dopplerFactor)
 	alDistanceModel( distanceModel );
 	check_al_errors();
 
+	SoundEngine::distanceModel = distanceModel;
+
 	alDopplerFactor( dopplerFactor );
 	check_al_errors();
 
+	if (alIsExtensionPresent("AL_SOFT_deferred_updates")) {
+
+		alDeferUpdatesSOFT = reinterpret_cast<DeferUpdatesFunction>(alGetProcAddress("alDeferUpdatesSOFT"));
+		alProcessUpdatesSOFT = reinterpret_cast<DeferUpdatesFunction>(alGetProcAddress("alProcessUpdatesSOFT"));
+	}
+
+	if (VERBOSE) cout << "deferred updates " << (alDeferUpdatesSOFT != nullptr ? "supported" : "not supported") << endl;
+
+	// Create the voices one at a time. Implementations limit the number of sources.
+	alGetError();
+	for (int i = 0; i < maxVoices; i++) {
+
+		ALuint source;
+		alGenSources(1, &source);
+
+		if (alGetError() != AL_NO_ERROR) {
+			break;
+		}
+		voices.push_back(source);
+	}
+	freeVoices = voices;
+
+	if (VERBOSE) cout << voices.size() << " voices created" << endl;
+
+	// From here on OpenAL is only used by the audio thread
+	quitAudio = false;
+	audioThread = std::thread(&SoundEngine::AudioLoop);
+
 	return true;
 
 } // end SoundEngineInit
@@ -103,16 +205,419 @@ void SoundEngine::Update(const float & deltaTime)
 	// Not necessary with OpenAL Other sound APIs require and update to 
 	// take into account the changes in the positions of sound sources
 	// and the listeners.
+
+	// The audio thread updates the sounds once it has applied the
+	// commands that were sent during the frame.
+	SoundCommand command;
+	command.type = UPDATE_SOUND_FRAME;
+	command.value = deltaTime;
+
+	PostCommand(command);
+
+	wakeUp.notify_one();
 }
 
+
+void SoundEngine::PostCommand(const SoundCommand& command)
+{
+	if (!audioThread.joinable()) {
+
+		// Not running. Sounds that are destroyed after the engine stops
+		// still need their instances deleted.
+		if (command.type == DESTROY_SOUND) {
+			ExecuteCommand(command);
+		}
+		return;
+	}
+
+	// The ring is large enough that this only waits in extreme cases
+	while (!commands.push(command)) {
+
+		wakeUp.notify_one();
+		std::this_thread::yield();
+	}
+
+} // end PostCommand
+
+
+void SoundEngine::AudioLoop()
+{
+	SoundCommand command;
+
+	while (true) {
+
+		// Stop only after the commands sent before Stop was called are done
+		bool quit = quitAudio;
+
+		while (commands.pop(command)) {
+			ExecuteCommand(command);
+		}
+
+		if (quit) {
+			break;
+		}
+
+		// Streams are refilled between frames as well
+		SoundStream::UpdateStreams();
+
+		std::unique_lock<std::mutex> lock(wakeMutex);
+		wakeUp.wait_for(lock, std::chrono::milliseconds(5));
+	}
+
+} // end AudioLoop
+
+
+void SoundEngine::ExecuteCommand(const SoundCommand& command)
+{
+	SoundInstance* sound = command.instance;
+
+	switch (command.type) {
+
+	case CREATE_SOUND:
+		sound->load();
+		soundInstances.push_back(sound);
+		break;
+
+	case DESTROY_SOUND:
+		if (sound->hasSource) {
+			ReleaseVoice(sound);
+		}
+		soundInstances.erase(std::remove(soundInstances.begin(), soundInstances.end(), sound), soundInstances.end());
+		delete sound;
+		break;
+
+	case PLAY_SOUND:
+		// Always start from the beginning
+		if (sound->hasSource) {
+			ReleaseVoice(sound);
+		}
+		sound->playbackPosition = 0.0f;
+		sound->playState = AL_PLAYING;
+		sound->playId = static_cast<unsigned int>(command.intValue);
+
+		// Start right away if a voice is free. Otherwise the sound is virtual
+		// until the next frame decides whether it is important enough.
+		AcquireVoice(sound);
+		break;
+
+	case CONTINUE_SOUND:
+		sound->playId = static_cast<unsigned int>(command.intValue);
+		if (sound->playState != AL_PLAYING) {
+
+			sound->playState = AL_PLAYING;
+			AcquireVoice(sound);
+		}
+		break;
+
+	case STOP_SOUND:
+		if (sound->hasSource) {
+			ReleaseVoice(sound);
+		}
+		sound->playbackPosition = 0.0f;
+		sound->playState = AL_STOPPED;
+		break;
+
+	case PAUSE_SOUND:
+		// A paused sound does not need a voice. The position is saved when it is released.
+		if (sound->playState == AL_PLAYING) {
+
+			if (sound->hasSource) {
+				ReleaseVoice(sound);
+			}
+			sound->playState = AL_PAUSED;
+		}
+		break;
+
+	case SET_SOUND_GAIN:
+		sound->gain = command.value;
+		sound->applyProperty(command.type);
+		break;
+
+	case SET_SOUND_LOOPING:
+		sound->looping = command.intValue != 0;
+		sound->applyProperty(command.type);
+		break;
+
+	case SET_SOUND_REFERENCE_DISTANCE:
+		sound->refDistance = command.value;
+		sound->applyProperty(command.type);
+		break;
+
+	case SET_SOUND_ROLL_OFF_FACTOR:
+		sound->rollOffFactor = command.value;
+		sound->applyProperty(command.type);
+		break;
+
+	case SET_SOUND_MAX_DISTANCE:
+		sound->maxDistance = command.value;
+		sound->applyProperty(command.type);
+		break;
+
+	case SET_SOUND_PRIORITY:
+		sound->priority = command.intValue;
+		break;
+
+	case SET_SOUND_TRANSFORM:
+		sound->position = command.position;
+		sound->velocity = command.velocity;
+		sound->forward = command.forward;
+		sound->transformDirty = true;
+		break;
+
+	case SET_LISTENER_TRANSFORM:
+		listenerPosition = command.position;
+		listenerVelocity = command.velocity;
+		listenerForward = command.forward;
+		listenerUp = command.up;
+		listenerDirty = true;
+		break;
+
+	case UPDATE_SOUND_FRAME:
+		UpdateFrame(command.value);
+		break;
+	}
+
+} // end ExecuteCommand
+
+
+void SoundEngine::UpdateFrame(float deltaTime)
+{
+	BeginBatch();
+
+	if (listenerDirty) {
+
+		alListener3f(AL_POSITION, listenerPosition.x, listenerPosition.y, listenerPosition.z);
+		alListener3f(AL_VELOCITY, listenerVelocity.x, listenerVelocity.y, listenerVelocity.z);
+
+		ALfloat orientation[] = { listenerForward.x, listenerForward.y, listenerForward.z,
+								  listenerUp.x, listenerUp.y, listenerUp.z };
+		alListenerfv(AL_ORIENTATION, orientation);
+
+		listenerDirty = false;
+	}
+
+	UpdateVoices(deltaTime);
+
+	// Sources that were just given a voice are already up to date
+	for (SoundInstance* sound : soundInstances) {
+
+		if (sound->hasSource && sound->transformDirty) {
+			sound->applyTransform();
+		}
+	}
+
+	EndBatch();
+
+	// Keep the buffers of streamed sounds filled
+	SoundStream::UpdateStreams();
+
+	// Mix the frame if the backend has no mixing thread of its own
+	backend->render(deltaTime);
+
+	check_al_errors();
+
+} // end UpdateFrame
+
+
+void SoundEngine::BeginBatch()
+{
+	if (alDeferUpdatesSOFT != nullptr) {
+
+		alDeferUpdatesSOFT();
+	}
+	else {
+
+		alcSuspendContext(alcGetCurrentContext());
+	}
+
+} // end BeginBatch
+
+
+void SoundEngine::EndBatch()
+{
+	if (alProcessUpdatesSOFT != nullptr) {
+
+		alProcessUpdatesSOFT();
+	}
+	else {
+
+		alcProcessContext(alcGetCurrentContext());
+	}
+
+} // end EndBatch
+
+
+void SoundEngine::UpdateVoices(float deltaTime)
+{
+	// Reused each frame to avoid allocating
+	static std::vector<SoundInstance*> audibleSounds;
+	audibleSounds.clear();
+
+	for (SoundInstance* sound : soundInstances) {
+
+		if (sound->playState != AL_PLAYING) {
+			continue;
+		}
+
+		if (!sound->advance(deltaTime)) {
+
+			// Finished playing. Lets the game know.
+			if (sound->hasSource) {
+				ReleaseVoice(sound);
+			}
+			sound->playbackPosition = 0.0f;
+			sound->playState = AL_STOPPED;
+			sound->finishedPlayId = sound->playId;
+			continue;
+		}
+
+		sound->audibility = EstimateGain(sound);
+
+		if (sound->audibility >= INAUDIBLE_GAIN) {
+
+			audibleSounds.push_back(sound);
+		}
+		else if (sound->hasSource) {
+
+			// Continue silently as a virtual sound
+			ReleaseVoice(sound);
+		}
+	}
+
+	// Move the sounds that should be heard to the front
+	size_t numHeard = std::min(audibleSounds.size(), voices.size());
+
+	std::nth_element(audibleSounds.begin(), audibleSounds.begin() + numHeard, audibleSounds.end(),
+		[](const SoundInstance* a, const SoundInstance* b) {
+
+			if (a->priority != b->priority) {
+				return a->priority > b->priority;
+			}
+			return a->audibility > b->audibility;
+		});
+
+	// Free the voices of the sounds that lost out before handing them to those that won
+	for (size_t i = numHeard; i < audibleSounds.size(); i++) {
+
+		if (audibleSounds[i]->hasSource) {
+			ReleaseVoice(audibleSounds[i]);
+		}
+	}
+
+	for (size_t i = 0; i < numHeard; i++) {
+
+		if (!audibleSounds[i]->hasSource) {
+			AcquireVoice(audibleSounds[i]);
+		}
+	}
+
+} // end UpdateVoices
+
+
+void SoundEngine::AcquireVoice(SoundInstance* sound)
+{
+	if (freeVoices.empty()) {
+		return;
+	}
+
+	ALuint source = freeVoices.back();
+	freeVoices.pop_back();
+
+	sound->attachSource(source);
+
+} // end AcquireVoice
+
+
+void SoundEngine::ReleaseVoice(SoundInstance* sound)
+{
+	freeVoices.push_back(sound->detachSource());
+
+} // end ReleaseVoice
+
+
+float SoundEngine::EstimateGain(const SoundInstance* sound)
+{
+	// See the distance models in the OpenAL 1.1 specification
+	float distance = glm::length(sound->position - listenerPosition);
+	float refDistance = sound->refDistance;
+	float rollOffFactor = sound->rollOffFactor;
+	float maxDistance = sound->maxDistance;
+
+	if (refDistance <= 0.0f || distanceModel == AL_NONE) {
+		return sound->gain;
+	}
+
+	if (distanceModel == AL_INVERSE_DISTANCE_CLAMPED || distanceModel == AL_LINEAR_DISTANCE_CLAMPED ||
+		distanceModel == AL_EXPONENT_DISTANCE_CLAMPED) {
+
+		distance = glm::clamp(distance, refDistance, glm::max(refDistance, maxDistance));
+	}
+
+	float attenuation = 1.0f;
+
+	switch (distanceModel) {
+
+	case AL_INVERSE_DISTANCE:
+	case AL_INVERSE_DISTANCE_CLAMPED:
+		attenuation = refDistance / glm::max(refDistance + rollOffFactor * (distance - refDistance), 0.0001f);
+		break;
+
+	case AL_LINEAR_DISTANCE:
+	case AL_LINEAR_DISTANCE_CLAMPED:
+		if (maxDistance > refDistance) {
+			attenuation = 1.0f - rollOffFactor * (glm::min(distance, maxDistance) - refDistance) / (maxDistance - refDistance);
+		}
+		break;
+
+	case AL_EXPONENT_DISTANCE:
+	case AL_EXPONENT_DISTANCE_CLAMPED:
+		attenuation = pow(glm::max(distance, 0.0001f) / refDistance, -rollOffFactor);
+		break;
+	}
+
+	return sound->gain * glm::clamp(attenuation, 0.0f, 1.0f);
+
+} // end EstimateGain
+
 void SoundEngine::Stop()
 {
 	//alcMakeContextCurrent(0);
 	//alcDestroyContext(context);
 	//alcCloseDevice(device);
 
-	alutExit();
-	check_alut_errors();
+	// Finish the commands that were already sent
+	if (audioThread.joinable()) {
+
+		quitAudio = true;
+		wakeUp.notify_one();
+		audioThread.join();
+	}
+
+	alDeferUpdatesSOFT = nullptr;
+	alProcessUpdatesSOFT = nullptr;
+
+	// Sounds continue as virtual sounds until they are destroyed
+	for (SoundInstance* sound : soundInstances) {
+
+		if (sound->hasSource) {
+			sound->detachSource();
+		}
+	}
+
+	alDeleteSources(static_cast<ALsizei>(voices.size()), voices.data());
+	voices.clear();
+	freeVoices.clear();
+
+	// Buffers must be deleted while the context still exists
+	SoundStream::StopStreaming();
+	SoundBuffer::unloadSoundBuffers();
+
+	if (backend != nullptr) {
+
+		backend->close();
+		delete backend;
+		backend = nullptr;
+	}
 
 }
 
@@ -135,6 +640,7 @@ static void list_audio_devices(const ALCchar* devices)
 
 bool SoundEngine::check_al_errors()
 {
+#ifndef NDEBUG
 	ALenum error = alGetError();
 	if (error != AL_NO_ERROR)
 	{
@@ -161,6 +667,7 @@ bool SoundEngine::check_al_errors()
 		std::cerr << std::endl;
 		return false;
 	}
+#endif
 	return true;
 }
 
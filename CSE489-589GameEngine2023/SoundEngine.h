@@ -2,6 +2,12 @@
 
 #include "MathLibsConstsFuncs.h"
 
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
 // Includes for the OpenAL Sound Engine
 #include <AL/al.h>
 #include <AL/alc.h>
@@ -24,28 +30,51 @@
 // follow instructions at 
 // https://www.laptopmag.com/how-to/convert-stereo-audio-file-to-mono-using-audacity
 
+#include "SoundCommandQueue.h"
+
+class SoundBackend;
+
 using namespace constants_and_types;
 
+/**
+ * @class	SoundEngine
+ *
+ * @brief	Sets up OpenAL and manages a fixed pool of OpenAL sources (voices).
+ * 			Each frame the voices are given to the highest priority sounds
+ * 			that can be heard. Sounds without a voice are virtual and only
+ * 			have their playback position tracked. All OpenAL work after Init
+ * 			is done on an audio thread owned by the engine. The game sends it
+ * 			commands through a lock-free queue and never waits for the driver.
+ */
 class SoundEngine 
 {
 public:
 
 	/**
-	 * @fn	static bool SoundEngine::Init(ALint distanceModel = AL_INVERSE_DISTANCE, ALfloat dopplerFactor = 1.0f);
+	 * @fn	static bool SoundEngine::Init(ALint distanceModel = AL_INVERSE_DISTANCE, ALfloat dopplerFactor = 1.0f, int maxVoices = 32, SoundBackend* backend = nullptr);
 	 *
-	 * @brief	Initialize the sound engine.
+	 * @brief	Initialize the sound engine and start the audio thread.
 	 *
 	 * @param 	distanceModel	(Optional) The distance model.
 	 * @param 	dopplerFactor	(Optional) The doppler factor.
+	 * @param 	maxVoices	 	(Optional) Number of sounds that can be heard at once. Fewer
+	 * 							are created if the OpenAL implementation runs out of sources.
+	 * @param 	backend		 	(Optional) Creates the device and context. Null plays through
+	 * 							the default audio device, or a NullSoundBackend if the
+	 * 							device cannot be opened. The engine takes ownership.
 	 *
-	 * @returns	True if it succeeds, false if it fails.
+	 * @returns	False if a backend that was passed in could not be opened. The
+	 * 			default device never fails the game. Sounds are silent instead.
 	 */
-	static bool Init(ALint distanceModel = AL_INVERSE_DISTANCE, ALfloat dopplerFactor = 1.0f);
+	static bool Init(ALint distanceModel = AL_INVERSE_DISTANCE, ALfloat dopplerFactor = 1.0f, int maxVoices = 32,
+					 SoundBackend* backend = nullptr);
 
 	/**
 	 * @fn	static void SoundEngine::Update(const float & deltaTime = 0.0f);
 	 *
-	 * @brief	Update the sound engine. Call this once each frame.
+	 * @brief	Update the sound engine. Call this once each frame after the
+	 * 			sound components have been updated. Asks the audio thread to
+	 * 			apply the commands sent during the frame and then update the sounds.
 	 *
 	 * @param	deltaTime	(Optional) The delta time.
 	 */
@@ -54,14 +83,16 @@ public:
 	/**
 	 * @fn	static void SoundEngine::Stop();
 	 *
-	 * @brief	Stop the sound engine. Call when closing down
+	 * @brief	Stop the sound engine. Call when closing down. Waits for the audio
+	 * 			thread to finish the commands that were sent and exit.
 	 */
 	static void Stop();
 
 	/**
 	 * @fn	static bool SoundEngine::check_al_errors();
 	 *
-	 * @brief	Checks for OpenAL error and prints error messages.
+	 * @brief	Checks for OpenAL error and prints error messages. Only checks
+	 * 			in debug builds because alGetError can stall the driver.
 	 *
 	 * @returns	True if there are no errors.
 	 */
@@ -77,12 +108,171 @@ public:
 	 */
 	static bool check_alut_errors();
 
+	/**
+	 * @fn	static int SoundEngine::GetNumVoices()
+	 *
+	 * @brief	Gets the number of OpenAL sources in the pool.
+	 *
+	 * @returns	The number of voices.
+	 */
+	static int GetNumVoices() { return static_cast<int>(voices.size()); }
+
+	/**
+	 * @fn	static SoundBackend* SoundEngine::GetBackend()
+	 *
+	 * @brief	Gets the backend that created the device and context.
+	 *
+	 * @returns	Null if the engine is not running, else the backend.
+	 */
+	static SoundBackend* GetBackend() { return backend; }
+
+	/**
+	 * @fn	static bool SoundEngine::IsRunning()
+	 *
+	 * @brief	Checks whether the audio thread is carrying out commands. False
+	 * 			before Init, after Stop, and when no backend could be opened.
+	 *
+	 * @returns	True if the audio thread is running.
+	 */
+	static bool IsRunning() { return audioThread.joinable(); }
+
 	friend class SoundBaseComponent;
 	friend class SoundListenerComponent;
 	friend class SoundSourceComponent;
 
 protected:
 
+	/**
+	 * @fn	static void SoundEngine::PostCommand(const SoundCommand& command);
+	 *
+	 * @brief	Sends a command to the audio thread. Only called on the game thread.
+	 * 			When the audio thread is not running, because the engine stopped or
+	 * 			never started, DESTROY_SOUND is carried out right away so the
+	 * 			instance is deleted. Every other command is dropped.
+	 *
+	 * @param	command	The command.
+	 */
+	static void PostCommand(const SoundCommand& command);
+
+	/**
+	 * @fn	static void SoundEngine::AudioLoop();
+	 *
+	 * @brief	Body of the audio thread. Carries out commands as they arrive and
+	 * 			keeps the streamed sounds filled in between.
+	 */
+	static void AudioLoop();
+
+	/**
+	 * @fn	static void SoundEngine::ExecuteCommand(const SoundCommand& command);
+	 *
+	 * @brief	Carries out a single command on the audio thread.
+	 *
+	 * @param	command	The command.
+	 */
+	static void ExecuteCommand(const SoundCommand& command);
+
+	/**
+	 * @fn	static void SoundEngine::UpdateFrame(float deltaTime);
+	 *
+	 * @brief	Advances the playback position of all playing sounds and reassigns
+	 * 			the voices. The listener and the sources that moved are then passed
+	 * 			to OpenAL as one batch.
+	 *
+	 * @param	deltaTime	The delta time.
+	 */
+	static void UpdateFrame(float deltaTime);
+
+	/**
+	 * @fn	static void SoundEngine::UpdateVoices(float deltaTime);
+	 *
+	 * @brief	Ranks the playing sounds by priority and estimated gain at the
+	 * 			listener. Voices are taken from sounds that are no longer among
+	 * 			the loudest and given to those that are.
+	 *
+	 * @param	deltaTime	The delta time.
+	 */
+	static void UpdateVoices(float deltaTime);
+
+	/**
+	 * @fn	static void SoundEngine::BeginBatch();
+	 *
+	 * @brief	Defers the changes made to the listener and sources until EndBatch
+	 * 			is called so that they are applied together. Uses
+	 * 			AL_SOFT_deferred_updates if it is available. Otherwise suspends the
+	 * 			context.
+	 */
+	static void BeginBatch();
+
+	/**
+	 * @fn	static void SoundEngine::EndBatch();
+	 *
+	 * @brief	Applies the changes made since BeginBatch was called.
+	 */
+	static void EndBatch();
+
+	/**
+	 * @fn	static void SoundEngine::AcquireVoice(SoundInstance* sound);
+	 *
+	 * @brief	Gives a sound a voice if one is free.
+	 *
+	 * @param [in]	sound	The sound.
+	 */
+	static void AcquireVoice(SoundInstance* sound);
+
+	/**
+	 * @fn	static void SoundEngine::ReleaseVoice(SoundInstance* sound);
+	 *
+	 * @brief	Takes the voice from a sound and returns it to the pool.
+	 *
+	 * @param [in]	sound	The sound.
+	 */
+	static void ReleaseVoice(SoundInstance* sound);
+
+	/**
+	 * @fn	static float SoundEngine::EstimateGain(const SoundInstance* sound);
+	 *
+	 * @brief	Estimates the gain of a sound at the listener using the current
+	 * 			distance model.
+	 *
+	 * @param	sound	The sound.
+	 *
+	 * @returns	The estimated gain.
+	 */
+	static float EstimateGain(const SoundInstance* sound);
+
+	/** @brief	All of the OpenAL sources and those not used by a sound. */
+	static std::vector<ALuint> voices;
+	static std::vector<ALuint> freeVoices;
+
+	/** @brief	Every sound whether it has a voice or not. Only used on the audio thread. */
+	static std::vector<SoundInstance*> soundInstances;
+
+	/** @brief	World position, velocity, and orientation of the listener. */
+	static vec3 listenerPosition;
+	static vec3 listenerVelocity;
+	static vec3 listenerForward;
+	static vec3 listenerUp;
+
+	/** @brief	True if the listener has moved since it was last passed to OpenAL. */
+	static bool listenerDirty;
+
+	static ALint distanceModel;
+
+	/** @brief	Creates and destroys the device and context. */
+	static SoundBackend* backend;
+
+	/** @brief	Commands from the game thread to the audio thread. */
+	static SoundCommandQueue commands;
+
+	static std::thread audioThread;
+
+	/** @brief	Wakes the audio thread when a frame has been sent. */
+	static std::mutex wakeMutex;
+	static std::condition_variable wakeUp;
+
+	/** @brief	Set to ask the audio thread to exit once the queue is empty. */
+	static std::atomic<bool> quitAudio;
+
 	//static ALCdevice* device;
 	//static ALCcontext* context;
 
@@ -0,0 +1,221 @@
+#include "SoundInstance.h"
+
+#define VERBOSE false
+
+
+SoundInstance::SoundInstance(const std::string& fileName, SoundLoadMode loadMode, float refDistance,
+	float rollOffFactor, float maxDistance)
+	: fileName(fileName), loadMode(loadMode), refDistance(refDistance), rollOffFactor(rollOffFactor),
+	  maxDistance(maxDistance), finishedPlayId(0), heard(false)
+{
+
+} // end constructor
+
+
+SoundInstance::~SoundInstance()
+{
+	if (VERBOSE) cout << "~SoundInstance " << fileName << endl;
+
+	// The stream must be deleted before the shared buffer is released because a
+	// buffer attached to a source cannot be deleted.
+	delete stream;
+	SoundBuffer::ReleaseSoundBuffer(buffer);
+
+} // end destructor
+
+
+void SoundInstance::load()
+{
+	if (loadMode == STREAM_FROM_FILE) {
+
+		// Buffers are queued on the source as the file is read
+		stream = new SoundStream(fileName);
+		stream->setLooping(looping);
+	}
+	else {
+
+		// Load the sound file into a buffer or share the buffer if it was loaded before.
+		buffer = SoundBuffer::GetSoundBuffer(fileName);
+	}
+
+} // end load
+
+
+void SoundInstance::attachSource(ALuint source)
+{
+	this->source = source;
+	hasSource = true;
+	heard = true;
+
+	// The source may have been used by a different sound
+	alSourcef(source, AL_GAIN, gain);
+	alSourcef(source, AL_REFERENCE_DISTANCE, refDistance);
+	alSourcef(source, AL_ROLLOFF_FACTOR, rollOffFactor);
+	alSourcef(source, AL_MAX_DISTANCE, maxDistance);
+	applyTransform();
+
+	if (stream != nullptr) {
+
+		alSourcei(source, AL_LOOPING, AL_FALSE);
+		stream->play(source, playbackPosition);
+	}
+	else if (buffer != nullptr) {
+
+		alSourcei(source, AL_BUFFER, buffer->getBufferObject());
+		alSourcei(source, AL_LOOPING, looping ? AL_TRUE : AL_FALSE);
+		alSourcef(source, AL_SEC_OFFSET, playbackPosition);
+		alSourcePlay(source);
+	}
+
+	SoundEngine::check_al_errors();
+
+} // end attachSource
+
+
+ALuint SoundInstance::detachSource()
+{
+	if (stream != nullptr) {
+
+		stream->stop();
+	}
+	else {
+
+		// The source knows exactly where it is
+		ALint state;
+		alGetSourcei(source, AL_SOURCE_STATE, &state);
+
+		if (state == AL_PLAYING || state == AL_PAUSED) {
+			alGetSourcef(source, AL_SEC_OFFSET, &playbackPosition);
+		}
+
+		alSourceStop(source);
+		alSourcei(source, AL_BUFFER, 0);
+	}
+
+	SoundEngine::check_al_errors();
+
+	hasSource = false;
+	heard = false;
+
+	return source;
+
+} // end detachSource
+
+
+void SoundInstance::applyTransform()
+{
+	// Set the position, direction, and velocity of the sound source
+	alSource3f(source, AL_POSITION, position.x, position.y, position.z);
+	alSource3f(source, AL_VELOCITY, velocity.x, velocity.y, velocity.z);
+	alSource3f(source, AL_DIRECTION, forward.x, forward.y, forward.z);
+
+	transformDirty = false;
+
+} // end applyTransform
+
+
+void SoundInstance::applyProperty(SOUND_COMMAND_TYPE property)
+{
+	// A looping source would replay the queued buffers. The stream
+	// starts over at the end of the file instead.
+	if (property == SET_SOUND_LOOPING && stream != nullptr) {
+
+		stream->setLooping(looping);
+		return;
+	}
+
+	if (!hasSource) {
+		return;
+	}
+
+	switch (property) {
+
+	case SET_SOUND_GAIN:
+		alSourcef(source, AL_GAIN, gain);
+		break;
+
+	case SET_SOUND_LOOPING:
+		alSourcei(source, AL_LOOPING, looping ? AL_TRUE : AL_FALSE);
+		break;
+
+	case SET_SOUND_REFERENCE_DISTANCE:
+		alSourcef(source, AL_REFERENCE_DISTANCE, refDistance);
+		break;
+
+	case SET_SOUND_ROLL_OFF_FACTOR:
+		alSourcef(source, AL_ROLLOFF_FACTOR, rollOffFactor);
+		break;
+
+	case SET_SOUND_MAX_DISTANCE:
+		alSourcef(source, AL_MAX_DISTANCE, maxDistance);
+		break;
+
+	default:
+		break;
+	}
+
+	SoundEngine::check_al_errors();
+
+} // end applyProperty
+
+
+bool SoundInstance::advance(float deltaTime)
+{
+	if (hasSource) {
+
+		// Sounds that are heard finish when their source does
+		if (stream != nullptr) {
+
+			if (!stream->isPlaying()) {
+				return false;
+			}
+		}
+		else {
+
+			ALint state;
+			alGetSourcei(source, AL_SOURCE_STATE, &state);
+
+			if (state != AL_PLAYING) {
+				return false;
+			}
+		}
+	}
+
+	float duration = getDuration();
+
+	playbackPosition += deltaTime;
+
+	if (playbackPosition >= duration) {
+
+		if (looping && duration > 0.0f) {
+
+			playbackPosition = fmod(playbackPosition, duration);
+		}
+		else if (hasSource) {
+
+			// The source will stop on its own
+			playbackPosition = duration;
+		}
+		else {
+
+			return false;
+		}
+	}
+
+	return true;
+
+} // end advance
+
+
+float SoundInstance::getDuration() const
+{
+	if (stream != nullptr) {
+		return stream->getDuration();
+	}
+	else if (buffer != nullptr) {
+		return buffer->getDuration();
+	}
+
+	return 0.0f;
+
+} // end getDuration
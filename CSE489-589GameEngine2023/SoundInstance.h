@@ -0,0 +1,183 @@
+#pragma once
+
+#include <string>
+#include <atomic>
+
+#include "SoundEngine.h"
+#include "SoundBuffer.h"
+#include "SoundStream.h"
+#include "SoundCommandQueue.h"
+
+/**
+ * @enum	SoundLoadMode
+ *
+ * @brief	How the samples of a sound file reach OpenAL. Short sounds are
+ * 			loaded into memory once and shared. Long tracks are streamed from
+ * 			the file a few kilobytes at a time.
+ */
+enum SoundLoadMode { LOAD_INTO_MEMORY, STREAM_FROM_FILE };
+
+/**
+ * @class	SoundInstance
+ *
+ * @brief	The audio thread's half of a SoundSourceComponent. Holds the
+ * 			sound's samples, its properties, and the OpenAL source it is
+ * 			played through if it has one. Created by the component on the
+ * 			game thread. From then on it is only used by the audio thread,
+ * 			which also deletes it, except for the two atomic flags the
+ * 			component reads.
+ */
+class SoundInstance
+{
+public:
+
+	/**
+	 * @fn	SoundInstance::SoundInstance(const std::string& fileName, SoundLoadMode loadMode, float refDistance, float rollOffFactor, float maxDistance);
+	 *
+	 * @brief	Constructor. Records the settings of the sound. The file is not read
+	 * 			until the audio thread calls load.
+	 */
+	SoundInstance(const std::string& fileName, SoundLoadMode loadMode, float refDistance, float rollOffFactor, float maxDistance);
+
+	/**
+	 * @fn	SoundInstance::~SoundInstance();
+	 *
+	 * @brief	Destructor. Deletes the stream and releases the buffer. The source
+	 * 			must already have been detached.
+	 */
+	~SoundInstance();
+
+	/**
+	 * @fn	unsigned int SoundInstance::getFinishedPlayId() const
+	 *
+	 * @brief	Gets the identifier of the last play request that finished. Safe to
+	 * 			call from the game thread.
+	 *
+	 * @returns	The play identifier.
+	 */
+	unsigned int getFinishedPlayId() const { return finishedPlayId; }
+
+	/**
+	 * @fn	bool SoundInstance::isHeard() const
+	 *
+	 * @brief	Query if the sound has an OpenAL source. Safe to call from the game thread.
+	 *
+	 * @returns	True if heard, false if not.
+	 */
+	bool isHeard() const { return heard; }
+
+	friend class SoundEngine;
+
+protected:
+
+	/**
+	 * @fn	void SoundInstance::load();
+	 *
+	 * @brief	Loads the buffer or opens the stream.
+	 */
+	void load();
+
+	/**
+	 * @fn	void SoundInstance::attachSource(ALuint source);
+	 *
+	 * @brief	Gives the sound an OpenAL source. The source is set up from the
+	 * 			properties of the sound and starts playing at the tracked position.
+	 *
+	 * @param	source	The source.
+	 */
+	void attachSource(ALuint source);
+
+	/**
+	 * @fn	ALuint SoundInstance::detachSource();
+	 *
+	 * @brief	Stops the source and takes it from the sound. The playback position is
+	 * 			saved so the sound can continue as a virtual sound.
+	 *
+	 * @returns	The source.
+	 */
+	ALuint detachSource();
+
+	/**
+	 * @fn	void SoundInstance::applyTransform();
+	 *
+	 * @brief	Passes the position, velocity, and direction of the sound to its source.
+	 */
+	void applyTransform();
+
+	/**
+	 * @fn	void SoundInstance::applyProperty(SOUND_COMMAND_TYPE property);
+	 *
+	 * @brief	Passes a property that was just changed to the source if there is one.
+	 *
+	 * @param	property	The command that changed the property.
+	 */
+	void applyProperty(SOUND_COMMAND_TYPE property);
+
+	/**
+	 * @fn	bool SoundInstance::advance(float deltaTime);
+	 *
+	 * @brief	Moves the tracked playback position forward. Called once each frame
+	 * 			for sounds that are playing.
+	 *
+	 * @param	deltaTime	The delta time.
+	 *
+	 * @returns	False if the sound has finished.
+	 */
+	bool advance(float deltaTime);
+
+	/**
+	 * @fn	float SoundInstance::getDuration() const;
+	 *
+	 * @brief	Gets the length of the sound file.
+	 *
+	 * @returns	The duration in seconds.
+	 */
+	float getDuration() const;
+
+	/** @brief	The sound file and how it is played. */
+	std::string fileName;
+	SoundLoadMode loadMode;
+
+	/** @brief	Buffer shared by all sources that play the same file. */
+	SoundBuffer* buffer = nullptr;
+
+	/** @brief	Stream that feeds the source. Null unless the file is streamed. */
+	SoundStream* stream = nullptr;
+
+	/** @brief	Source the sound is played through. Only valid if hasSource is true. */
+	ALuint source = 0;
+	bool hasSource = false;
+
+	/** @brief	AL_PLAYING, AL_PAUSED, or AL_STOPPED whether or not the sound has a source. */
+	ALint playState = AL_STOPPED;
+
+	/** @brief	Identifier of the play request that is being played. */
+	unsigned int playId = 0;
+
+	/** @brief	Playback position in seconds. */
+	float playbackPosition = 0.0f;
+
+	/** @brief	Properties applied to the source whenever one is attached. */
+	float gain = 1.0f;
+	float refDistance;
+	float rollOffFactor;
+	float maxDistance;
+	bool looping = false;
+	int priority = 0;
+
+	/** @brief	World position, velocity, and direction of the sound. */
+	vec3 position = ZERO_V3;
+	vec3 velocity = ZERO_V3;
+	vec3 forward = ZERO_V3;
+
+	/** @brief	True if the values above have changed since they were passed to the source. */
+	bool transformDirty = true;
+
+	/** @brief	Estimated gain at the listener. Computed by the sound engine each frame. */
+	float audibility = 0.0f;
+
+	/** @brief	Read by the game thread. */
+	std::atomic<unsigned int> finishedPlayId;
+	std::atomic<bool> heard;
+
+}; // end SoundInstance class
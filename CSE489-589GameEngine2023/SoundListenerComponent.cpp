@@ -7,14 +7,19 @@ void SoundListenerComponent::update(const float& deltaTime) {
     // Call SoundBaseComponent update method
     SoundBaseComponent::update(deltaTime);
 
-    // Updates the position, velocity, and orientation of the listener
-    alListener3f(AL_POSITION, soundPosition.x, soundPosition.y, soundPosition.z);
-    alListener3f(AL_VELOCITY, soundVelocity.x, soundVelocity.y, soundVelocity.z);
+    // Sends the position, velocity, and orientation of the listener to the
+    // audio thread, which applies them along with the sources.
+    if (transformDirty) {
 
-    ALfloat orientation[] = { soundForward.x, soundForward.y, soundForward.z,
-                              soundUp.x, soundUp.y, soundUp.z };
-    alListenerfv(AL_ORIENTATION, orientation);
+        SoundCommand command;
+        command.type = SET_LISTENER_TRANSFORM;
+        command.position = soundPosition;
+        command.velocity = soundVelocity;
+        command.forward = soundForward;
+        command.up = soundUp;
 
-    // check for errors
-    SoundEngine::check_al_errors();
+        SoundEngine::PostCommand(command);
+
+        transformDirty = false;
+    }
 }
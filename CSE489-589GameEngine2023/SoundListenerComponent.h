@@ -12,11 +12,12 @@ public:
 	/**
 	 * @fn	virtual void SoundListenerComponent::update( float deltaTime ) override;
 	 *
-	 * @brief	Updates the position, velocity, and orientation of the listener
+	 * @brief	Updates the position, velocity, and orientation of the listener.
+	 * 			If they changed, they are sent to the audio thread, which passes
+	 * 			them to OpenAL at the next frame update.
 	 * 			
 	 *			Calls:
 	 *			SoundBaseComponent::update( deltaTime );
-	 *			SoundEngine::check_al_errors();
 	 *
 	 * @param	deltaTime	The delta time.
 	 */
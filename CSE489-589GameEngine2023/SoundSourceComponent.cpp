@@ -5,40 +5,32 @@
 
 SoundSourceComponent::SoundSourceComponent( std::string soundFileName, float refDistance,
 	float rollOffFactor, float maxDistance, int updateOrder)
-	: SoundBaseComponent( updateOrder )
+	: SoundSourceComponent(soundFileName, LOAD_INTO_MEMORY, refDistance, rollOffFactor, maxDistance, updateOrder)
 {
-	// Load the sound file into a buffer.
-	buffer = alutCreateBufferFromFile(soundFileName.c_str());
-	SoundEngine::check_alut_errors();
 
-	// Create a source
-	alGenSources((ALuint)1, &source);
-	SoundEngine::check_al_errors();
+} // SoundSource constructor
 
-	// Associate the buffer with the source
-	alSourcei(source, AL_BUFFER, buffer);
-	SoundEngine::check_al_errors();
 
-	// Set the sound reference distance roll off factor and max distance properties.
-	alSourcef(source, AL_REFERENCE_DISTANCE, refDistance);
-	alSourcef(source, AL_ROLLOFF_FACTOR, rollOffFactor);
-	alSourcef(source, AL_MAX_DISTANCE, maxDistance);
+SoundSourceComponent::SoundSourceComponent( std::string soundFileName, SoundLoadMode loadMode,
+	float refDistance, float rollOffFactor, float maxDistance, int updateOrder)
+	: SoundBaseComponent( updateOrder )
+{
+	// The audio thread takes ownership of the instance and loads the file
+	instance = new SoundInstance(soundFileName, loadMode, refDistance, rollOffFactor, maxDistance);
 
-	SoundEngine::check_al_errors();
+	postCommand(CREATE_SOUND);
 
 } // SoundSource constructor
 
 
 SoundSourceComponent::~SoundSourceComponent( )
 {
-	// Stop playing the sound
-	stop();
-
 	if (VERBOSE) cout << "~SoundSourceComponent" << endl;
 
-	// Delete the source and the buffer
-	alDeleteSources(1, &source);
-	alDeleteBuffers(1, &buffer);
+	// The audio thread stops the sound and deletes the instance. The instance
+	// must not be used after this.
+	postCommand(DESTROY_SOUND);
+	instance = nullptr;
 
 } // end SoundSource destructor
 
@@ -47,36 +39,54 @@ void SoundSourceComponent::update(const float& deltaTime)
 {
 	// Call SoundBaseComponent update method
 	SoundBaseComponent::update(deltaTime);
-	
 
-	// Set the position, direction, and velocity of the sound source using
-	// data members inherited from SoundBaseComponent.
-	alSource3f(source, AL_POSITION, soundPosition.x, soundPosition.y, soundPosition.z);
-	alSource3f(source, AL_VELOCITY, soundVelocity.x, soundVelocity.y, soundVelocity.z);
-	alSource3f(source, AL_DIRECTION, soundForward.x, soundForward.y, soundForward.z);
+	// Only sounds that moved are sent to the audio thread
+	if (transformDirty) {
+
+		SoundCommand command;
+		command.type = SET_SOUND_TRANSFORM;
+		command.instance = instance;
+		command.position = soundPosition;
+		command.velocity = soundVelocity;
+		command.forward = soundForward;
 
-	// check for errors
-	SoundEngine::check_al_errors();
+		SoundEngine::PostCommand(command);
+
+		transformDirty = false;
+	}
 
 } // end update
 
+
+void SoundSourceComponent::postCommand(SOUND_COMMAND_TYPE type, float value, int intValue)
+{
+	SoundCommand command;
+	command.type = type;
+	command.instance = instance;
+	command.value = value;
+	command.intValue = intValue;
+
+	SoundEngine::PostCommand(command);
+
+} // end postCommand
+
  // Start playing the sound
 void SoundSourceComponent::play()
 {
-	// Play the source
-	alSourcePlay(source);
+	// Always start from the beginning
+	playState = AL_PLAYING;
+	playId++;
 
-	SoundEngine::check_al_errors();
+	postCommand(PLAY_SOUND, 0.0f, static_cast<int>(playId));
 
 } // end play
 
 // Stop the sound. 
 void SoundSourceComponent::stop()
 {
-	// Stop playing the source
-	alSourceStop(source);
+	playState = AL_STOPPED;
 
-	SoundEngine::check_al_errors();
+	postCommand(STOP_SOUND);
 
 } // end stop
 
@@ -84,78 +94,63 @@ void SoundSourceComponent::stop()
   // where is was paused.
 void SoundSourceComponent::pause()
 {
-	// Pause the source
-	alSourcePause(source);
+	if (!isPlaying()) {
+		return;
+	}
 
-	SoundEngine::check_al_errors();
+	playState = AL_PAUSED;
+
+	postCommand(PAUSE_SOUND);
 
 } // end pause
 
 void SoundSourceComponent::continuePlaying()
 {
-	// Continue playing the source
-	alSourcePlay(source);
-	
-	SoundEngine::check_al_errors();
+	if (isPlaying()) {
+		return;
+	}
+
+	// Continue playing from the saved position
+	playState = AL_PLAYING;
+	playId++;
+
+	postCommand(CONTINUE_SOUND, 0.0f, static_cast<int>(playId));
 
 } // end continuePlaying
 
 void SoundSourceComponent::setLooping(bool loopingOn)
 {
 	// Set the source to loop
-	alSourcei(source, AL_LOOPING, loopingOn ? AL_TRUE : AL_FALSE);
-
-	SoundEngine::check_al_errors();
+	postCommand(SET_SOUND_LOOPING, 0.0f, loopingOn ? 1 : 0);
 
 } // end setLooping
 
 // Check to see if a sound it actively playing
-bool SoundSourceComponent::isPlaying()
+bool SoundSourceComponent::isPlaying() const
 {
-	ALint state;
-	
-	// Query for the state of the sound source
-	alGetSourcei(source, AL_SOURCE_STATE, &state);
-
-	SoundEngine::check_al_errors();
-
-	// Return turn if the state is AL_PLAYING
-	return state == AL_PLAYING;
+	// The audio thread reports when the sound reaches the end. Nothing plays
+	// when it is not running.
+	return playState == AL_PLAYING && SoundEngine::IsRunning() && instance->getFinishedPlayId() != playId;
 
 } // end isPlaying
 
-bool SoundSourceComponent::isPaused()
+bool SoundSourceComponent::isPaused() const
 {
-	ALint state;
-	// Query for the state of the sound source
-	alGetSourcei(source, AL_SOURCE_STATE, &state);
-
-	SoundEngine::check_al_errors();
-
-	// Return turn if the state is AL_PAUSED
-	return state == AL_PAUSED;
+	return playState == AL_PAUSED;
 	
 } // end isPlaying
 
 void SoundSourceComponent::setGain(float volume)
 {
-	// Set the gain "volume" of the sound source.
-	alSourcef(source, AL_GAIN, volume);
+	gain = volume;
 
-	SoundEngine::check_al_errors();
+	// Set the gain "volume" of the sound source.
+	postCommand(SET_SOUND_GAIN, volume);
 
 } // end setGain
 
-float SoundSourceComponent::getGain()
+float SoundSourceComponent::getGain() const
 {
-	float gain;
-	
-	// Query for the current gain.
-	alGetSourcef(source, AL_GAIN, &gain);
-
-	SoundEngine::check_al_errors();
-
-	// return the gain
 	return gain;
 
 } // end getGain
@@ -163,27 +158,28 @@ float SoundSourceComponent::getGain()
 void SoundSourceComponent::setReferenceDistance(float refDistance)
 {
 	// Set the reference distance
-	alSourcef(source, AL_REFERENCE_DISTANCE, refDistance);
-
-	SoundEngine::check_al_errors();
+	postCommand(SET_SOUND_REFERENCE_DISTANCE, refDistance);
 
 } // end setReferenceDistance
 
 void SoundSourceComponent::setRollOffFactor(float rollOffFactor)
 {
 	// Set the roll off factor
-	alSourcef(source, AL_ROLLOFF_FACTOR, rollOffFactor);
-
-	SoundEngine::check_al_errors();
+	postCommand(SET_SOUND_ROLL_OFF_FACTOR, rollOffFactor);
 
 } // end setRollOffFactor
 
 void SoundSourceComponent::setMaxDistance(float maxDistance)
 {
 	// Set the max distance
-	alSourcef(source, AL_MAX_DISTANCE, maxDistance);
-
-	SoundEngine::check_al_errors();
+	postCommand(SET_SOUND_MAX_DISTANCE, maxDistance);
 
 } // end setMaxDistance
 
+void SoundSourceComponent::setPriority(int priority)
+{
+	this->priority = priority;
+
+	postCommand(SET_SOUND_PRIORITY, 0.0f, priority);
+
+} // end setPriority
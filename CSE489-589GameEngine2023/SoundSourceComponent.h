@@ -1,12 +1,17 @@
 #pragma once
 #include "SoundBaseComponent.h"
+#include "SoundInstance.h"
 #include <string>
 
 /**
  * @class	SoundSourceComponent
  *
- * @brief	
- * 			
+ * @brief	A logical sound. The sound engine only gives OpenAL sources to
+ * 			the highest priority sounds that can be heard. The rest are
+ * 			virtual: their playback position is tracked without a source so
+ * 			that they resume at the right point if they become audible.
+ * 			All of the methods only post commands to the audio thread so
+ * 			they never wait for OpenAL.
  */
 class SoundSourceComponent : public SoundBaseComponent
 {
@@ -26,10 +31,26 @@ public:
 	SoundSourceComponent(std::string soundFileName, float refDistance = 4.0f, 
 		float rollOffFactor = 2.0f, float maxDistance = 50.0f, int updateOrder = 100);
 
+	/**
+	 * @fn	SoundSourceComponent::SoundSourceComponent(std::string soundFileName, SoundLoadMode loadMode, float refDistance, float rollOffFactor, float maxDistance, int updateOrder);
+	 *
+	 * @brief	Constructor
+	 *
+	 * @param 	soundFileName	Filename of the sound file. (Must be a mono channel wave)
+	 * @param 	loadMode	 	STREAM_FROM_FILE to stream the file rather than load it
+	 * 							into memory. Streamed files must be 8 or 16 bit PCM.
+	 * @param 	refDistance  	Distance at which gain is one.
+	 * @param 	rollOffFactor	Controls falloff with distance. Higher number = faster falloff
+	 * @param 	maxDistance  	Distance at which sounds stops attenuating and gain is constant.
+	 * @param 	updateOrder  	The update order.
+	 */
+	SoundSourceComponent(std::string soundFileName, SoundLoadMode loadMode, float refDistance = 4.0f,
+		float rollOffFactor = 2.0f, float maxDistance = 50.0f, int updateOrder = 100);
+
 	/**
 	 * @fn	SoundSourceComponent::~SoundSourceComponent();
 	 *
-	 * @brief	Destructor - Deletes the source and buffer.
+	 * @brief	Destructor - Asks the audio thread to stop the sound and delete its instance.
 	 * 			
 	 */
 	~SoundSourceComponent();
@@ -45,11 +66,12 @@ public:
 	/**
 	 * @fn	virtual void SoundSourceComponent::update( float deltaTime ) override;
 	 *
-	 * @brief	Updates the position, velocity, and orientation of the source
-	 * 			
+	 * @brief	Updates the position, velocity, and orientation of the sound. They
+	 * 			are sent to the audio thread if they changed and passed on to OpenAL if the
+	 * 			sound is not virtual.
+	 *
 	 *			Calls:
 	 *			SoundBaseComponent::update( deltaTime );
-	 *			SoundEngine::check_al_errors();
 	 *
 	 * @param	deltaTime	The delta time.
 	 */
@@ -85,13 +107,15 @@ public:
 	void continuePlaying();
 
 	/**
-	 * @fn	bool SoundSourceComponent::isPlaying( );
+	 * @fn	bool SoundSourceComponent::isPlaying( ) const;
 	 *
-	 * @brief	Query if this object is playing
+	 * @brief	Query if this object is playing. Virtual sounds are playing even
+	 * 			though they are not heard. Nothing is playing while the sound
+	 * 			engine is not running, e.g. after Init failed.
 	 *
 	 * @returns	True if playing, false if not.
 	 */
-	bool isPlaying( );
+	bool isPlaying( ) const;
 
 	/**
 	 * @fn	void SoundSourceComponent::setGain(float volume);
@@ -104,23 +128,23 @@ public:
 	void setGain(float volume);
 
 	/**
-	 * @fn	float SoundSourceComponent::getGain();
+	 * @fn	float SoundSourceComponent::getGain() const;
 	 *
 	 * @brief	Returns the current volume level for the sound.
 	 * 			@returne - volume level for the sound.
 	 *
 	 * @returns	The volume.
 	 */
-	float getGain();
+	float getGain() const;
 
 	/**
-	 * @fn	bool SoundSourceComponent::isPaused();
+	 * @fn	bool SoundSourceComponent::isPaused() const;
 	 *
 	 * @brief	Query if this sound is paused
 	 *
 	 * @returns	True if paused, false if not.
 	 */
-	bool isPaused();
+	bool isPaused() const;
 
 	/**
 	 * @fn	void SoundSourceComponent::setLooping(bool loopingOn);
@@ -170,9 +194,56 @@ public:
 	 */
 	void setMaxDistance(float maxDistance);
 
+	/**
+	 * @fn	void SoundSourceComponent::setPriority(int priority);
+	 *
+	 * @brief	Sets the priority of the sound. When there are more audible sounds than
+	 * 			sources, sounds with a higher priority always get a source first. Sounds
+	 * 			with the same priority are ranked by how loud they are at the listener.
+	 *
+	 * @param 	priority	The priority. The default is zero.
+	 */
+	void setPriority(int priority);
+
+	/**
+	 * @fn	int SoundSourceComponent::getPriority() const
+	 *
+	 * @brief	Gets the priority of the sound.
+	 *
+	 * @returns	The priority.
+	 */
+	int getPriority() const { return priority; }
+
+	/**
+	 * @fn	bool SoundSourceComponent::isVirtual() const
+	 *
+	 * @brief	Query if the sound is playing without an OpenAL source.
+	 *
+	 * @returns	True if virtual, false if not.
+	 */
+	bool isVirtual() const { return isPlaying() && !instance->isHeard(); }
+
 protected:
 
-	ALuint buffer;
-	ALuint source;
-};
+	/**
+	 * @fn	void SoundSourceComponent::postCommand(SOUND_COMMAND_TYPE type, float value = 0.0f, int intValue = 0);
+	 *
+	 * @brief	Sends a command for this sound to the audio thread.
+	 */
+	void postCommand(SOUND_COMMAND_TYPE type, float value = 0.0f, int intValue = 0);
+
+	/** @brief	The audio thread's half of the sound. Deleted by the audio thread. */
+	SoundInstance* instance = nullptr;
 
+	/** @brief	AL_PLAYING, AL_PAUSED, or AL_STOPPED as requested by the game. */
+	ALint playState = AL_STOPPED;
+
+	/** @brief	Incremented each time the sound is played. The sound is finished
+	 * 			once the instance reports that this play request finished.
+	 */
+	unsigned int playId = 0;
+
+	/** @brief	Values returned by the getters. */
+	float gain = 1.0f;
+	int priority = 0;
+};
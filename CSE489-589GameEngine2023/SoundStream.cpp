@@ -0,0 +1,441 @@
+#include "SoundStream.h"
+
+#include <algorithm>
+#include <chrono>
+
+#define VERBOSE false
+
+// ********** Static data members ************************
+std::vector<SoundStream*> SoundStream::streams;
+
+std::vector<SoundStream*> SoundStream::activeStreams;
+
+std::mutex SoundStream::streamMutex;
+
+std::condition_variable SoundStream::streamWork;
+
+std::condition_variable SoundStream::readFinished;
+
+std::thread SoundStream::readerThread;
+
+bool SoundStream::quitReader = false;
+
+// ********** Helper Functions ************************
+
+// Reads a little endian unsigned integer of numBytes bytes
+static bool readLittleEndian(std::ifstream& file, int numBytes, unsigned int& value)
+{
+	unsigned char bytes[4];
+
+	if (!file.read(reinterpret_cast<char*>(bytes), numBytes)) {
+		return false;
+	}
+
+	value = 0;
+	for (int i = numBytes - 1; i >= 0; i--) {
+		value = (value << 8) | bytes[i];
+	}
+
+	return true;
+
+} // end readLittleEndian
+
+
+SoundStream::SoundStream(const std::string& fileName)
+	: filledChunks(0), endOfData(false), looping(false)
+{
+	file.open(fileName, std::ios::binary);
+
+	char id[4];
+	unsigned int size = 0;
+
+	if (!file || !file.read(id, 4) || std::string(id, 4) != "RIFF" ||
+		!readLittleEndian(file, 4, size) || !file.read(id, 4) || std::string(id, 4) != "WAVE") {
+
+		std::cerr << "ERROR: " << fileName << " is not a wave file and cannot be streamed." << std::endl;
+		return;
+	}
+
+	unsigned int audioFormat = 0, channels = 0, rate = 0, bitsPerSample = 0;
+	bool foundFormat = false;
+
+	// Walk the chunks until the samples are found. The format chunk always comes first.
+	while (file.read(id, 4) && readLittleEndian(file, 4, size)) {
+
+		std::string chunkID(id, 4);
+
+		if (chunkID == "fmt " && size >= 16) {
+
+			unsigned int byteRate, blockSize;
+
+			readLittleEndian(file, 2, audioFormat);
+			readLittleEndian(file, 2, channels);
+			readLittleEndian(file, 4, rate);
+			readLittleEndian(file, 4, byteRate);
+			readLittleEndian(file, 2, blockSize);
+			readLittleEndian(file, 2, bitsPerSample);
+
+			file.seekg((size - 16) + (size & 1), std::ios::cur);
+			foundFormat = true;
+		}
+		else if (chunkID == "data" && foundFormat) {
+
+			dataStart = file.tellg();
+			dataSize = size;
+			break;
+		}
+		else {
+
+			// Chunks are padded to an even number of bytes
+			file.seekg(size + (size & 1), std::ios::cur);
+		}
+	}
+
+	// Only uncompressed 8 and 16 bit mono and stereo samples can be passed straight to OpenAL
+	if (audioFormat != 1 || (channels != 1 && channels != 2) ||
+		(bitsPerSample != 8 && bitsPerSample != 16) || dataSize == 0) {
+
+		std::cerr << "ERROR: " << fileName << " is not an 8 or 16 bit PCM wave file and cannot be streamed." << std::endl;
+		return;
+	}
+
+	if (channels == 1) {
+		format = bitsPerSample == 8 ? AL_FORMAT_MONO8 : AL_FORMAT_MONO16;
+	}
+	else {
+		format = bitsPerSample == 8 ? AL_FORMAT_STEREO8 : AL_FORMAT_STEREO16;
+	}
+	sampleRate = static_cast<ALsizei>(rate);
+	blockAlign = static_cast<int>(channels * bitsPerSample / 8);
+
+	alGenBuffers(NUM_BUFFERS, buffers);
+	SoundEngine::check_al_errors();
+
+	for (int i = 0; i < NUM_BUFFERS; i++) {
+		freeBuffers[i] = buffers[i];
+	}
+	numFreeBuffers = NUM_BUFFERS;
+
+	streams.push_back(this);
+	valid = true;
+
+	if (VERBOSE) cout << "Streaming " << fileName << ": " << dataSize << " bytes, "
+					  << channels << " channels, " << rate << " Hz" << endl;
+
+} // end constructor
+
+
+SoundStream::~SoundStream()
+{
+	if (!valid) {
+		return;
+	}
+
+	setActive(false);
+
+	// The buffers are already gone if the sound engine has stopped
+	if (!buffersDeleted) {
+
+		stop();
+		alDeleteBuffers(NUM_BUFFERS, buffers);
+	}
+
+	streams.erase(std::remove(streams.begin(), streams.end(), this), streams.end());
+
+} // end destructor
+
+
+void SoundStream::play(ALuint source, float offset)
+{
+	if (!valid || buffersDeleted) {
+		return;
+	}
+
+	stop();
+
+	// Start reading at the first whole sample at or after the offset
+	std::streamoff offsetBytes = static_cast<std::streamoff>(offset * sampleRate) * blockAlign;
+
+	if (offsetBytes > 0 && offsetBytes < dataSize) {
+
+		dataPosition = offsetBytes;
+		file.seekg(dataStart + offsetBytes);
+	}
+
+	this->source = source;
+	playing = true;
+	setActive(true);
+
+} // end play
+
+
+void SoundStream::stop()
+{
+	if (!valid || buffersDeleted) {
+		return;
+	}
+
+	// Once inactive the background thread no longer touches the ring or the file
+	setActive(false);
+
+	// Detaching the buffers from a stopped source unqueues all of them
+	if (playing) {
+
+		alSourceStop(source);
+		alSourcei(source, AL_BUFFER, 0);
+		SoundEngine::check_al_errors();
+	}
+
+	for (int i = 0; i < NUM_BUFFERS; i++) {
+		freeBuffers[i] = buffers[i];
+	}
+	numFreeBuffers = NUM_BUFFERS;
+
+	filledChunks = 0;
+	writeChunk = 0;
+	readChunk = 0;
+	endOfData = false;
+
+	dataPosition = 0;
+	file.clear();
+	file.seekg(dataStart);
+
+	playing = false;
+
+} // end stop
+
+
+float SoundStream::getDuration() const
+{
+	if (!valid) {
+		return 0.0f;
+	}
+
+	return static_cast<float>(dataSize / blockAlign) / sampleRate;
+
+} // end getDuration
+
+
+void SoundStream::setActive(bool active)
+{
+	if (this->active == active) {
+		return;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(streamMutex);
+
+		listed = active;
+
+		if (active) {
+
+			activeStreams.push_back(this);
+
+			// The thread is started the first time anything is streamed
+			if (!readerThread.joinable()) {
+
+				quitReader = false;
+				readerThread = std::thread(&SoundStream::readerLoop);
+			}
+		}
+		else {
+
+			activeStreams.erase(std::remove(activeStreams.begin(), activeStreams.end(), this), activeStreams.end());
+
+			// The ring and the file are the caller's once the current read ends
+			readFinished.wait(lock, [this] { return !beingRead; });
+		}
+	}
+
+	this->active = active;
+
+	if (active) {
+		streamWork.notify_one();
+	}
+
+} // end setActive
+
+
+void SoundStream::update()
+{
+	ALint processed = 0;
+	alGetSourcei(source, AL_BUFFERS_PROCESSED, &processed);
+
+	// Buffers that have finished playing can be refilled
+	if (processed > 0) {
+
+		alSourceUnqueueBuffers(source, processed, freeBuffers + numFreeBuffers);
+		numFreeBuffers += processed;
+	}
+
+	bool queuedChunks = false;
+
+	while (numFreeBuffers > 0 && filledChunks.load(std::memory_order_acquire) > 0) {
+
+		ALuint buffer = freeBuffers[--numFreeBuffers];
+
+		alBufferData(buffer, format, chunks[readChunk], chunkSizes[readChunk], sampleRate);
+		alSourceQueueBuffers(source, 1, &buffer);
+
+		readChunk = (readChunk + 1) % NUM_CHUNKS;
+		filledChunks.fetch_sub(1, std::memory_order_release);
+		queuedChunks = true;
+	}
+
+	// Room has been made in the ring for the background thread
+	if (queuedChunks) {
+		streamWork.notify_one();
+	}
+
+	SoundEngine::check_al_errors();
+
+	ALint state = AL_STOPPED;
+	alGetSourcei(source, AL_SOURCE_STATE, &state);
+
+	if (numFreeBuffers < NUM_BUFFERS) {
+
+		// Starts the source the first time. Also restarts it if it ran out of
+		// queued buffers before the file could be read.
+		if (state != AL_PLAYING && state != AL_PAUSED) {
+
+			alSourcePlay(source);
+			SoundEngine::check_al_errors();
+		}
+	}
+	else if (endOfData && filledChunks.load(std::memory_order_acquire) == 0) {
+
+		// Everything has been read and heard
+		setActive(false);
+		playing = false;
+	}
+
+} // end update
+
+
+bool SoundStream::fillChunk()
+{
+	if (filledChunks.load(std::memory_order_acquire) == NUM_CHUNKS || endOfData) {
+		return false;
+	}
+
+	if (dataPosition >= dataSize) {
+
+		if (!looping) {
+
+			endOfData = true;
+			return false;
+		}
+
+		// Start over at the first sample
+		dataPosition = 0;
+		file.clear();
+		file.seekg(dataStart);
+	}
+
+	std::streamoff bytesToRead = std::min<std::streamoff>(CHUNK_SIZE, dataSize - dataPosition);
+
+	file.read(chunks[writeChunk], bytesToRead);
+	std::streamoff bytesRead = file.gcount();
+
+	if (bytesRead <= 0) {
+
+		// The file is shorter than its header claims. Treat this as the end.
+		dataSize = dataPosition;
+		return false;
+	}
+
+	chunkSizes[writeChunk] = static_cast<int>(bytesRead);
+	dataPosition += bytesRead;
+
+	writeChunk = (writeChunk + 1) % NUM_CHUNKS;
+	filledChunks.fetch_add(1, std::memory_order_release);
+
+	return true;
+
+} // end fillChunk
+
+
+void SoundStream::readerLoop()
+{
+	std::vector<SoundStream*> streamsToRead;
+
+	std::unique_lock<std::mutex> lock(streamMutex);
+
+	while (!quitReader) {
+
+		streamsToRead = activeStreams;
+
+		for (SoundStream* stream : streamsToRead) {
+
+			// Skip streams that were stopped since the list was copied
+			if (!stream->listed) {
+				continue;
+			}
+
+			// The file is read without the lock. Stopping this stream waits until
+			// the read is done. Everything else carries on.
+			stream->beingRead = true;
+			lock.unlock();
+
+			while (stream->fillChunk());
+
+			lock.lock();
+			stream->beingRead = false;
+			readFinished.notify_all();
+		}
+
+		// Woken when the audio thread queues chunks. The timeout is a fallback.
+		streamWork.wait_for(lock, std::chrono::milliseconds(50));
+	}
+
+} // end readerLoop
+
+
+void SoundStream::UpdateStreams()
+{
+	for (SoundStream* stream : streams) {
+
+		if (stream->playing) {
+			stream->update();
+		}
+	}
+
+} // end UpdateStreams
+
+
+void SoundStream::StopStreaming()
+{
+	if (readerThread.joinable()) {
+
+		{
+			std::lock_guard<std::mutex> lock(streamMutex);
+			quitReader = true;
+
+			for (SoundStream* stream : activeStreams) {
+				stream->listed = false;
+			}
+			activeStreams.clear();
+		}
+		streamWork.notify_one();
+
+		readerThread.join();
+	}
+
+	// Buffers must be deleted while the context still exists
+	for (SoundStream* stream : streams) {
+
+		if (stream->playing) {
+
+			alSourceStop(stream->source);
+			alSourcei(stream->source, AL_BUFFER, 0);
+		}
+		alDeleteBuffers(NUM_BUFFERS, stream->buffers);
+
+		stream->buffersDeleted = true;
+		stream->active = false;
+		stream->playing = false;
+	}
+
+	SoundEngine::check_al_errors();
+
+} // end StopStreaming
@@ -0,0 +1,227 @@
+#pragma once
+
+#include <string>
+#include <fstream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "SoundEngine.h"
+
+/**
+ * @class	SoundStream
+ *
+ * @brief	Plays a long PCM wave file through an OpenAL source without loading
+ * 			the whole file. A shared background thread reads the file in small
+ * 			chunks into a ring of staging memory. The sound engine's audio
+ * 			thread copies the chunks into a small ring of OpenAL buffers that
+ * 			are queued on the source as earlier buffers finish playing. Each stream holds
+ * 			NUM_CHUNKS chunks of CHUNK_SIZE bytes in staging memory and NUM_BUFFERS
+ * 			chunks in OpenAL buffers.
+ *
+ * 			The file is read without holding the lock that guards the list of
+ * 			active streams, so the audio thread never waits for the disk to
+ * 			queue chunks or to start other streams. Stopping a stream only waits
+ * 			if that stream is being read at the time.
+ */
+class SoundStream
+{
+public:
+
+	/** @brief	Number of OpenAL buffers queued on the source. */
+	static const int NUM_BUFFERS = 4;
+
+	/** @brief	Number of chunks in the staging ring. Covers slow reads of the file. */
+	static const int NUM_CHUNKS = 16;
+
+	/** @brief	Size in bytes of each chunk. A multiple of every PCM block size. */
+	static const int CHUNK_SIZE = 8192;
+
+	/**
+	 * @fn	SoundStream::SoundStream(const std::string& fileName);
+	 *
+	 * @brief	Constructor. Reads the header of the wave file.
+	 *
+	 * @param	fileName	Name of an uncompressed 8 or 16 bit PCM wave file.
+	 */
+	SoundStream(const std::string& fileName);
+
+	/**
+	 * @fn	SoundStream::~SoundStream();
+	 *
+	 * @brief	Destructor. Stops the stream and deletes its OpenAL buffers.
+	 */
+	~SoundStream();
+
+	/**
+	 * @fn	bool SoundStream::isValid() const
+	 *
+	 * @brief	Query if the file was opened and has a supported format.
+	 *
+	 * @returns	True if valid, false if not.
+	 */
+	bool isValid() const { return valid; }
+
+	/**
+	 * @fn	void SoundStream::play(ALuint source, float offset = 0.0f);
+	 *
+	 * @brief	Starts playing through a source. The source starts once the first
+	 * 			chunk has been read.
+	 *
+	 * @param	source	The OpenAL source the stream is played through.
+	 * @param	offset	(Optional) Playback position in seconds to start from.
+	 */
+	void play(ALuint source, float offset = 0.0f);
+
+	/**
+	 * @fn	void SoundStream::stop();
+	 *
+	 * @brief	Stops playing, detaches the buffers from the source, and rewinds to the
+	 * 			beginning of the file.
+	 */
+	void stop();
+
+	/**
+	 * @fn	float SoundStream::getDuration() const
+	 *
+	 * @brief	Gets the length of the file.
+	 *
+	 * @returns	The duration in seconds.
+	 */
+	float getDuration() const;
+
+	/**
+	 * @fn	bool SoundStream::isPlaying() const
+	 *
+	 * @brief	Query if the stream is playing or paused. A stream is playing from
+	 * 			the time play is called until the end of the file has been heard.
+	 *
+	 * @returns	True if playing, false if not.
+	 */
+	bool isPlaying() const { return playing; }
+
+	/**
+	 * @fn	void SoundStream::setLooping(bool loopingOn);
+	 *
+	 * @brief	Sets whether the stream starts over at the end of the file.
+	 *
+	 * @param	loopingOn	True to loop.
+	 */
+	void setLooping(bool loopingOn) { looping = loopingOn; }
+
+	/**
+	 * @fn	static void SoundStream::UpdateStreams();
+	 *
+	 * @brief	Queues the chunks that have been read on the sources of all playing
+	 * 			streams. Called regularly by the sound engine's audio thread.
+	 */
+	static void UpdateStreams();
+
+	/**
+	 * @fn	static void SoundStream::StopStreaming();
+	 *
+	 * @brief	Stops the background thread and deletes the OpenAL buffers of all
+	 * 			streams. Called when the sound engine stops.
+	 */
+	static void StopStreaming();
+
+protected:
+
+	/**
+	 * @fn	void SoundStream::update();
+	 *
+	 * @brief	Unqueues the buffers the source has finished playing, refills them
+	 * 			with the chunks that have been read, and queues them again.
+	 */
+	void update();
+
+	/**
+	 * @fn	bool SoundStream::fillChunk();
+	 *
+	 * @brief	Called on the background thread. Reads the next chunk of the file if
+	 * 			there is room in the staging ring.
+	 *
+	 * @returns	True if a chunk was read.
+	 */
+	bool fillChunk();
+
+	/**
+	 * @fn	void SoundStream::setActive(bool active);
+	 *
+	 * @brief	Adds the stream to or removes it from the streams serviced by the
+	 * 			background thread. The thread never touches an inactive stream.
+	 */
+	void setActive(bool active);
+
+	/**
+	 * @fn	static void SoundStream::readerLoop();
+	 *
+	 * @brief	Body of the background thread.
+	 */
+	static void readerLoop();
+
+	/** @brief	True if the file was opened and has a supported format. */
+	bool valid = false;
+
+	/** @brief	The wave file and the location and size of its samples. */
+	std::ifstream file;
+	std::streamoff dataStart = 0;
+	std::streamoff dataSize = 0;
+
+	/** @brief	Position within the samples of the next read. Owned by the background thread while active. */
+	std::streamoff dataPosition = 0;
+
+	/** @brief	Sample format and rate for alBufferData. */
+	ALenum format = AL_FORMAT_MONO16;
+	ALsizei sampleRate = 0;
+
+	/** @brief	Bytes in one sample of every channel. */
+	int blockAlign = 0;
+
+	/** @brief	The source and the ring of buffers queued on it. The source is only valid while playing. */
+	ALuint source = 0;
+	ALuint buffers[NUM_BUFFERS];
+	bool buffersDeleted = false;
+
+	/** @brief	Buffers that are not queued on the source. */
+	ALuint freeBuffers[NUM_BUFFERS];
+	int numFreeBuffers = 0;
+
+	/** @brief	Staging ring. Written by the background thread and read on the audio thread. */
+	char chunks[NUM_CHUNKS][CHUNK_SIZE];
+	int chunkSizes[NUM_CHUNKS];
+	std::atomic<int> filledChunks;
+	int writeChunk = 0;
+	int readChunk = 0;
+
+	/** @brief	Set by the background thread when the end of a file that is not looping has been read. */
+	std::atomic<bool> endOfData;
+
+	std::atomic<bool> looping;
+
+	/** @brief	True from play until the end of the file has been heard or stop is called. */
+	bool playing = false;
+
+	bool active = false;
+
+	/** @brief	True while in activeStreams and while being read by the background thread. Guarded by streamMutex. */
+	bool listed = false;
+	bool beingRead = false;
+
+	/** @brief	All streams. Only used on the audio thread. */
+	static std::vector<SoundStream*> streams;
+
+	/** @brief	Streams serviced by the background thread. Guarded by streamMutex. */
+	static std::vector<SoundStream*> activeStreams;
+
+	static std::mutex streamMutex;
+	static std::condition_variable streamWork;
+
+	/** @brief	Signaled each time the background thread finishes reading a stream. */
+	static std::condition_variable readFinished;
+	static std::thread readerThread;
+	static bool quitReader;
+
+}; // end SoundStream class
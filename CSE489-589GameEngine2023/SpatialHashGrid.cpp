@@ -0,0 +1,78 @@
+#include "SpatialHashGrid.h"
+
+#define VERBOSE false
+
+SpatialHashGrid::SpatialHashGrid(float cellSize)
+{
+	setCellSize(cellSize);
+
+} // end constructor
+
+
+void SpatialHashGrid::setCellSize(float cellSize)
+{
+	this->cellSize = glm::max(cellSize, 0.001f);
+	this->inverseCellSize = 1.0f / this->cellSize;
+
+} // end setCellSize
+
+
+void SpatialHashGrid::build(const std::vector<vec3>& positions)
+{
+	int numPoints = static_cast<int>(positions.size());
+
+	// About two buckets per point keeps collisions between cells rare
+	unsigned int numBuckets = 64;
+	while (numBuckets < 2u * static_cast<unsigned int>(numPoints)) {
+		numBuckets *= 2;
+	}
+	bucketMask = numBuckets - 1;
+
+	bucketStart.assign(numBuckets + 1, 0);
+	pointBuckets.resize(numPoints);
+	sortedIds.resize(numPoints);
+	sortedPositions.resize(numPoints);
+
+	// Count the points in each bucket
+	for (int i = 0; i < numPoints; i++) {
+
+		glm::ivec3 cell = getCell(positions[i]);
+		pointBuckets[i] = hashCell(cell.x, cell.y, cell.z);
+		bucketStart[pointBuckets[i] + 1]++;
+	}
+
+	// Convert the counts to the index of the first point of each bucket
+	for (unsigned int b = 0; b < numBuckets; b++) {
+		bucketStart[b + 1] += bucketStart[b];
+	}
+
+	// Scatter the points. Filling each bucket from its end leaves bucketStart
+	// pointing at the first point once every point has been placed.
+	for (int i = numPoints - 1; i >= 0; i--) {
+
+		int index = --bucketStart[pointBuckets[i] + 1];
+		sortedIds[index] = i;
+		sortedPositions[index] = positions[i];
+	}
+
+	// bucketStart[b + 1] now holds the start of bucket b. Shift it into place.
+	for (unsigned int b = 0; b < numBuckets; b++) {
+		bucketStart[b] = bucketStart[b + 1];
+	}
+	bucketStart[numBuckets] = numPoints;
+
+	if (VERBOSE) cout << "Spatial hash grid built with " << numPoints << " points in "
+					  << numBuckets << " buckets." << endl;
+
+} // end build
+
+
+void SpatialHashGrid::query(const vec3& center, float radius, std::vector<int>& results) const
+{
+	forEachInRadius(center, radius, [&results](int id, const vec3& position) {
+
+		results.push_back(id);
+		return true;
+	});
+
+} // end query
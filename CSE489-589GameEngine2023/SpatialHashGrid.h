@@ -0,0 +1,174 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include "MathLibsConstsFuncs.h"
+
+using namespace constants_and_types;
+
+/**
+ * @class	SpatialHashGrid
+ *
+ * @brief	Uniform grid of cubic cells over an unbounded world. Cells are
+ * 			hashed into a fixed number of buckets, so memory only depends on the
+ * 			number of points stored. The grid is rebuilt from scratch with a
+ * 			counting sort. Points that share a bucket end up next to each other
+ * 			in memory, and a radius query only reads the buckets of the cells
+ * 			that overlap the query sphere.
+ */
+class SpatialHashGrid
+{
+public:
+
+	/**
+	 * @fn	SpatialHashGrid::SpatialHashGrid(float cellSize = 10.0f);
+	 *
+	 * @brief	Constructor
+	 *
+	 * @param	cellSize	(Optional) Edge length of the cells. Queries are fastest
+	 * 						when the query radius is close to the cell size.
+	 */
+	SpatialHashGrid(float cellSize = 10.0f);
+
+	/**
+	 * @fn	void SpatialHashGrid::setCellSize(float cellSize);
+	 *
+	 * @brief	Sets the edge length of the cells. Takes effect on the next build.
+	 *
+	 * @param	cellSize	Edge length of the cells.
+	 */
+	void setCellSize(float cellSize);
+
+	float getCellSize() const { return cellSize; }
+
+	/**
+	 * @fn	void SpatialHashGrid::build(const std::vector<vec3>& positions);
+	 *
+	 * @brief	Replaces the contents of the grid. The index of each position in
+	 * 			the vector is the id returned by queries. Memory is reused
+	 * 			between builds.
+	 *
+	 * @param	positions	The positions to store.
+	 */
+	void build(const std::vector<vec3>& positions);
+
+	/**
+	 * @fn	void SpatialHashGrid::query(const vec3& center, float radius, std::vector<int>& results) const;
+	 *
+	 * @brief	Finds the ids of all points within a radius of a position.
+	 *
+	 * @param 		  	center 	Center of the query sphere.
+	 * @param 		  	radius 	Radius of the query sphere.
+	 * @param [in,out]	results	The ids are appended to this vector.
+	 */
+	void query(const vec3& center, float radius, std::vector<int>& results) const;
+
+	/**
+	 * @fn	template<typename Callback> void SpatialHashGrid::forEachInRadius(const vec3& center, float radius, Callback callback) const
+	 *
+	 * @brief	Calls callback(id, position) for every point within a radius of a
+	 * 			position. Returning false from the callback ends the query early.
+	 *
+	 * @param	center  	Center of the query sphere.
+	 * @param	radius  	Radius of the query sphere.
+	 * @param	callback	Called with the id and position of each point.
+	 */
+	template<typename Callback>
+	void forEachInRadius(const vec3& center, float radius, Callback callback) const
+	{
+		if (sortedIds.empty()) {
+			return;
+		}
+
+		float radiusSquared = radius * radius;
+
+		glm::ivec3 minCell = getCell(center - vec3(radius));
+		glm::ivec3 maxCell = getCell(center + vec3(radius));
+		glm::ivec3 cellRange = maxCell - minCell + glm::ivec3(1);
+
+		// Large queries read every point rather than revisiting buckets
+		if (cellRange.x * cellRange.y * cellRange.z > MAX_QUERY_BUCKETS) {
+
+			for (size_t i = 0; i < sortedIds.size(); i++) {
+
+				if (glm::distance2(sortedPositions[i], center) <= radiusSquared &&
+					!callback(sortedIds[i], sortedPositions[i])) {
+					return;
+				}
+			}
+			return;
+		}
+
+		// Different cells can hash to the same bucket. Each bucket is read once.
+		unsigned int visited[MAX_QUERY_BUCKETS];
+		int numVisited = 0;
+
+		for (int z = minCell.z; z <= maxCell.z; z++) {
+			for (int y = minCell.y; y <= maxCell.y; y++) {
+				for (int x = minCell.x; x <= maxCell.x; x++) {
+
+					unsigned int bucket = hashCell(x, y, z);
+
+					if (std::find(visited, visited + numVisited, bucket) != visited + numVisited) {
+						continue;
+					}
+					visited[numVisited++] = bucket;
+
+					for (int i = bucketStart[bucket]; i < bucketStart[bucket + 1]; i++) {
+
+						if (glm::distance2(sortedPositions[i], center) <= radiusSquared &&
+							!callback(sortedIds[i], sortedPositions[i])) {
+							return;
+						}
+					}
+				}
+			}
+		}
+
+	} // end forEachInRadius
+
+protected:
+
+	/** @brief	Queries that overlap more cells than this read every point. */
+	static const int MAX_QUERY_BUCKETS = 64;
+
+	/**
+	 * @fn	glm::ivec3 SpatialHashGrid::getCell(const vec3& position) const
+	 *
+	 * @brief	Gets the integer coordinates of the cell containing a position.
+	 */
+	glm::ivec3 getCell(const vec3& position) const
+	{
+		return glm::ivec3(glm::floor(position * inverseCellSize));
+	}
+
+	/**
+	 * @fn	unsigned int SpatialHashGrid::hashCell(int x, int y, int z) const
+	 *
+	 * @brief	Maps the coordinates of a cell to a bucket.
+	 */
+	unsigned int hashCell(int x, int y, int z) const
+	{
+		return ((static_cast<unsigned int>(x) * 73856093u) ^
+				(static_cast<unsigned int>(y) * 19349663u) ^
+				(static_cast<unsigned int>(z) * 83492791u)) & bucketMask;
+	}
+
+	float cellSize;
+	float inverseCellSize;
+
+	/** @brief	Number of buckets minus one. The number of buckets is a power of two. */
+	unsigned int bucketMask = 0;
+
+	/** @brief	Index of the first point of each bucket. Has one extra entry at the end. */
+	std::vector<int> bucketStart;
+
+	/** @brief	Ids and positions of the points sorted by bucket. */
+	std::vector<int> sortedIds;
+	std::vector<vec3> sortedPositions;
+
+	/** @brief	Bucket of each point in the order they were passed to build. */
+	std::vector<unsigned int> pointBuckets;
+
+}; // end SpatialHashGrid class
@@ -0,0 +1,193 @@
+#include "SplinePath.h"
+
+#include <algorithm>
+
+#include "GameObject.h"
+
+#define VERBOSE false
+
+SplinePath::SplinePath(const std::vector<std::shared_ptr<GameObject>>& waypoints, bool closed, int samplesPerSegment)
+	: closed(closed)
+{
+	// The waypoints are only read once
+	std::vector<vec3> points;
+	points.reserve(waypoints.size());
+
+	for (auto& waypoint : waypoints) {
+		points.push_back(waypoint->getPosition(WORLD));
+	}
+
+	build(points, samplesPerSegment);
+
+} // end constructor
+
+
+SplinePath::SplinePath(const std::vector<vec3>& points, bool closed, int samplesPerSegment)
+	: closed(closed)
+{
+	build(points, samplesPerSegment);
+
+} // end constructor
+
+
+void SplinePath::build(const std::vector<vec3>& points, int samplesPerSegment)
+{
+	int numPoints = static_cast<int>(points.size());
+	int numSegments = closed ? numPoints : numPoints - 1;
+
+	samplesPerSegment = std::max(1, samplesPerSegment);
+
+	samplePositions.clear();
+	sampleDirections.clear();
+
+	if (numPoints < 2) {
+
+		// Nowhere to go. Every distance maps to the single position.
+		samplePositions.push_back(numPoints == 1 ? points[0] : ZERO_V3);
+		sampleDirections.push_back(FORWARD);
+		length = 0.0f;
+		return;
+	}
+
+	// Measure the spline with evenly spaced parameter values
+	int numSamples = numSegments * samplesPerSegment + 1;
+
+	std::vector<float> parameterDistances(numSamples);
+	vec3 tangent;
+	vec3 previous = evaluate(points, 0.0f, tangent);
+	parameterDistances[0] = 0.0f;
+
+	for (int j = 1; j < numSamples; j++) {
+
+		vec3 position = evaluate(points, static_cast<float>(j) / samplesPerSegment, tangent);
+		parameterDistances[j] = parameterDistances[j - 1] + glm::distance(previous, position);
+		previous = position;
+	}
+
+	length = parameterDistances.back();
+
+	if (length <= 0.0f) {
+
+		samplePositions.push_back(points[0]);
+		sampleDirections.push_back(FORWARD);
+		return;
+	}
+
+	// Resample at equal distances so lookups by distance need no search
+	sampleSpacing = length / (numSamples - 1);
+	inverseSampleSpacing = 1.0f / sampleSpacing;
+
+	samplePositions.resize(numSamples);
+	sampleDirections.resize(numSamples);
+
+	int j = 0;
+	for (int k = 0; k < numSamples; k++) {
+
+		float distance = std::min(k * sampleSpacing, length);
+
+		while (j < numSamples - 2 && parameterDistances[j + 1] < distance) {
+			j++;
+		}
+
+		float span = parameterDistances[j + 1] - parameterDistances[j];
+		float fraction = (span > 0.0f) ? (distance - parameterDistances[j]) / span : 0.0f;
+
+		samplePositions[k] = evaluate(points, (j + fraction) / samplesPerSegment, tangent);
+
+		// The tangent vanishes where consecutive points coincide
+		if (glm::length(tangent) > 0.0f) {
+			sampleDirections[k] = glm::normalize(tangent);
+		}
+		else {
+			sampleDirections[k] = (k > 0) ? sampleDirections[k - 1] : FORWARD;
+		}
+	}
+
+	if (VERBOSE) cout << "Spline path of length " << length << " with " << numSamples << " samples" << endl;
+
+} // end build
+
+
+vec3 SplinePath::evaluate(const std::vector<vec3>& points, float t, vec3& tangent) const
+{
+	int numPoints = static_cast<int>(points.size());
+	int numSegments = closed ? numPoints : numPoints - 1;
+
+	int segment = glm::clamp(static_cast<int>(floor(t)), 0, numSegments - 1);
+	float u = t - segment;
+
+	// Neighbouring points wrap around closed paths and repeat the end points of open ones
+	auto point = [&](int i) -> const vec3& {
+
+		if (closed) {
+			return points[(i + numPoints) % numPoints];
+		}
+		return points[glm::clamp(i, 0, numPoints - 1)];
+	};
+
+	const vec3& p0 = point(segment - 1);
+	const vec3& p1 = point(segment);
+	const vec3& p2 = point(segment + 1);
+	const vec3& p3 = point(segment + 2);
+
+	// Uniform Catmull-Rom coefficients
+	vec3 a = 2.0f * p1;
+	vec3 b = p2 - p0;
+	vec3 c = 2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3;
+	vec3 d = -p0 + 3.0f * p1 - 3.0f * p2 + p3;
+
+	tangent = 0.5f * (b + 2.0f * c * u + 3.0f * d * u * u);
+
+	return 0.5f * (a + b * u + c * u * u + d * u * u * u);
+
+} // end evaluate
+
+
+float SplinePath::wrapDistance(float distance) const
+{
+	if (length <= 0.0f) {
+		return 0.0f;
+	}
+
+	if (closed) {
+
+		distance = fmod(distance, length);
+		return (distance < 0.0f) ? distance + length : distance;
+	}
+
+	return glm::clamp(distance, 0.0f, length);
+
+} // end wrapDistance
+
+
+void SplinePath::sample(float distance, vec3& position, vec3& direction) const
+{
+	if (samplePositions.size() < 2) {
+
+		position = samplePositions[0];
+		direction = sampleDirections[0];
+		return;
+	}
+
+	float x = wrapDistance(distance) * inverseSampleSpacing;
+	int i = std::min(static_cast<int>(x), static_cast<int>(samplePositions.size()) - 2);
+	float fraction = x - i;
+
+	position = glm::mix(samplePositions[i], samplePositions[i + 1], fraction);
+	direction = glm::mix(sampleDirections[i], sampleDirections[i + 1], fraction);
+
+	// Opposite directions on either side of a cusp can cancel out
+	float directionLength = glm::length(direction);
+	direction = (directionLength > 0.0f) ? direction / directionLength : sampleDirections[i];
+
+} // end sample
+
+
+vec3 SplinePath::getPosition(float distance) const
+{
+	vec3 position, direction;
+	sample(distance, position, direction);
+
+	return position;
+
+} // end getPosition
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include "MathLibsConstsFuncs.h"
+
+using namespace constants_and_types;
+
+class GameObject;
+
+/**
+ * @class	SplinePath
+ *
+ * @brief	Smooth path through a sequence of waypoints. A Catmull-Rom spline is
+ * 			fitted through the World positions of the waypoints when the path is
+ * 			built and then resampled at equal arc length intervals. Positions and
+ * 			directions along the path are looked up by distance in constant time
+ * 			by interpolating between the two nearest samples. The waypoints are
+ * 			not read again, so a path can be shared by any number of movers.
+ */
+class SplinePath
+{
+public:
+
+	/**
+	 * @fn	SplinePath::SplinePath(const std::vector<std::shared_ptr<GameObject>>& waypoints, bool closed = true, int samplesPerSegment = 32);
+	 *
+	 * @brief	Builds a path through the World positions of the waypoints.
+	 *
+	 * @param	waypoints		 	The waypoints. They must already be in the scene graph.
+	 * @param	closed			 	(Optional) True to join the last waypoint back to the first.
+	 * @param	samplesPerSegment	(Optional) Number of samples between each pair of waypoints.
+	 */
+	SplinePath(const std::vector<std::shared_ptr<GameObject>>& waypoints, bool closed = true, int samplesPerSegment = 32);
+
+	/**
+	 * @fn	SplinePath::SplinePath(const std::vector<vec3>& points, bool closed = true, int samplesPerSegment = 32);
+	 *
+	 * @brief	Builds a path through a list of positions.
+	 *
+	 * @param	points			 	The positions the path passes through.
+	 * @param	closed			 	(Optional) True to join the last position back to the first.
+	 * @param	samplesPerSegment	(Optional) Number of samples between each pair of positions.
+	 */
+	SplinePath(const std::vector<vec3>& points, bool closed = true, int samplesPerSegment = 32);
+
+	/**
+	 * @fn	void SplinePath::sample(float distance, vec3& position, vec3& direction) const;
+	 *
+	 * @brief	Gets the position and direction of travel at a distance along the
+	 * 			path. Distances past the end wrap around closed paths and are
+	 * 			clamped to the ends of open paths.
+	 *
+	 * @param 	   	distance 	Distance along the path.
+	 * @param [out]	position 	The position.
+	 * @param [out]	direction	Unit length direction of travel.
+	 */
+	void sample(float distance, vec3& position, vec3& direction) const;
+
+	/**
+	 * @fn	vec3 SplinePath::getPosition(float distance) const;
+	 *
+	 * @brief	Gets the position at a distance along the path.
+	 */
+	vec3 getPosition(float distance) const;
+
+	/**
+	 * @fn	float SplinePath::wrapDistance(float distance) const;
+	 *
+	 * @brief	Maps a distance onto the path. Wraps around closed paths and clamps
+	 * 			to the ends of open paths.
+	 */
+	float wrapDistance(float distance) const;
+
+	float getLength() const { return length; }
+
+	bool isClosed() const { return closed; }
+
+protected:
+
+	/**
+	 * @fn	void SplinePath::build(const std::vector<vec3>& points, int samplesPerSegment);
+	 *
+	 * @brief	Fits the spline and fills the table of equally spaced samples.
+	 */
+	void build(const std::vector<vec3>& points, int samplesPerSegment);
+
+	/**
+	 * @fn	vec3 SplinePath::evaluate(const std::vector<vec3>& points, float t, vec3& tangent) const;
+	 *
+	 * @brief	Evaluates the spline. The integer part of t selects the segment
+	 * 			and the fractional part is the position within it.
+	 *
+	 * @param 	   	points 	The points the spline passes through.
+	 * @param 	   	t	   	The spline parameter.
+	 * @param [out]	tangent	Derivative of the spline with respect to t.
+	 *
+	 * @returns	The position on the spline.
+	 */
+	vec3 evaluate(const std::vector<vec3>& points, float t, vec3& tangent) const;
+
+	bool closed;
+
+	/** @brief	Total length of the path. */
+	float length = 0.0f;
+
+	/** @brief	Distance between samples and its reciprocal. */
+	float sampleSpacing = 1.0f;
+	float inverseSampleSpacing = 1.0f;
+
+	/** @brief	Positions and unit directions at equally spaced distances along the path. */
+	std::vector<vec3> samplePositions;
+	std::vector<vec3> sampleDirections;
+
+}; // end SplinePath class
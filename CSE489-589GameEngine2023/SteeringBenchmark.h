@@ -0,0 +1,125 @@
+#pragma once
+
+#include "GameEngine.h"
+
+/**
+ * @class	SteeringBenchmark
+ *
+ * @brief	Scene with thousands of craft flying a loop of waypoints with
+ * 			SteeringComponents. Reports the average time the SteeringEngine
+ * 			spends steering them and writing their transforms.
+ */
+class SteeringBenchmark : public Game
+{
+public:
+
+	/**
+	 * @fn	SteeringBenchmark::SteeringBenchmark(int numFollowers = 5000)
+	 *
+	 * @brief	Constructor
+	 *
+	 * @param	numFollowers	(Optional) Number of craft following the waypoints.
+	 */
+	SteeringBenchmark(int numFollowers = 5000)
+		: numFollowers(numFollowers)
+	{
+	}
+
+protected:
+
+	/** @brief	Number of craft following the waypoints. */
+	int numFollowers;
+
+	/** @brief	Steering times accumulated since the last report. */
+	double accumulatedSteeringTime = 0.0;
+	int accumulatedUpdates = 0;
+	unsigned long long lastUpdateCount = 0;
+
+	void loadScene() override
+	{
+		glfwSetWindowTitle(renderWindow, "Steering Benchmark");
+
+		glClearColor(0.5f, 0.5f, 0.5f, 1.0f);
+
+		ShaderInfo shaders[] = {
+			{ GL_VERTEX_SHADER, "Shaders/vertexShader.glsl" },
+			{ GL_FRAGMENT_SHADER, "Shaders/fragmentShader.glsl" },
+			{ GL_NONE, NULL } // signals that there are no more shaders
+		};
+
+		GLuint shaderProgram = BuildShaderProgram(shaders);
+
+		SharedMaterials::setUniformBlockForShader(shaderProgram);
+		SharedTransformations::setUniformBlockForShader(shaderProgram);
+		SharedLighting::setUniformBlockForShader(shaderProgram);
+		SharedFog::setUniformBlockForShader(shaderProgram);
+
+		// ***** Light *****
+		auto lightObject = std::make_shared<GameObject>();
+		addChildGameObject(lightObject);
+		lightObject->addComponent(std::make_shared<DirectionalLightComponent>(GLFW_KEY_D));
+		lightObject->rotateTo(vec3(-1.0f, -1.0f, -1.0f));
+
+		// ***** Waypoints *****
+		std::vector<std::shared_ptr<GameObject>> waypoints;
+		for (vec3 position : { vec3(-100.0f, 0.0f, -100.0f), vec3(100.0f, 20.0f, -100.0f),
+							   vec3(100.0f, 0.0f, 100.0f), vec3(-100.0f, -20.0f, 100.0f) }) {
+
+			auto waypointObject = std::make_shared<GameObject>();
+			addChildGameObject(waypointObject);
+			waypointObject->setPosition(position, LOCAL);
+			waypoints.push_back(waypointObject);
+		}
+
+		// ***** Craft *****
+		// A single material lets every craft share one cached mesh
+		Material craftMat;
+		craftMat.setAmbientAndDiffuseMat(LIGHT_BLUE_RGBA);
+
+		srand(1);
+
+		for (int i = 0; i < numFollowers; i++) {
+
+			auto craftObject = std::make_shared<GameObject>();
+			addChildGameObject(craftObject);
+			craftObject->setPosition(vec3(rand() % 200 - 100.0f, rand() % 40 - 20.0f, rand() % 200 - 100.0f), LOCAL);
+
+			craftObject->addComponent(std::make_shared<BoxMeshComponent>(shaderProgram, craftMat, 1.0f, 0.25f, 2.0f));
+			craftObject->addComponent(std::make_shared<SteeringComponent>(waypoints, vec3(10.0f + rand() % 20, 0.0f, 0.0f)));
+		}
+
+		// ***** Camera *****
+		auto cameraObject = std::make_shared<GameObject>();
+		addChildGameObject(cameraObject);
+		cameraObject->setPosition(vec3(0.0f, 150.0f, 250.0f), LOCAL);
+		cameraObject->rotateTo(vec3(0.0f, -150.0f, -250.0f));
+		cameraObject->addComponent(std::make_shared<CameraComponent>());
+
+		cout << "Steering benchmark: " << numFollowers << " followers" << endl;
+
+	} // end loadScene
+
+	void updateGame() override
+	{
+		Game::updateGame();
+
+		if (SteeringEngine::GetUpdateCount() != lastUpdateCount) {
+
+			lastUpdateCount = SteeringEngine::GetUpdateCount();
+			accumulatedSteeringTime += SteeringEngine::GetLastUpdateTime();
+			accumulatedUpdates++;
+		}
+
+		// Report the average every few seconds
+		if (accumulatedUpdates == 300) {
+
+			cout << "Average steering update: " << 1000000.0 * accumulatedSteeringTime / accumulatedUpdates
+				 << " microseconds" << endl;
+
+			accumulatedSteeringTime = 0.0;
+			accumulatedUpdates = 0;
+		}
+
+	} // end updateGame
+
+}; // end SteeringBenchmark class
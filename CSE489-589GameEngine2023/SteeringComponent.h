@@ -1,15 +1,40 @@
 #pragma once
 #include "WaypointComponent.h"
 
+/**
+ * @class	SteeringComponent
+ *
+ * @brief	Flies the owning game object through a loop of waypoints, banking
+ * 			into turns. The steering itself is done by the SteeringEngine, which
+ * 			updates all steering components together in SIMD batches.
+ */
 class SteeringComponent : public WaypointComponent
 {
 public:
+
+	friend class SteeringEngine;
+
 	SteeringComponent(std::vector<std::shared_ptr<class GameObject>> waypoints, vec3 velocity = vec3(20, 0, 0));
 
-	virtual void update(const float& deltaTime) override;
+	/**
+	 * @fn	virtual SteeringComponent::~SteeringComponent();
+	 *
+	 * @brief	Destructor. Removes the component from the SteeringEngine.
+	 */
+	virtual ~SteeringComponent();
 
-	float currentRoll = 0;
+	virtual void initialize() override;
 
-}; // end SteeringComponent class
+	/**
+	 * @fn	virtual void SteeringComponent::update(const float& deltaTime) override;
+	 *
+	 * @brief	Does nothing. The SteeringEngine moves the owning game object.
+	 */
+	virtual void update(const float& deltaTime) override;
+
+protected:
 
+	/** @brief	Index of the component in the arrays of the SteeringEngine. Negative if not added. */
+	int followerIndex = -1;
 
+}; // end SteeringComponent class
@@ -0,0 +1,531 @@
+#include "SteeringEngine.h"
+
+#include <chrono>
+#include <cmath>
+
+#include "FlockingComponent.h"
+#include "SteeringComponent.h"
+
+#define VERBOSE false
+
+// SSE2 is part of every x64 processor
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define STEERING_SSE2
+#include <emmintrin.h>
+#endif
+
+// ***** Definition of static members of the SteeringEngine class *****
+std::vector<FlockingComponent*> SteeringEngine::agents;
+
+std::vector<vec3> SteeringEngine::agentPositions;
+
+std::vector<vec3> SteeringEngine::agentVelocities;
+
+SpatialHashGrid SteeringEngine::grid;
+
+std::vector<SteeringComponent*> SteeringEngine::followers;
+
+SteeringEngine::FollowerArrays SteeringEngine::followerArrays;
+
+double SteeringEngine::lastUpdateTime = 0.0;
+
+unsigned long long SteeringEngine::updateCount = 0;
+
+// ********************************************************************
+
+// Polynomial approximations used to steer the followers. The scalar and SSE2
+// versions give the same results so that every follower is steered alike.
+
+// Largest error is about 2e-4 radians
+static inline float approxAtan2(float y, float x)
+{
+	float absX = fabs(x);
+	float absY = fabs(y);
+	float maxXY = glm::max(absX, absY);
+
+	float a = (maxXY > 0.0f) ? glm::min(absX, absY) / maxXY : 0.0f;
+	float s = a * a;
+	float r = ((-0.0464964749f * s + 0.15931422f) * s - 0.327622764f) * s * a + a;
+
+	if (absY > absX) {
+		r = PI_OVER_2 - r;
+	}
+	if (x < 0.0f) {
+		r = PI - r;
+	}
+	return std::copysign(r, y);
+}
+
+// Valid for angles between -PI and PI. Largest error is about 4e-6.
+static inline float approxSin(float x)
+{
+	// Reflect into [-PI/2, PI/2] where the series converges quickly
+	if (x > PI_OVER_2) {
+		x = PI - x;
+	}
+	else if (x < -PI_OVER_2) {
+		x = -PI - x;
+	}
+
+	float s = x * x;
+	return x * (1.0f + s * (-1.0f / 6.0f + s * (1.0f / 120.0f + s * (-1.0f / 5040.0f + s * (1.0f / 362880.0f)))));
+}
+
+// Valid for angles between -PI and PI
+static inline float approxCos(float x)
+{
+	x += PI_OVER_2;
+	if (x > PI) {
+		x -= TWO_PI;
+	}
+	return approxSin(x);
+}
+
+#ifdef STEERING_SSE2
+
+// Picks a where the mask is set and b elsewhere
+static inline __m128 select(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128 approxAtan2(__m128 y, __m128 x)
+{
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+
+	__m128 absX = _mm_andnot_ps(signMask, x);
+	__m128 absY = _mm_andnot_ps(signMask, y);
+	__m128 maxXY = _mm_max_ps(absX, absY);
+
+	// Zero where x and y are both zero
+	__m128 a = _mm_and_ps(_mm_div_ps(_mm_min_ps(absX, absY), maxXY), _mm_cmpgt_ps(maxXY, _mm_setzero_ps()));
+	__m128 s = _mm_mul_ps(a, a);
+
+	__m128 r = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-0.0464964749f), s), _mm_set1_ps(0.15931422f));
+	r = _mm_sub_ps(_mm_mul_ps(r, s), _mm_set1_ps(0.327622764f));
+	r = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(r, s), a), a);
+
+	r = select(_mm_cmpgt_ps(absY, absX), _mm_sub_ps(_mm_set1_ps(PI_OVER_2), r), r);
+	r = select(_mm_cmplt_ps(x, _mm_setzero_ps()), _mm_sub_ps(_mm_set1_ps(PI), r), r);
+
+	// r is positive. Give it the sign of y.
+	return _mm_or_ps(r, _mm_and_ps(y, signMask));
+}
+
+static inline __m128 approxSin(__m128 x)
+{
+	const __m128 halfPi = _mm_set1_ps(PI_OVER_2);
+	const __m128 negHalfPi = _mm_set1_ps(-PI_OVER_2);
+
+	x = select(_mm_cmpgt_ps(x, halfPi), _mm_sub_ps(_mm_set1_ps(PI), x), x);
+	x = select(_mm_cmplt_ps(x, negHalfPi), _mm_sub_ps(_mm_set1_ps(-PI), x), x);
+
+	__m128 s = _mm_mul_ps(x, x);
+
+	__m128 r = _mm_add_ps(_mm_mul_ps(s, _mm_set1_ps(1.0f / 362880.0f)), _mm_set1_ps(-1.0f / 5040.0f));
+	r = _mm_add_ps(_mm_mul_ps(s, r), _mm_set1_ps(1.0f / 120.0f));
+	r = _mm_add_ps(_mm_mul_ps(s, r), _mm_set1_ps(-1.0f / 6.0f));
+	r = _mm_add_ps(_mm_mul_ps(s, r), _mm_set1_ps(1.0f));
+
+	return _mm_mul_ps(x, r);
+}
+
+static inline __m128 approxCos(__m128 x)
+{
+	x = _mm_add_ps(x, _mm_set1_ps(PI_OVER_2));
+	x = select(_mm_cmpgt_ps(x, _mm_set1_ps(PI)), _mm_sub_ps(x, _mm_set1_ps(TWO_PI)), x);
+
+	return approxSin(x);
+}
+
+#endif // STEERING_SSE2
+
+
+void SteeringEngine::FollowerArrays::resize(size_t size)
+{
+	for (std::vector<float>* array : { &positionX, &positionY, &positionZ, &targetX, &targetY, &targetZ,
+									   &yaw, &pitch, &roll, &speed, &timeStep,
+									   &sinYaw, &cosYaw, &sinPitch, &cosPitch, &sinRoll, &cosRoll }) {
+		array->resize(size);
+	}
+
+} // end resize
+
+
+void SteeringEngine::Update(const float& deltaTime)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	UpdateAgents();
+
+	UpdateFollowers(deltaTime);
+
+	lastUpdateTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	updateCount++;
+
+	if (VERBOSE) cout << "SteeringEngine updated " << agents.size() << " agents and " << followers.size()
+					  << " followers in " << 1000.0 * lastUpdateTime << " ms" << endl;
+
+} // end Update
+
+
+void SteeringEngine::UpdateAgents()
+{
+	// Close the gaps left by removed agents
+	size_t numAgents = 0;
+	float cellSize = 0.0f;
+
+	for (size_t i = 0; i < agents.size(); i++) {
+
+		FlockingComponent* agent = agents[i];
+
+		if (agent == nullptr) {
+			continue;
+		}
+
+		agent->agentId = static_cast<int>(numAgents);
+		agents[numAgents] = agent;
+
+		// The modeling transformation was updated during the last scene graph
+		// traversal. Its translation is the world position of the agent.
+		agentPositions[numAgents] = getPositionVec3FromTransform(agent->owningGameObject->getModelingTransformation());
+		agentVelocities[numAgents] = agent->getVelocity();
+
+		cellSize = glm::max(cellSize, agent->getNeighborRadius());
+		numAgents++;
+	}
+
+	agents.resize(numAgents);
+	agentPositions.resize(numAgents);
+	agentVelocities.resize(numAgents);
+
+	// A query then only reads the cells next to the one containing the agent
+	if (cellSize > 0.0f) {
+		grid.setCellSize(cellSize);
+	}
+
+	grid.build(agentPositions);
+
+} // end UpdateAgents
+
+
+bool SteeringEngine::IsUpdated(const GameObject* gameObject)
+{
+	for (; gameObject != nullptr; gameObject = gameObject->parent) {
+
+		if (gameObject->getState() != ACTIVE) {
+			return false;
+		}
+	}
+
+	return true;
+
+} // end IsUpdated
+
+
+void SteeringEngine::UpdateFollowers(float deltaTime)
+{
+	int count = static_cast<int>(followers.size());
+
+	FollowerArrays& arrays = followerArrays;
+	arrays.resize(count);
+
+	// Gather the positions and targets. Waypoints are read from their cached
+	// modeling transformations rather than by walking up the scene graph.
+	for (int i = 0; i < count; i++) {
+
+		SteeringComponent* follower = followers[i];
+
+		// Followers that are paused, or below a paused game object, neither turn nor move
+		bool updated = IsUpdated(follower->owningGameObject);
+
+		vec3 position = getPositionVec3FromTransform(follower->owningGameObject->getModelingTransformation());
+		vec3 target = getPositionVec3FromTransform(follower->waypoints[follower->targetWaypointIndex]->getModelingTransformation());
+
+		// Check if next waypoint has been reached
+		float reachDistance = follower->speed * deltaTime * 10.0f;
+		if (updated && glm::distance2(position, target) < reachDistance * reachDistance) {
+
+			follower->targetWaypointIndex = follower->getNexWaypointIndex();
+			target = getPositionVec3FromTransform(follower->waypoints[follower->targetWaypointIndex]->getModelingTransformation());
+		}
+
+		arrays.positionX[i] = position.x;
+		arrays.positionY[i] = position.y;
+		arrays.positionZ[i] = position.z;
+		arrays.targetX[i] = target.x;
+		arrays.targetY[i] = target.y;
+		arrays.targetZ[i] = target.z;
+
+		arrays.timeStep[i] = updated ? deltaTime : 0.0f;
+	}
+
+	int steered = SteerFollowersSIMD(count);
+
+	SteerFollowers(steered, count);
+
+	// Write the new transforms back. Followers usually share a parent, so its
+	// inverse world transform is only recomputed when the parent changes.
+	GameObject* parent = nullptr;
+	mat4 parentInverse(1.0f);
+
+	for (int i = 0; i < count; i++) {
+
+		// The transforms of followers that did not take a step are left as they are
+		if (arrays.timeStep[i] == 0.0f) {
+			continue;
+		}
+
+		GameObject* object = followers[i]->owningGameObject;
+
+		if (object->parent != parent) {
+
+			parent = object->parent;
+			parentInverse = (parent != nullptr) ? glm::inverse(parent->getWorldTransform()) : mat4(1.0f);
+		}
+
+		float ch = arrays.cosYaw[i], sh = arrays.sinYaw[i];
+		float cp = arrays.cosPitch[i], sp = arrays.sinPitch[i];
+		float cb = arrays.cosRoll[i], sb = arrays.sinRoll[i];
+
+		// Same as glm::yawPitchRoll with the position in the last column
+		mat4 world;
+		world[0] = vec4(ch * cb + sh * sp * sb, sb * cp, -sh * cb + ch * sp * sb, 0.0f);
+		world[1] = vec4(-ch * sb + sh * sp * cb, cb * cp, sb * sh + ch * sp * cb, 0.0f);
+		world[2] = vec4(sh * cp, -sp, ch * cp, 0.0f);
+		world[3] = vec4(arrays.positionX[i], arrays.positionY[i], arrays.positionZ[i], 1.0f);
+
+		object->localTransform = parentInverse * world;
+		object->transformChanged();
+	}
+
+} // end UpdateFollowers
+
+
+void SteeringEngine::SteerFollowers(int begin, int end)
+{
+	FollowerArrays& arrays = followerArrays;
+
+	for (int i = begin; i < end; i++) {
+
+		float dt = arrays.timeStep[i];
+
+		// Figure out direction to next waypoint
+		float dx = arrays.targetX[i] - arrays.positionX[i];
+		float dy = arrays.targetY[i] - arrays.positionY[i];
+		float dz = arrays.targetZ[i] - arrays.positionZ[i];
+
+		float currentYaw = arrays.yaw[i];
+		float desiredYaw = approxAtan2(-dx, -dz);
+		float desiredPitch = approxAtan2(dy, sqrt(dx * dx + dz * dz));
+
+		// Account for the "branch cut" in yaw angles
+		if (fabs(currentYaw - desiredYaw) > PI) {
+
+			if (currentYaw < desiredYaw) {
+				currentYaw += TWO_PI;
+			}
+			else {
+				desiredYaw += TWO_PI;
+			}
+		}
+
+		// Bank into the turn and interpolate towards the desired angles
+		float roll = arrays.roll[i] + (currentYaw - desiredYaw - arrays.roll[i]) * dt;
+		float yaw = currentYaw + (desiredYaw - currentYaw) * dt;
+		float pitch = arrays.pitch[i] + (desiredPitch - arrays.pitch[i]) * dt * 0.5f;
+
+		if (yaw > PI) {
+			yaw -= TWO_PI;
+		}
+
+		arrays.yaw[i] = yaw;
+		arrays.pitch[i] = pitch;
+		arrays.roll[i] = roll;
+
+		arrays.sinYaw[i] = approxSin(yaw);
+		arrays.cosYaw[i] = approxCos(yaw);
+		arrays.sinPitch[i] = approxSin(pitch);
+		arrays.cosPitch[i] = approxCos(pitch);
+		arrays.sinRoll[i] = approxSin(-roll);
+		arrays.cosRoll[i] = approxCos(-roll);
+
+		// Move along the new facing direction
+		float distance = arrays.speed[i] * dt;
+		arrays.positionX[i] -= arrays.cosPitch[i] * arrays.sinYaw[i] * distance;
+		arrays.positionY[i] += arrays.sinPitch[i] * distance;
+		arrays.positionZ[i] -= arrays.cosPitch[i] * arrays.cosYaw[i] * distance;
+	}
+
+} // end SteerFollowers
+
+
+int SteeringEngine::SteerFollowersSIMD(int count)
+{
+#ifdef STEERING_SSE2
+
+	FollowerArrays& arrays = followerArrays;
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	const __m128 pi = _mm_set1_ps(PI);
+	const __m128 twoPi = _mm_set1_ps(TWO_PI);
+
+	int i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+
+		__m128 dt = _mm_loadu_ps(&arrays.timeStep[i]);
+
+		__m128 positionX = _mm_loadu_ps(&arrays.positionX[i]);
+		__m128 positionY = _mm_loadu_ps(&arrays.positionY[i]);
+		__m128 positionZ = _mm_loadu_ps(&arrays.positionZ[i]);
+
+		// Figure out direction to next waypoint
+		__m128 dx = _mm_sub_ps(_mm_loadu_ps(&arrays.targetX[i]), positionX);
+		__m128 dy = _mm_sub_ps(_mm_loadu_ps(&arrays.targetY[i]), positionY);
+		__m128 dz = _mm_sub_ps(_mm_loadu_ps(&arrays.targetZ[i]), positionZ);
+
+		__m128 currentYaw = _mm_loadu_ps(&arrays.yaw[i]);
+		__m128 desiredYaw = approxAtan2(_mm_sub_ps(zero, dx), _mm_sub_ps(zero, dz));
+		__m128 desiredPitch = approxAtan2(dy, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dz, dz))));
+
+		// Account for the "branch cut" in yaw angles
+		__m128 crossesCut = _mm_cmpgt_ps(_mm_andnot_ps(signMask, _mm_sub_ps(currentYaw, desiredYaw)), pi);
+		__m128 currentIsLess = _mm_cmplt_ps(currentYaw, desiredYaw);
+
+		currentYaw = _mm_add_ps(currentYaw, _mm_and_ps(_mm_and_ps(crossesCut, currentIsLess), twoPi));
+		desiredYaw = _mm_add_ps(desiredYaw, _mm_and_ps(_mm_andnot_ps(currentIsLess, crossesCut), twoPi));
+
+		// Bank into the turn and interpolate towards the desired angles
+		__m128 roll = _mm_loadu_ps(&arrays.roll[i]);
+		roll = _mm_add_ps(roll, _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(currentYaw, desiredYaw), roll), dt));
+
+		__m128 yaw = _mm_add_ps(currentYaw, _mm_mul_ps(_mm_sub_ps(desiredYaw, currentYaw), dt));
+
+		__m128 pitch = _mm_loadu_ps(&arrays.pitch[i]);
+		pitch = _mm_add_ps(pitch, _mm_mul_ps(_mm_sub_ps(desiredPitch, pitch), _mm_mul_ps(dt, _mm_set1_ps(0.5f))));
+
+		yaw = select(_mm_cmpgt_ps(yaw, pi), _mm_sub_ps(yaw, twoPi), yaw);
+
+		_mm_storeu_ps(&arrays.yaw[i], yaw);
+		_mm_storeu_ps(&arrays.pitch[i], pitch);
+		_mm_storeu_ps(&arrays.roll[i], roll);
+
+		__m128 sinYaw = approxSin(yaw);
+		__m128 cosYaw = approxCos(yaw);
+		__m128 sinPitch = approxSin(pitch);
+		__m128 cosPitch = approxCos(pitch);
+		__m128 bank = _mm_sub_ps(zero, roll);
+
+		_mm_storeu_ps(&arrays.sinYaw[i], sinYaw);
+		_mm_storeu_ps(&arrays.cosYaw[i], cosYaw);
+		_mm_storeu_ps(&arrays.sinPitch[i], sinPitch);
+		_mm_storeu_ps(&arrays.cosPitch[i], cosPitch);
+		_mm_storeu_ps(&arrays.sinRoll[i], approxSin(bank));
+		_mm_storeu_ps(&arrays.cosRoll[i], approxCos(bank));
+
+		// Move along the new facing direction
+		__m128 distance = _mm_mul_ps(_mm_loadu_ps(&arrays.speed[i]), dt);
+		__m128 horizontal = _mm_mul_ps(cosPitch, distance);
+
+		_mm_storeu_ps(&arrays.positionX[i], _mm_sub_ps(positionX, _mm_mul_ps(horizontal, sinYaw)));
+		_mm_storeu_ps(&arrays.positionY[i], _mm_add_ps(positionY, _mm_mul_ps(sinPitch, distance)));
+		_mm_storeu_ps(&arrays.positionZ[i], _mm_sub_ps(positionZ, _mm_mul_ps(horizontal, cosYaw)));
+	}
+
+	return i;
+
+#else
+
+	return 0;
+
+#endif // STEERING_SSE2
+
+} // end SteerFollowersSIMD
+
+
+void SteeringEngine::AddFollower(SteeringComponent* follower)
+{
+	if (follower->followerIndex >= 0) {
+		return;
+	}
+
+	follower->followerIndex = static_cast<int>(followers.size());
+	followers.push_back(follower);
+
+	// Start from the current orientation of the game object
+	vec3 facingDirection = follower->owningGameObject->getFowardDirection(WORLD);
+
+	followerArrays.yaw.push_back(atan2(-facingDirection.x, -facingDirection.z));
+	followerArrays.pitch.push_back(atan2(facingDirection.y, sqrt(facingDirection.x * facingDirection.x +
+																 facingDirection.z * facingDirection.z)));
+	followerArrays.roll.push_back(0.0f);
+	followerArrays.speed.push_back(follower->speed);
+
+} // end AddFollower
+
+
+void SteeringEngine::RemoveFollower(SteeringComponent* follower)
+{
+	int index = follower->followerIndex;
+
+	if (index < 0 || index >= static_cast<int>(followers.size())) {
+		return;
+	}
+
+	// Move the last follower into the empty slot. Only the state that persists
+	// between frames needs to be moved.
+	int last = static_cast<int>(followers.size()) - 1;
+
+	followers[index] = followers[last];
+	followers[index]->followerIndex = index;
+	followers.pop_back();
+
+	for (std::vector<float>* array : { &followerArrays.yaw, &followerArrays.pitch,
+									   &followerArrays.roll, &followerArrays.speed }) {
+		(*array)[index] = (*array)[last];
+		array->pop_back();
+	}
+
+	follower->followerIndex = -1;
+
+} // end RemoveFollower
+
+
+void SteeringEngine::AddAgent(FlockingComponent* agent)
+{
+	if (agent->agentId >= 0) {
+		return;
+	}
+
+	agent->agentId = static_cast<int>(agents.size());
+
+	agents.push_back(agent);
+	agentPositions.push_back(agent->owningGameObject->getPosition(WORLD));
+	agentVelocities.push_back(agent->getVelocity());
+
+} // end AddAgent
+
+
+void SteeringEngine::RemoveAgent(FlockingComponent* agent)
+{
+	if (agent->agentId >= 0 && agent->agentId < static_cast<int>(agents.size())) {
+
+		agents[agent->agentId] = nullptr;
+	}
+
+	agent->agentId = -1;
+
+} // end RemoveAgent
+
+
+void SteeringEngine::QueryAgents(const vec3& position, float radius, std::vector<FlockingComponent*>& results)
+{
+	ForEachNeighbor(position, radius, [&results](int id) {
+
+		results.push_back(agents[id]);
+		return true;
+	});
+
+} // end QueryAgents
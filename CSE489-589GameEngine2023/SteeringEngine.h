@@ -0,0 +1,252 @@
+#pragma once
+
+#include "MathLibsConstsFuncs.h"
+#include "SpatialHashGrid.h"
+
+using namespace constants_and_types;
+
+class FlockingComponent;
+class SteeringComponent;
+
+/**
+ * @class	SteeringEngine
+ *
+ * @brief	Keeps track of the steering agents in the game. Once each frame the
+ * 			world positions and velocities of all agents are copied into arrays
+ * 			and a spatial hash grid is built from the positions. Agents then find
+ * 			their neighbours by looking up the grid and reading the arrays instead
+ * 			of walking the scene graph. Every agent sees the same snapshot, so the
+ * 			result does not depend on the order in which the agents update.
+ *
+ * 			The engine also steers all SteeringComponents. Their headings and
+ * 			speeds are kept in structure of arrays form and advanced four at a
+ * 			time with SSE2. The new transforms are then written back to the game
+ * 			objects in a single pass.
+ */
+class SteeringEngine
+{
+public:
+
+	/**
+	 * @fn	static void SteeringEngine::Update(const float& deltaTime = 0.0f);
+	 *
+	 * @brief	Takes a snapshot of the agents, rebuilds the grid, and steers the
+	 * 			waypoint followers. Call once each frame before the game objects
+	 * 			are updated.
+	 *
+	 * @param	deltaTime	(Optional) Time in seconds since the last update.
+	 */
+	static void Update(const float& deltaTime = 0.0f);
+
+	/**
+	 * @fn	static void SteeringEngine::AddAgent(FlockingComponent* agent);
+	 *
+	 * @brief	Adds an agent. It is visible to neighbour queries after the next update.
+	 *
+	 * @param [in]	agent	The agent.
+	 */
+	static void AddAgent(FlockingComponent* agent);
+
+	/**
+	 * @fn	static void SteeringEngine::RemoveAgent(FlockingComponent* agent);
+	 *
+	 * @brief	Removes an agent. Its slot is cleared immediately and reused
+	 * 			after the next update, so the ids of the other agents do not
+	 * 			change until then.
+	 *
+	 * @param [in]	agent	The agent.
+	 */
+	static void RemoveAgent(FlockingComponent* agent);
+
+	/**
+	 * @fn	static void SteeringEngine::AddFollower(SteeringComponent* follower);
+	 *
+	 * @brief	Adds a waypoint follower. Its heading is taken from the current
+	 * 			orientation of its game object.
+	 *
+	 * @param [in]	follower	The follower.
+	 */
+	static void AddFollower(SteeringComponent* follower);
+
+	/**
+	 * @fn	static void SteeringEngine::RemoveFollower(SteeringComponent* follower);
+	 *
+	 * @brief	Removes a waypoint follower.
+	 *
+	 * @param [in]	follower	The follower.
+	 */
+	static void RemoveFollower(SteeringComponent* follower);
+
+	/**
+	 * @fn	static int SteeringEngine::GetNumFollowers()
+	 *
+	 * @brief	Gets the number of waypoint followers.
+	 */
+	static int GetNumFollowers() { return static_cast<int>(followers.size()); }
+
+	/**
+	 * @fn	static void SteeringEngine::QueryAgents(const vec3& position, float radius, std::vector<FlockingComponent*>& results);
+	 *
+	 * @brief	Finds the agents that were within a radius of a position at the
+	 * 			last update.
+	 *
+	 * @param 		  	position	Center of the query sphere in world coordinates.
+	 * @param 		  	radius  	Radius of the query sphere.
+	 * @param [in,out]	results 	The agents are appended to this vector.
+	 */
+	static void QueryAgents(const vec3& position, float radius, std::vector<FlockingComponent*>& results);
+
+	/**
+	 * @fn	template<typename Callback> static void SteeringEngine::ForEachNeighbor(const vec3& position, float radius, Callback callback)
+	 *
+	 * @brief	Calls callback(id) for each agent that was within a radius of a
+	 * 			position at the last update. Use the id to read the position and
+	 * 			velocity of the agent. Returning false from the callback ends the
+	 * 			query early.
+	 *
+	 * @param	position	Center of the query sphere in world coordinates.
+	 * @param	radius  	Radius of the query sphere.
+	 * @param	callback	Called with the id of each agent.
+	 */
+	template<typename Callback>
+	static void ForEachNeighbor(const vec3& position, float radius, Callback callback)
+	{
+		grid.forEachInRadius(position, radius, [&callback](int id, const vec3& neighborPosition) {
+
+			// Agents removed since the last update leave an empty slot
+			return agents[id] == nullptr || callback(id);
+		});
+
+	} // end ForEachNeighbor
+
+	/**
+	 * @fn	static const vec3& SteeringEngine::GetAgentPosition(int id)
+	 *
+	 * @brief	Gets the world position of an agent at the last update.
+	 */
+	static const vec3& GetAgentPosition(int id) { return agentPositions[id]; }
+
+	/**
+	 * @fn	static const vec3& SteeringEngine::GetAgentVelocity(int id)
+	 *
+	 * @brief	Gets the world velocity of an agent at the last update.
+	 */
+	static const vec3& GetAgentVelocity(int id) { return agentVelocities[id]; }
+
+	/**
+	 * @fn	static int SteeringEngine::GetNumAgents()
+	 *
+	 * @brief	Gets the number of agent slots including the empty ones.
+	 */
+	static int GetNumAgents() { return static_cast<int>(agents.size()); }
+
+	/**
+	 * @fn	static double SteeringEngine::GetLastUpdateTime()
+	 *
+	 * @brief	Gets the wall clock time taken by the last call to Update.
+	 *
+	 * @returns	Time in seconds.
+	 */
+	static double GetLastUpdateTime() { return lastUpdateTime; }
+
+	/**
+	 * @fn	static unsigned long long SteeringEngine::GetUpdateCount()
+	 *
+	 * @brief	Gets the number of times Update has been called.
+	 */
+	static unsigned long long GetUpdateCount() { return updateCount; }
+
+protected:
+
+	/**
+	 * @fn	static void SteeringEngine::UpdateAgents();
+	 *
+	 * @brief	Copies the positions and velocities of the flocking agents into
+	 * 			arrays and rebuilds the grid.
+	 */
+	static void UpdateAgents();
+
+	/**
+	 * @fn	static void SteeringEngine::UpdateFollowers(float deltaTime);
+	 *
+	 * @brief	Reads the positions and targets of the waypoint followers, steers
+	 * 			them, and writes the new transforms to their game objects.
+	 *
+	 * @param	deltaTime	Time in seconds since the last update.
+	 */
+	static void UpdateFollowers(float deltaTime);
+
+	/**
+	 * @fn	static bool SteeringEngine::IsUpdated(const GameObject* gameObject);
+	 *
+	 * @brief	Checks whether a game object and all of its ancestors are ACTIVE.
+	 * 			GameObject::update skips the descendants of a game object that
+	 * 			is not.
+	 */
+	static bool IsUpdated(const class GameObject* gameObject);
+
+	/**
+	 * @fn	static void SteeringEngine::SteerFollowers(int begin, int end);
+	 *
+	 * @brief	Turns and moves a range of followers one at a time. Used for the
+	 * 			followers left over after the SIMD batches, and for all of them
+	 * 			where SSE2 is not available.
+	 *
+	 * @param	begin	Index of the first follower.
+	 * @param	end  	One past the index of the last follower.
+	 */
+	static void SteerFollowers(int begin, int end);
+
+	/**
+	 * @fn	static int SteeringEngine::SteerFollowersSIMD(int count);
+	 *
+	 * @brief	Turns and moves the followers four at a time.
+	 *
+	 * @param	count	Number of followers.
+	 *
+	 * @returns	Number of followers that were steered. The rest are left for SteerFollowers.
+	 */
+	static int SteerFollowersSIMD(int count);
+
+	/**
+	 * @struct	FollowerArrays
+	 *
+	 * @brief	State of the waypoint followers in structure of arrays form. The
+	 * 			heading angles and speed persist between frames. Positions and
+	 * 			targets are read from the scene graph each frame. The time step
+	 * 			is zero for paused followers. The sines and cosines are outputs
+	 * 			used to build the rotations. The roll sine and cosine are of the
+	 * 			bank angle passed to glm::yawPitchRoll, which is minus the roll.
+	 */
+	struct FollowerArrays
+	{
+		std::vector<float> positionX, positionY, positionZ;
+		std::vector<float> targetX, targetY, targetZ;
+		std::vector<float> yaw, pitch, roll, speed;
+		std::vector<float> timeStep;
+		std::vector<float> sinYaw, cosYaw, sinPitch, cosPitch, sinRoll, cosRoll;
+
+		void resize(size_t size);
+	};
+
+	/** @brief	Waypoint followers. The index of each one is its index in the arrays. */
+	static std::vector<SteeringComponent*> followers;
+	static FollowerArrays followerArrays;
+
+	/** @brief	Agents indexed by id. Removed agents leave a null slot until the next update. */
+	static std::vector<FlockingComponent*> agents;
+
+	/** @brief	World positions and velocities of the agents at the last update. */
+	static std::vector<vec3> agentPositions;
+	static std::vector<vec3> agentVelocities;
+
+	/** @brief	Grid built from the agent positions. The cell size follows the
+	 * 			largest neighbour radius of the agents.
+	 */
+	static SpatialHashGrid grid;
+
+	/** @brief	Time taken by the last call to Update. */
+	static double lastUpdateTime;
+	static unsigned long long updateCount;
+
+}; // end SteeringEngine class
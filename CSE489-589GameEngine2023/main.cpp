@@ -1,8 +1,75 @@
 #include "Project3.h"
+#include "PhysicsBenchmark.h"
+#include "AudioBenchmark.h"
+#include "FlockingBenchmark.h"
+#include "SteeringBenchmark.h"
 
+#include <cstring>
+#include <cstdlib>
 
-int main( )
+
+int main(int argc, char* argv[])
 {
+	// Run the physics benchmark scene instead of the project.
+	// Usage: physics-benchmark [threads]. Zero threads runs single threaded.
+	if (argc > 1 && strcmp(argv[1], "physics-benchmark") == 0) {
+
+		int numThreads = (argc > 2) ? atoi(argv[2]) : 0;
+
+		PhysicsBenchmark benchmark(numThreads > 0, numThreads);
+		benchmark.runGame();
+
+		return 0;
+	}
+
+	// Measure snapshot and restore of the deterministic simulation.
+	// Usage: snapshot-benchmark [bodies]
+	if (argc > 1 && strcmp(argv[1], "snapshot-benchmark") == 0) {
+
+		int numBodies = (argc > 2) ? atoi(argv[2]) : 1000;
+
+		PhysicsBenchmark benchmark(false, 1, numBodies, true);
+		benchmark.runGame();
+
+		return 0;
+	}
+
+	// Mix many moving sounds offline and report the time spent mixing.
+	// Usage: audio-benchmark [sounds]
+	if (argc > 1 && strcmp(argv[1], "audio-benchmark") == 0) {
+
+		int numSounds = (argc > 2) ? atoi(argv[2]) : 256;
+
+		AudioBenchmark benchmark(numSounds);
+		benchmark.runGame();
+
+		return 0;
+	}
+
+	// Steer a large flock using spatial hash neighbour queries.
+	// Usage: flocking-benchmark [agents]
+	if (argc > 1 && strcmp(argv[1], "flocking-benchmark") == 0) {
+
+		int numAgents = (argc > 2) ? atoi(argv[2]) : 10000;
+
+		FlockingBenchmark benchmark(numAgents);
+		benchmark.runGame();
+
+		return 0;
+	}
+
+	// Fly many craft through a loop of waypoints with batched steering.
+	// Usage: steering-benchmark [followers]
+	if (argc > 1 && strcmp(argv[1], "steering-benchmark") == 0) {
+
+		int numFollowers = (argc > 2) ? atoi(argv[2]) : 5000;
+
+		SteeringBenchmark benchmark(numFollowers);
+		benchmark.runGame();
+
+		return 0;
+	}
+
 	// Instantiate an object of the Game class
 	Project3 game;
 
@@ -11,4 +78,4 @@ int main( )
 
 	return 0;
 
-} // end main
\ No newline at end of file
+} // end main